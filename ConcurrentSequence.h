@@ -0,0 +1,300 @@
+#ifndef CONCURRENTSEQUENCE_H
+#define CONCURRENTSEQUENCE_H
+
+#include <cstddef> // For size_t
+#include <stdexcept> // std::out_of_range
+#include <mutex> // std::mutex, std::scoped_lock
+#include <shared_mutex> // std::shared_mutex, std::shared_lock
+#include <utility> // std::move, std::forward
+#include <iterator> // std::make_move_iterator
+#include <vector> // append staging buffer
+#include "Sequence.h"
+
+/**
+ * Thread-safe sequence of T built on BasicSequence.
+ *
+ * Locking is split so producers do not wait behind readers or positional
+ * edits, and readers do not wait behind copies:
+ *  - appendLock guards a small staging buffer. push_back and emplace_back
+ *    only take this lock, and pop_back takes it first and is served from
+ *    the buffer when it has elements.
+ *  - listLock (a reader/writer lock) guards the sequence itself. Positional
+ *    operations take it exclusively and first move the staged elements to
+ *    the end of the sequence (flush), so they always see every append that
+ *    finished before them. at, for_each and size share it, and read
+ *    appends still staged from the buffer.
+ *
+ * snapshot() is O(1): the copy shares the sequence's blocks. The first
+ * change after a snapshot gives the live sequence block headers of its own,
+ * O(n / CAPACITY), and each later change copies only the block it writes
+ * to while a snapshot still reads it, so writers stay short under the
+ * exclusive lock while every snapshot keeps reading the old elements.
+ *
+ * Locks are always taken in the order listLock, appendLock.
+ *
+ * The position index makes insert/erase O(log n) under one short exclusive
+ * lock. That replaces hand-over-hand locking, which cannot work here: the
+ * per-node counts of every ancestor change on each insert and erase.
+ *
+ * @tparam T Element type.
+ * @tparam Alloc Allocator of the underlying sequence.
+ */
+template<class T, class Alloc = std::allocator<T>>
+class BasicConcurrentSequence {
+private:
+    using Staging = std::vector<T, typename std::allocator_traits<Alloc>::template rebind_alloc<T>>;
+
+    mutable std::shared_mutex listLock; // guards items
+    BasicSequence<T, Alloc> items; // everything flushed so far
+    mutable std::mutex appendLock; // guards staged
+    Staging staged; // appends not yet moved into items, in order
+
+    void flush(); // Moves staged elements into items; needs listLock held exclusively
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+
+    explicit BasicConcurrentSequence(const Alloc &alloc = Alloc()); // Empty sequence
+    BasicConcurrentSequence(const BasicConcurrentSequence &) = delete; // share it, or copy a snapshot()
+    BasicConcurrentSequence &operator=(const BasicConcurrentSequence &) = delete;
+
+    void push_back(T element); // Appends an element.
+    template<class... Args>
+    void emplace_back(Args &&... args); // Constructs an element at the end.
+    bool try_pop_back(T &out); // Removes the last element into out, if there is one.
+    bool try_pop_front(T &out); // Removes the first element into out, if there is one.
+    void insert(size_t position, T element); // Inserts an element at the given position.
+    void erase(size_t position); // Removes the element at the given position.
+    T at(size_t position) const; // Returns a copy of the element at the given position.
+    void clear(); // Removes every element.
+
+    BasicSequence<T, Alloc> snapshot(); // Copies the current contents in O(1).
+    template<class Fn>
+    void for_each(Fn fn) const; // Calls fn on every element while holding a read lock.
+    size_t size() const; // Returns the number of elements.
+    bool empty() const; // Checks if the sequence is empty.
+};
+
+/**
+ * The string version, matching Sequence.
+ */
+using ConcurrentSequence = BasicConcurrentSequence<std::string>;
+
+/**
+ * Constructs an empty concurrent sequence.
+ *
+ * @param alloc Allocator for the underlying sequence and staging buffer.
+ */
+template<class T, class Alloc>
+BasicConcurrentSequence<T, Alloc>::BasicConcurrentSequence(const Alloc &alloc)
+    : items(0, alloc), staged(alloc) {
+}
+
+/**
+ * Moves every staged append to the end of the sequence. The caller must
+ * hold listLock exclusively.
+ */
+template<class T, class Alloc>
+void BasicConcurrentSequence<T, Alloc>::flush() {
+    Staging batch(staged.get_allocator());
+    {
+        std::scoped_lock lock(appendLock);
+        batch.swap(staged); // producers continue on an empty buffer
+    }
+    if (!batch.empty()) { // appending nothing would still unshare the blocks
+        items.append(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+    }
+}
+
+/**
+ * Appends an element. Only the staging lock is taken.
+ *
+ * @param item The element to append.
+ */
+template<class T, class Alloc>
+void BasicConcurrentSequence<T, Alloc>::push_back(T item) {
+    std::scoped_lock lock(appendLock);
+    staged.push_back(std::move(item));
+}
+
+/**
+ * Constructs an element at the end. Only the staging lock is taken.
+ *
+ * @param args Arguments forwarded to the constructor of T.
+ */
+template<class T, class Alloc>
+template<class... Args>
+void BasicConcurrentSequence<T, Alloc>::emplace_back(Args &&... args) {
+    std::scoped_lock lock(appendLock);
+    staged.emplace_back(std::forward<Args>(args)...);
+}
+
+/**
+ * Removes the last element. It comes straight from the staging buffer when
+ * that is not empty, without touching listLock.
+ *
+ * @param out Receives the removed element.
+ * @return false if the sequence was empty.
+ */
+template<class T, class Alloc>
+bool BasicConcurrentSequence<T, Alloc>::try_pop_back(T &out) {
+    {
+        std::scoped_lock lock(appendLock);
+        if (!staged.empty()) {
+            out = std::move(staged.back());
+            staged.pop_back();
+            return true;
+        }
+    }
+
+    std::unique_lock lock(listLock);
+    flush(); // something may have been staged since the check above
+    if (items.empty()) {
+        return false;
+    }
+    out = std::move(items.back()); // copies the tail block first if a snapshot reads it
+    items.pop_back();
+    return true;
+}
+
+/**
+ * Removes the first element.
+ *
+ * @param out Receives the removed element.
+ * @return false if the sequence was empty.
+ */
+template<class T, class Alloc>
+bool BasicConcurrentSequence<T, Alloc>::try_pop_front(T &out) {
+    std::unique_lock lock(listLock);
+    if (items.empty()) {
+        flush();
+        if (items.empty()) {
+            return false;
+        }
+    }
+    out = std::move(items.front()); // copies the head block first if a snapshot reads it
+    items.pop_front();
+    return true;
+}
+
+/**
+ * Inserts an element at position, counting every append that finished
+ * before the call.
+ *
+ * @param position Index the new element will have.
+ * @param item The element to insert.
+ * @throws std::out_of_range if position > size()
+ */
+template<class T, class Alloc>
+void BasicConcurrentSequence<T, Alloc>::insert(size_t position, T item) {
+    std::unique_lock lock(listLock);
+    flush();
+    items.insert(position, std::move(item));
+}
+
+/**
+ * Removes the element at position.
+ *
+ * @param position Index of the element to remove.
+ * @throws std::out_of_range if position >= size()
+ */
+template<class T, class Alloc>
+void BasicConcurrentSequence<T, Alloc>::erase(size_t position) {
+    std::unique_lock lock(listLock);
+    flush();
+    items.erase(position);
+}
+
+/**
+ * Returns a copy of the element at position; a reference could be
+ * invalidated by another thread as soon as the lock is dropped. Only the
+ * read lock is taken: lookups through the const sequence may run side by
+ * side, and positions past the flushed elements are read from the staging
+ * buffer.
+ *
+ * @param position Index of the element.
+ * @return Copy of the element.
+ * @throws std::out_of_range if position >= size()
+ */
+template<class T, class Alloc>
+T BasicConcurrentSequence<T, Alloc>::at(size_t position) const {
+    std::shared_lock lock(listLock);
+    if (position < items.size()) {
+        return items[position];
+    }
+    std::scoped_lock appendGuard(appendLock);
+    if (position - items.size() >= staged.size()) {
+        throw std::out_of_range("Position is out of range");
+    }
+    return staged[position - items.size()];
+}
+
+/**
+ * Removes every element, staged ones included.
+ */
+template<class T, class Alloc>
+void BasicConcurrentSequence<T, Alloc>::clear() {
+    std::unique_lock lock(listLock);
+    std::scoped_lock appendGuard(appendLock);
+    staged.clear();
+    items.clear();
+}
+
+/**
+ * Returns a copy of the current contents that the caller owns and can
+ * iterate without any locking. The copy shares the sequence's blocks, so
+ * this takes O(1) under the lock (plus moving staged appends in). Iterate
+ * it as const: non-const access would copy the blocks for the snapshot.
+ *
+ * @return Copy of every element, in order.
+ */
+template<class T, class Alloc>
+BasicSequence<T, Alloc> BasicConcurrentSequence<T, Alloc>::snapshot() {
+    std::unique_lock lock(listLock); // flush() moves staged appends into items
+    flush();
+    return items;
+}
+
+/**
+ * Calls fn on every element in order while holding the read lock, without
+ * copying. fn must not call back into this sequence.
+ *
+ * @param fn Callable taking const T&.
+ */
+template<class T, class Alloc>
+template<class Fn>
+void BasicConcurrentSequence<T, Alloc>::for_each(Fn fn) const {
+    std::shared_lock lock(listLock);
+    for (const T &item : items) {
+        fn(item);
+    }
+    std::scoped_lock appendGuard(appendLock);
+    for (const T &item : staged) {
+        fn(item);
+    }
+}
+
+/**
+ * Returns the number of elements, staged ones included.
+ *
+ * @return Number of elements.
+ */
+template<class T, class Alloc>
+size_t BasicConcurrentSequence<T, Alloc>::size() const {
+    std::shared_lock lock(listLock);
+    std::scoped_lock appendGuard(appendLock);
+    return items.size() + staged.size();
+}
+
+/**
+ * Checks if the sequence is empty.
+ *
+ * @return true if there are no elements.
+ */
+template<class T, class Alloc>
+bool BasicConcurrentSequence<T, Alloc>::empty() const {
+    return size() == 0;
+}
+
+#endif
@@ -4,63 +4,696 @@
 #include <string>
 #include <cstddef> // For size_t
 #include <stdexcept> // exceptions
+#include <utility> // std::move, std::forward
+#include <new> // placement new, std::launder
+#include <cstring> // std::memcpy, std::memmove
+#include <memory> // std::allocator, std::allocator_traits
+#include <type_traits> // trivially copyable fast paths
+#include <ostream> // std::ostream
+#include <istream> // std::istream for load
+#include <iterator> // std::input_iterator
+#include <initializer_list> // append({...})
+#include <ranges> // assign(range)
+#include <vector> // block lists for parallel copy and teardown
+#include <thread> // worker threads
+#include <future> // std::future for clearAsync
+#include <exception> // std::exception_ptr
+#include <atomic> // share counts
+#include <algorithm> // std::stable_sort, std::is_sorted, std::reverse
+#include <functional> // std::less, std::equal_to, std::hash
+#include <compare> // operator<=>
+#include <cerrno> // EINTR
+#include "SequencePool.h"
+#include "SequenceProfile.h"
+#include "SequenceFormat.h"
+#include "SequenceIndex.h"
+#include "SequenceHash.h"
+
+#if __has_include(<unistd.h>)
+#include <unistd.h> // ::write for print(fd)
+#define SEQUENCE_HAS_UNISTD 1
+#else
+#define SEQUENCE_HAS_UNISTD 0
+#endif
+
+/**
+ * Process-wide settings for the passes a sequence splits across threads:
+ * copying, teardown and sorting. Sequences under minElements() are handled
+ * on the calling thread; larger ones use up to maxWorkers() threads with
+ * at least minElements() / 2 elements each. The defaults keep thread
+ * start-up cheap next to the work; tests lower them to reach the parallel
+ * paths with small sequences.
+ */
+class SequenceParallelism {
+public:
+    static constexpr size_t DEFAULT_MIN_ELEMENTS = size_t(1) << 16; // smaller sequences stay on one thread
+
+private:
+    static inline std::atomic<size_t> threshold{DEFAULT_MIN_ELEMENTS};
+    static inline std::atomic<unsigned> workers{0}; // 0: one per core
+
+public:
+    /**
+     * Changes the settings for passes that start afterwards.
+     *
+     * @param minElements Smallest sequence split across threads, at least 2.
+     * @param maxWorkers Most threads per pass, the calling one included; 0
+     * for one per core.
+     */
+    static void set(size_t minElements, unsigned maxWorkers) {
+        threshold.store(minElements < 2 ? 2 : minElements, std::memory_order_relaxed);
+        workers.store(maxWorkers, std::memory_order_relaxed);
+    }
+
+    static void reset() {
+        set(DEFAULT_MIN_ELEMENTS, 0);
+    } // Restores the defaults
+
+    static size_t minElements() {
+        return threshold.load(std::memory_order_relaxed);
+    } // Smallest sequence split across threads
+
+    static unsigned maxWorkers() {
+        const unsigned limit = workers.load(std::memory_order_relaxed);
+        const unsigned cores = std::thread::hardware_concurrency();
+        return limit != 0 ? limit : (cores == 0 ? 1 : cores);
+    } // Most threads per pass
+};
+
+/**
+ * Memory used by a sequence, as reported by BasicSequence::footprint().
+ */
+struct SequenceFootprint {
+    size_t elements = 0; // number of elements
+    size_t blocks = 0; // nodes in the list
+    size_t blockBytes = 0; // bytes of those nodes and their chunks of element slots
+    size_t reservedBytes = 0; // slab bytes the arena holds, used or not
+    size_t heapBytes = 0; // memory the elements own outside their slots
+
+    double bytesPerElement() const {
+        return elements == 0 ? 0.0 : static_cast<double>(reservedBytes + heapBytes) / static_cast<double>(elements);
+    } // everything held, per element
+};
+
+/**
+ * Heap memory an element owns beyond its own object, for footprint().
+ * Element types that own memory add an overload next to their definition;
+ * it is found by argument-dependent lookup.
+ *
+ * @return 0: by default an element owns nothing outside itself.
+ */
+template<class T>
+size_t sequenceHeapBytes(const T &) {
+    return 0;
+}
+
+/**
+ * Heap memory of a string: its buffer, unless the text fits in the small
+ * buffer inside the string object.
+ *
+ * @param s String to measure.
+ * @return Bytes of the heap buffer, or 0.
+ */
+template<class Char, class Traits, class StringAlloc>
+size_t sequenceHeapBytes(const std::basic_string<Char, Traits, StringAlloc> &s) {
+    const char *inside = reinterpret_cast<const char *>(&s);
+    const char *buffer = reinterpret_cast<const char *>(s.data());
+    if (buffer >= inside && buffer < inside + sizeof(s)) {
+        return 0;
+    }
+    return (s.capacity() + 1) * sizeof(Char);
+}
+
+/**
+ * The element slots of one block, kept apart from the block's links so
+ * that copies of a sequence can point their own blocks at the same slots.
+ * users counts the blocks, in any sequence, whose elements live here.
+ * While it is above one the slots are read only: a block about to change
+ * first copies its elements into a chunk of its own.
+ *
+ * @tparam T Element type.
+ */
+template<class T>
+class SequenceChunk {
+public:
+    // About 1KB of elements per block, but never fewer than 8
+    static constexpr size_t CAPACITY = sizeof(T) * 8 > 1024 ? 8 : 1024 / sizeof(T);
+
+    std::atomic<size_t> users; // blocks whose elements live in these slots
+    void *home; // arena of the sequence that allocated the chunk
+    alignas(T) unsigned char storage[CAPACITY * sizeof(T)]; // element slots
+
+    SequenceChunk() : users(1), home(nullptr) {
+    } // default constructor
+    SequenceChunk(const SequenceChunk &) = delete; // elements are copied by the sequence, one by one
+    SequenceChunk &operator=(const SequenceChunk &) = delete;
+
+    T *slots() {
+        return std::launder(reinterpret_cast<T *>(storage));
+    } // first element slot
+};
 
 /**
  * Represents *a* node in a doubly-linked list.
  *
- * Each node stores a string element and has pointers to the next and
- * previous nodes in the sequence.
+ * Each node stands for a block of up to CAPACITY elements (an unrolled list)
+ * and has pointers to the next and previous nodes in the sequence. The
+ * elements live in count contiguous raw slots of the node's chunk from slot
+ * start on, and only those are constructed. Only the head block keeps a
+ * nonzero start, so push_front and pop_front move it instead of shifting
+ * the elements. The same node is also a member of
+ * a position index (an implicit-key treap): left/right/parent links order
+ * the nodes exactly like next/prev, and leftWeight counts the elements in
+ * the left subtree so a position can be found by descending from the root.
+ *
+ * @tparam T Element type.
  */
+template<class T>
 class SequenceNode {
 public:
+    static constexpr size_t CAPACITY = SequenceChunk<T>::CAPACITY; // elements per block
+
     SequenceNode *next; // pointer to the next node
     SequenceNode *prev; // pointer to previous node
-    std::string element; // value stored
+    SequenceNode *parent; // parent in the position index
+    SequenceNode *left; // subtree of earlier elements
+    SequenceNode *right; // subtree of later elements
+    size_t leftWeight; // number of elements stored in the left subtree
+    size_t count; // number of elements stored in this block
+    size_t start; // slots before the first element; only the head's may be nonzero
+    unsigned priority; // heap key that keeps the index balanced
+    SequenceChunk<T> *chunk; // slots holding the elements, possibly shared with copies
+    void *home; // arena of the sequence that allocated the node
 
-    SequenceNode() : next(nullptr), prev(nullptr) {
+    SequenceNode() : next(nullptr), prev(nullptr), parent(nullptr), left(nullptr), right(nullptr),
+                     leftWeight(0), count(0), start(0), priority(0), chunk(nullptr), home(nullptr) {
     } // default constructor
-    SequenceNode(std::string element) : next(nullptr), prev(nullptr), element(element) {
-    } // constructor with params
+    SequenceNode(const SequenceNode &) = delete; // blocks are never copied whole
+    SequenceNode &operator=(const SequenceNode &) = delete;
+
+    T *elements() {
+        return chunk->slots() + start;
+    } // first element slot
+    const T *elements() const {
+        return chunk->slots() + start;
+    } // first element slot (read only)
+};
+
+template<class T, class Alloc>
+class BasicSequence;
+
+/**
+ * Bidirectional iterator over a BasicSequence. It names an element by its
+ * block and its slot inside the block, so stepping is O(1) and follows the
+ * next/prev links. end() is the slot one past the last element of the tail
+ * block.
+ *
+ * Like a vector's iterators, these are invalidated by any change to the
+ * block they point into (insert, erase, and push_back/pop_back for end()).
+ *
+ * @tparam T Element type.
+ * @tparam Const true for a const_iterator.
+ */
+template<class T, bool Const>
+class SequenceIterator {
+private:
+    using Node = std::conditional_t<Const, const SequenceNode<T>, SequenceNode<T>>;
+
+    Node *node; // block holding the element
+    size_t offset; // slot of the element inside node
+
+    SequenceIterator(Node *node, size_t offset) : node(node), offset(offset) {
+    } // constructor used by the sequence
+
+    template<class, class>
+    friend class BasicSequence;
+    friend class SequenceIterator<T, !Const>;
+
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using iterator_concept = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T *, T *>;
+    using reference = std::conditional_t<Const, const T &, T &>;
+
+    SequenceIterator() : node(nullptr), offset(0) {
+    } // default constructor (singular iterator)
+    template<bool Other> requires (Const && !Other)
+    SequenceIterator(const SequenceIterator<T, Other> &it) : node(it.node), offset(it.offset) {
+    } // iterator -> const_iterator
+
+    reference operator*() const {
+        return node->elements()[offset];
+    }
+    pointer operator->() const {
+        return node->elements() + offset;
+    }
+
+    SequenceIterator &operator++() {
+        offset++;
+        if (offset == node->count && node->next != nullptr) {
+            node = node->next; // step over to the next block
+            offset = 0;
+        }
+        return *this;
+    }
+    SequenceIterator operator++(int) {
+        SequenceIterator old = *this;
+        ++*this;
+        return old;
+    }
+    SequenceIterator &operator--() {
+        if (offset == 0) {
+            node = node->prev; // step back to the previous block
+            offset = node->count;
+        }
+        offset--;
+        return *this;
+    }
+    SequenceIterator operator--(int) {
+        SequenceIterator old = *this;
+        --*this;
+        return old;
+    }
+
+    friend bool operator==(const SequenceIterator &a, const SequenceIterator &b) {
+        return a.node == b.node && a.offset == b.offset;
+    }
+};
+
+/**
+ * Read-only window onto a run of elements of a BasicSequence, returned by
+ * view(position, count). It holds two iterators and a length, so making
+ * one costs two position lookups and nothing is copied: iterating, front,
+ * back and operator<< read the sequence's blocks in place.
+ *
+ * A slice is invalidated by the same changes as the iterators it holds,
+ * and by the sequence going away. To keep the elements, copy them out
+ * (append(slice.begin(), slice.end())) or move them into a sequence of
+ * their own with extract(slice.position(), slice.size()).
+ *
+ * @tparam T Element type.
+ */
+template<class T>
+class SequenceSlice {
+private:
+    SequenceIterator<T, true> first; // first element of the slice
+    SequenceIterator<T, true> last; // one past the last element
+    size_t start; // position of first in the sequence
+    size_t length; // number of elements
+
+    SequenceSlice(SequenceIterator<T, true> first, SequenceIterator<T, true> last, size_t start, size_t length)
+        : first(first), last(last), start(start), length(length) {
+    } // constructor used by the sequence
+
+    template<class, class>
+    friend class BasicSequence;
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using iterator = SequenceIterator<T, true>;
+    using const_iterator = SequenceIterator<T, true>;
+
+    SequenceSlice() : start(0), length(0) {
+    } // empty slice
+
+    iterator begin() const {
+        return first;
+    }
+    iterator end() const {
+        return last;
+    }
+    size_t size() const {
+        return length;
+    } // Returns the number of elements in the slice.
+    bool empty() const {
+        return length == 0;
+    } // Checks if the slice has no elements.
+    size_t position() const {
+        return start;
+    } // Position of the first element in the sequence.
+
+    const T &front() const {
+        if (length == 0) {
+            throw std::out_of_range("Slice is empty");
+        }
+        return *first;
+    } // Returns the first element of the slice.
+    const T &back() const {
+        if (length == 0) {
+            throw std::out_of_range("Slice is empty");
+        }
+        iterator it = last;
+        return *--it;
+    } // Returns the last element of the slice.
+
+    /**
+     * Outputs the elements in the same "<a, b, c>" format as a sequence,
+     * reading them in place.
+     *
+     * @param os The output stream.
+     * @param slice The slice to print.
+     * @return Output stream object.
+     */
+    friend std::ostream &operator<<(std::ostream &os, const SequenceSlice &slice) {
+        os << "<";
+        for (iterator it = slice.first; it != slice.last; ++it) {
+            if (it != slice.first) {
+                os << ", ";
+            }
+            os << *it;
+        }
+        return os << ">";
+    }
 };
 
+template<class T, class Alloc>
+std::ostream &operator<<(std::ostream &os, const BasicSequence<T, Alloc> &s);
+
 /**
- * Doubly linked list for storing string sequences. It is used to create and
- * modify a sequence of strings. It manages memory and ensures no memory
+ * Doubly linked list for storing sequences of T. It is used to create and
+ * modify a sequence of elements. It manages memory and ensures no memory
  * leaks happen.
+ *
+ * Positional operations (operator[], insert, erase) go through the position
+ * index and run in O(log n) expected time. The block found last is kept as
+ * a finger, so scanning s[i] in order, or nearby, costs O(1) amortized.
+ * Reads through a const Sequence may run on several threads at once; the
+ * finger they share is moved under a sequence counter, and a stale hash
+ * index is rebuilt by one of them under the index's lock while the others
+ * wait. Writes must not overlap with any read. Blocks split in two
+ * when an insert finds them full and merge with a neighbour when erase
+ * leaves them sparse.
+ * The front and back of the list are only ever on the edges of the index, so
+ * push_back, pop_back, front and back stay O(1). push_front and pop_front
+ * move the head block's start offset instead of shifting its elements, and
+ * walk the index's left edge, which is O(log n) expected but in practice a
+ * handful of blocks.
+ *
+ * A block is a small header (links, count, index fields) plus a chunk
+ * holding its element slots. Both are carved out of the sequence's arena,
+ * a pair of SequencePools fed by Alloc, so erase and pop_back recycle slots
+ * and clear or destruction free whole slabs. Slots remember their arena:
+ * one freed by another sequence (after a splice, or by the last copy to
+ * let go) is handed back to it. When T is trivially copyable, blocks are
+ * copied and shifted with memcpy/memmove, and when it is trivially
+ * destructible clear() and the destructor skip the per-element walk.
+ *
+ * Copies are copy-on-write: a copy points at the same blocks, so copying
+ * and assigning are O(1). The first change to either sequence after that
+ * gives it headers of its own, O(n / CAPACITY), which still point at the
+ * same chunks; each chunk counts its users, and a block about to change
+ * copies only its own chunk, O(CAPACITY), when another sequence still
+ * reads it. Every sharer keeps reading its own version, so a copy handed
+ * to a reader stays valid however the original changes. Non-const access
+ * (operator[], front, back, begin, end) counts as a change, and since the
+ * reference or iterator it hands out may be written through later, it
+ * also makes the sequence unshareable, as the old copy-on-write
+ * std::string did: until the next change, copying or assigning from it
+ * copies the blocks at once, like clone(). A reference from non-const
+ * access must not be written through after the next change to the
+ * sequence; a copy taken after that change shares the blocks again.
+ *
+ * find, count and contains scan the blocks once. enableIndex() adds a
+ * hash index from value to count and the blocks holding it, which the
+ * changing operations keep up to date, so count and contains become O(1)
+ * expected, and find and positions O(log n) per block they look at (see
+ * SequenceIndex.h). Inserts and erases anywhere keep it exact, and so do
+ * set() and writes through a reference from operator[], front or back:
+ * the index remembers those elements and settles their values at the next
+ * change or query. Non-const iterators, splice and unique mark it stale,
+ * and the next query rebuilds it in one pass. References and iterators
+ * that were obtained before a query, or that emplace, insert and erase
+ * return, must not be written through after it.
+ *
+ * operator== and operator<=> walk both sequences in spans that stay inside
+ * one block of each, whatever the block boundaries, after checking the
+ * sizes; hash() feeds the elements to an XXH64 stream (SequenceHash.h), so
+ * sequences can be keys of unordered containers.
+ *
+ * Building with SEQUENCE_PROFILE defined counts index hops, block
+ * allocations and latencies per operation (see SequenceProfile.h).
+ *
+ * @tparam T Element type.
+ * @tparam Alloc Allocator the block pools draw their slabs from.
  */
-class Sequence {
+template<class T, class Alloc = std::allocator<T>>
+class BasicSequence {
 private:
-    SequenceNode *head; // Pointer for the first node in the list
-    SequenceNode *tail; // Pointer to the last node in the list
+    using Node = SequenceNode<T>;
+    using Chunk = SequenceChunk<T>;
+    static_assert(alignof(Chunk) <= alignof(std::max_align_t), "the pools align slots to std::max_align_t only");
+    static constexpr bool TRIVIAL = std::is_trivially_copyable_v<T>; // elements can be moved as bytes
+    static constexpr bool BYTEWISE = (std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>)
+                                     && std::has_unique_object_representations_v<T>; // equal exactly when their bytes are
+
+    Node *head; // Pointer for the first node in the list
+    Node *tail; // Pointer to the last node in the list
+    Node *root; // Root of the position index
     size_t numElts; // Keeps track of how many elements are stored
+    unsigned seed; // State of the priority generator
+    mutable std::atomic<Node *> finger; // Block found by the last positional lookup, or nullptr
+    mutable std::atomic<size_t> fingerStart; // Index of finger's first element
+    mutable std::atomic<unsigned> fingerVersion; // Odd while a lookup moves the finger
+
+    struct Arena {
+        SequencePool<Alloc> nodes; // Slots of block headers
+        SequencePool<Alloc> chunks; // Slots of element chunks
+        std::atomic<size_t> refs; // Slots in use, plus one while a sequence allocates here
+        std::atomic<void *> returnedNodes; // Header slots freed by other sequences, for the owner to reuse
+        std::atomic<void *> returnedChunks; // Chunk slots freed by other sequences, for the owner to reuse
+    }; // where a sequence's slots come from; outlives it while other sequences hold some of them
+
+    struct Shared {
+        std::atomic<size_t> refs; // Sequences pointing at the blocks
+    }; // block headers handed to copies, dropped by the last one to let go
+
+    Alloc alloc; // Allocator the arena's slabs come from
+    Arena *arena; // Slots of new blocks, created on first use
+    mutable std::atomic<Shared *> shared; // Set while the block headers are shared with copies
+    bool lent; // Blocks may be held by, or come from, other sequences, so they are freed one by one
+    bool mixed; // Chunks may still be shared with copies, so a write may have to copy one
+    bool unshareable; // Non-const access handed out a reference since the last change
+    mutable std::unique_ptr<SequenceIndex<T>> index; // Value lookup, when enabled
+
+    // Position index helpers
+    unsigned nextPriority(); // Draws a priority for a new node
+    Node *findNode(size_t position, Node *cached, size_t cachedStart, size_t &start) const; // Searches from a finger
+    Node *nodeAt(size_t position, size_t &offset); // Finds the block holding an index and moves the finger there
+    Node *nodeAt(size_t position, size_t &offset) const; // Same, for readers that may run side by side
+    void shiftFinger(const Node *node, std::ptrdiff_t delta); // Keeps the finger on its element
+    void adjustWeight(Node *node, std::ptrdiff_t delta); // Tracks a block's count change
+    void indexAppend(Node *node); // Adds node as the last index entry
+    void indexInsert(size_t position, Node *node); // Adds node at an index
+    void indexErase(Node *node); // Removes node from the index
+    static Node *merge(Node *a, size_t aWeight, Node *b); // Joins two subtrees
+    static void split(Node *t, size_t k, Node *&l, Node *&r); // Cuts at k elements
+
+    // Block helpers
+    Arena *ownArena(); // The arena new slots come from, created on first use
+    void letGo(); // Stops allocating from the arena, which lives on while others hold its slots
+    Chunk *newChunk(); // Takes an empty chunk from the arena
+    Node *newNode(Chunk *chunk = nullptr); // Constructs an empty block, with a chunk of its own by default
+    void freeChunk(Chunk *chunk); // Returns a chunk slot to its arena
+    void freeNode(Node *node); // Returns a header slot to its arena
+    void releaseChunk(Node *node); // Drops a block's use of its chunk, destroying the elements if last
+    void deleteNode(Node *node); // Destroys a block and recycles its slots
+    void dropNodes(Node *first); // Deletes a block chain that is no longer linked anywhere
+    void destroyNodes(); // Destroys every block and releases the arena's slabs
+    void ownChunk(Node *node); // Copies a shared chunk before node's elements change
+    void ownAll(); // unshare(), then ownChunk() for every block
+    void moveStart(Node *node, size_t start); // Slides an owned block's elements to slot start
+    void normalizeHead(); // Gives the head start 0 before it stops being the head
+    void syncIndex(bool withPositions) const; // Rebuilds a stale index before a query
+    void touchIndex(); // Marks the index stale after an unreported change
+    void prepareAccess(); // unshare() for non-const access, leaving earlier writes pending
+    T &handOut(Node *node, size_t offset); // Owns an element's chunk and reports it to the index
+    void appendNode(Node *node); // Links a filled block in as the tail
+    void removeNode(Node *node); // Unlinks and deletes a block
+    void splitNode(Node *node, size_t start, size_t keep); // Moves a block's elements after keep out
+    void mergeNext(Node *node); // Pulls the next block's elements into node
+    void mergeIfSparse(Node *&node, size_t &offset); // Folds a sparse block into a neighbour
+    Node *splitAt(size_t position); // Makes position start a block
+    Node *cutRange(size_t position, size_t count, Node **run = nullptr); // Unlinks a run of elements as a block chain
+    void copyNodes(const Node *first, size_t elements); // Appends copies of a block chain
+    struct Run {
+        Node *first; // first block
+        Node *last; // last block; its next is nullptr
+    }; // sorted chain of blocks, unlinked from the list while sorting
+    template<class Compare>
+    static void mergeRuns(Run &a, Run &b, Compare &comp, Node *&spare); // Merges b into a, reusing drained blocks
+    template<class Compare>
+    void mergeAll(std::vector<Run> &runs, Compare &comp); // Merges runs pairwise into one and relinks it
+    void relinkRuns(const std::vector<Run> &runs); // Rebuilds the list and index from chains of blocks
+    template<class More, class Make>
+    void appendEach(More more, Make make); // Builds elements at the end, a block at a time
+    void shareWith(const BasicSequence &s); // Points at s's blocks instead of copying them
+    void unshare(); // Gives this sequence its own block headers before a change
+    void detach(); // Rebuilds shared block headers, keeping their chunks shared
+    bool canTake(const BasicSequence &other) const; // Checks if other's blocks can be linked in as they are
+    SequenceIterator<T, true> unshareAt(SequenceIterator<T, true> pos); // unshare(), keeping an iterator's position
+    static void destroyElements(Node *head, size_t elements); // Destroys the elements of a block chain
+    static void destroyRange(T *items, size_t n); // Destroys n elements
+    static void copyBlock(const Node *from, Node *to); // Copies one block's elements into an empty block
+    static unsigned workersFor(size_t elements); // Threads worth using for a whole-sequence pass
+    template<class Fn>
+    static void forEachChunk(size_t n, unsigned workers, Fn fn); // Runs fn(begin, end) over [0, n) in parallel
+    size_t indexOf(const Node *node) const; // Index of a block's first element
+    T *openSlot(Node *&node, size_t &offset); // Makes room for a new element inside a block
+    void eraseSlot(Node *&node, size_t &offset); // Removes the element in a block slot
+    static void relocate(T *from, size_t n, T *to); // Moves n elements into raw slots
+    template<class Fn>
+    bool zipSpans(const BasicSequence &other, Fn fn) const; // Walks both sequences in spans contiguous in each
 
 public:
-    Sequence(size_t sz = 0); // Default constructor
-    Sequence(const Sequence &s); // Copy constructor (deep)
-    ~Sequence(); // Deconstructor
+    using value_type = T;
+    using allocator_type = Alloc;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using iterator = SequenceIterator<T, false>;
+    using const_iterator = SequenceIterator<T, true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    BasicSequence(size_t sz = 0, const Alloc &alloc = Alloc()); // Default constructor
+    BasicSequence(const BasicSequence &s); // Copy constructor (shares the blocks until a change)
+    BasicSequence(BasicSequence &&s) noexcept; // Move constructor (steals the blocks)
+    ~BasicSequence(); // Deconstructor
 
-    Sequence &operator=(const Sequence &s); // Assignment copy
+    BasicSequence &operator=(const BasicSequence &s); // Assignment copy
+    BasicSequence &operator=(BasicSequence &&s); // Assignment move
+    BasicSequence clone() const; // Copy with blocks of its own, made now rather than at the first change
+    bool sharing() const; // Checks if a copy still shares the blocks
 
     // Access for operator
-    std::string &operator[](size_t position); // Returns a reference to the element at the specified index.
+    T &operator[](size_t position); // Returns a reference to the element at the specified index.
+    const T &operator[](size_t position) const; // Read-only access at the specified index.
+    void set(size_t position, T value); // Replaces the element at the specified index.
 
     // Mutable methods
-    void push_back(std::string element); // Adds an element to the end of the sequence.
+    void push_back(T element); // Adds an element to the end of the sequence.
+    template<class... Args>
+    T &emplace_back(Args &&... args); // Constructs an element in place at the end.
     void pop_back(); //Removes the last element of the sequence.
-    void insert(size_t position, std::string element); // Inserts an element at the given position.
+    void push_front(T element); // Adds an element to the front of the sequence.
+    template<class... Args>
+    T &emplace_front(Args &&... args); // Constructs an element in place at the front.
+    void pop_front(); // Removes the first element of the sequence.
+    void insert(size_t position, T element); // Inserts an element at the given position.
+    template<class... Args>
+    T &emplace(size_t position, Args &&... args); // Constructs an element at the given position.
     void erase(size_t position); // Removes an element at the specified position.
     void erase(size_t position, size_t count); // Removes multiple elements starting at given position.
+    template<std::input_iterator InputIt>
+    void insert(size_t position, InputIt first, InputIt last); // Inserts a range at the given position.
+    void splice(size_t position, BasicSequence &&other); // Moves all of other in at the given position.
+    template<std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    void append(InputIt first, Sentinel last); // Appends a range, filling whole blocks at a time.
+    void append(std::initializer_list<T> items); // Appends a list of elements.
+    template<std::ranges::input_range Range>
+    void assign(Range &&range); // Replaces the contents with the elements of a range.
+    void reserve(size_t n); // Allocates blocks for n elements up front.
+
+    // Ordering
+    template<class Compare = std::less<>>
+    void sort(Compare comp = Compare()); // Stable sort, moving elements between blocks.
+    template<class Compare = std::less<>>
+    void merge(BasicSequence &&other, Compare comp = Compare()); // Merges sorted other into this sorted sequence.
+    template<class BinaryPredicate = std::equal_to<>>
+    size_t unique(BinaryPredicate same = BinaryPredicate()); // Removes consecutive duplicates.
+    void reverse(); // Reverses the order of the elements.
+
+    // Comparison
+    bool operator==(const BasicSequence &other) const requires std::equality_comparable<T>; // Same elements in order.
+    auto operator<=>(const BasicSequence &other) const requires std::three_way_comparable<T>; // Lexicographic order.
+    size_t hash() const requires SequenceByteString<T> || SequenceHashable<T>; // Hash consistent with ==.
+
+    // Slices
+    SequenceSlice<T> view(size_t position, size_t count) const; // Read-only window onto count elements.
+    BasicSequence extract(size_t position, size_t count); // Moves count elements out into a new sequence.
+
+    iterator insert(const_iterator pos, T element); // Inserts an element before pos.
+    template<class... Args>
+    iterator emplace(const_iterator pos, Args &&... args); // Constructs an element before pos.
+    iterator erase(const_iterator pos); // Removes the element at pos.
     void clear(); // Clears all elements from the sequence.
+    std::future<void> clearAsync(); // Empties the sequence now and frees the elements on another thread.
+
+    // Binary files (layout in SequenceFormat.h)
+    void save(std::ostream &os) const requires SequenceByteString<T>; // Writes every element to os.
+    void load(std::istream &is) requires SequenceByteBuffer<T>; // Replaces the contents with a saved sequence.
+
+    // Text output: the "<a, b, c>" that operator<< writes, without the stream overhead
+    size_t formattedSize() const requires SequenceByteString<T>; // Number of characters in the text.
+    template<class Sink>
+    void format(Sink &&sink) const requires SequenceByteString<T>; // Passes the text to sink in chunks.
+#if SEQUENCE_HAS_UNISTD
+    void print(int fd) const requires SequenceByteString<T>; // Writes the text to a file descriptor.
+#endif
+
+    // Iterators
+    iterator begin(); // First element
+    const_iterator begin() const;
+    const_iterator cbegin() const;
+    iterator end(); // One past the last element
+    const_iterator end() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin(); // Last element, walking backwards
+    const_reverse_iterator rbegin() const;
+    const_reverse_iterator crbegin() const;
+    reverse_iterator rend(); // One before the first element
+    const_reverse_iterator rend() const;
+    const_reverse_iterator crend() const;
 
     // Getters
-    std::string front() const; // Returns the first element in the sequence.
-    std::string back() const; // Returns the last element in the sequence.
+    T &front(); // Returns the first element in the sequence.
+    const T &front() const;
+    T &back(); // Returns the last element in the sequence.
+    const T &back() const;
+    // Lookup
+    static constexpr size_t npos = static_cast<size_t>(-1); // "not found" from find
+    size_t find(const T &value, size_t from = 0) const; // First position of value at or after from.
+    template<class Pred>
+    size_t find_if(Pred pred, size_t from = 0) const; // First position at or after from where pred holds.
+    size_t count(const T &value) const; // Number of elements equal to value.
+    bool contains(const T &value) const; // Checks if any element equals value.
+    std::vector<size_t> positions(const T &value) const; // Every position of value, in order.
+    void enableIndex() requires SequenceHashable<T>; // Keeps a hash index for the lookups above.
+    void disableIndex(); // Drops the hash index.
+    bool indexed() const; // Checks if the hash index is enabled.
+
     bool empty() const; // Checks if the sequence in empty.
     size_t size() const; // Returns the number of elements in the sequence.
+    SequencePoolStats allocationStats() const; // Returns the block allocation counters.
+    SequenceFootprint footprint() const; // Measures the memory the sequence holds.
+    Alloc get_allocator() const; // Returns the allocator behind the block pools.
 
     // Friend method for printing sequence
     // **Can only use friend keyword in .h**
-    friend std::ostream &operator<<(std::ostream &os, const Sequence &s);
+    friend std::ostream &operator<< <>(std::ostream &os, const BasicSequence &s);
 };
 
+/**
+ * The string sequence the project is built around, and the type the test
+ * harness and SequenceDebug use.
+ */
+using Sequence = BasicSequence<std::string>;
+
+/**
+ * Lets sequences be keys of unordered containers, through
+ * BasicSequence::hash().
+ */
+template<class T, class Alloc> requires SequenceByteString<T> || SequenceHashable<T>
+struct std::hash<BasicSequence<T, Alloc>> {
+    size_t operator()(const BasicSequence<T, Alloc> &s) const {
+        return s.hash();
+    }
+};
+
+#include "Sequence.tpp"
+
 #endif
@@ -0,0 +1,3671 @@
+/**
+ * Corinna Green
+ * Project 3 - Linked Sequence Data Structure
+ * CS - 3100 Data Structures
+ * 10/13/25
+ *
+ * This project implements a doubly-linked list that stores a sequence of
+ * elements (strings by default). The sequence supports operations such as push_back,
+ * pop-back, insertion, deletion and access by index. The key features/ideas
+ * used in this class include dynamic memory management, single and multiple
+ * deletions via erase, ostream display, bound checking, and the "Big Three"
+ * constructors: default, copy, and deconstruct; along with the assignment operator.
+ *
+ * Designed to use the SequenceDebug file and TestHarness to test the following code.
+ *
+ * BasicSequence is a template, so its member definitions live here and are
+ * included at the bottom of Sequence.h.
+ */
+
+/**
+ * Constructs a Sequence of given size. Start with a sequence of 0 elements, or
+ * create a sequence with sz value-initialized elements (empty strings, zeros).
+ *
+ * @param sz number of initialized elements
+ * @param alloc allocator the block pools draw their slabs from
+ */
+template<class T, class Alloc>
+BasicSequence<T, Alloc>::BasicSequence(size_t sz, const Alloc &alloc)
+    : head(nullptr), tail(nullptr), root(nullptr), numElts(0), seed(2463534242u),
+      finger(nullptr), fingerStart(0), fingerVersion(0), alloc(alloc), arena(nullptr), shared(nullptr),
+      lent(false), mixed(false), unshareable(false) {
+    reserve(sz);
+    size_t made = 0;
+    appendEach([&] { return made < sz; }, [&](T *slot) {
+        new(slot) T(); // value-initialize each element in its block
+        made++;
+    });
+}
+
+/**
+ * Copy constructor. Create an independent copy of another sequence object.
+ * The copy shares the blocks of s in O(1); whichever of the two changes
+ * first then gives itself block headers of its own, and copies a block's
+ * elements only when it writes to that block (see unshare()), so neither
+ * ever sees the other's changes. If s has handed out a reference it may
+ * still be written through, the blocks are copied at once instead.
+ *
+ * @param s Sequence to be copied from.
+ */
+template<class T, class Alloc>
+BasicSequence<T, Alloc>::BasicSequence(const BasicSequence &s)
+    : head(nullptr), tail(nullptr), root(nullptr), numElts(0), seed(2463534242u),
+      finger(nullptr), fingerStart(0), fingerVersion(0),
+      alloc(std::allocator_traits<Alloc>::select_on_container_copy_construction(s.alloc)), arena(nullptr),
+      shared(nullptr), lent(false), mixed(false), unshareable(false) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::COPY);
+    if (s.unshareable) {
+        seed = s.seed;
+        copyNodes(s.head, s.numElts);
+    } else {
+        shareWith(s);
+    }
+}
+
+/**
+ * Move constructor. Takes over the blocks, index and arena of s without
+ * touching a single element, leaving s as an empty sequence.
+ *
+ * @param s Sequence to move from.
+ */
+template<class T, class Alloc>
+BasicSequence<T, Alloc>::BasicSequence(BasicSequence &&s) noexcept
+    : head(s.head), tail(s.tail), root(s.root), numElts(s.numElts), seed(s.seed),
+      finger(s.finger.load(std::memory_order_relaxed)), fingerStart(s.fingerStart.load(std::memory_order_relaxed)),
+      fingerVersion(0), alloc(s.alloc), arena(s.arena), shared(s.shared.load(std::memory_order_relaxed)),
+      lent(s.lent), mixed(s.mixed), unshareable(s.unshareable) {
+    s.head = nullptr;
+    s.tail = nullptr;
+    s.root = nullptr;
+    s.numElts = 0;
+    s.finger.store(nullptr, std::memory_order_relaxed);
+    s.arena = nullptr;
+    s.shared.store(nullptr, std::memory_order_relaxed);
+    s.lent = false;
+    s.mixed = false;
+    s.unshareable = false;
+    if (s.index) {
+        s.index->clear(); // the index stays with s, which is now empty
+    }
+}
+
+/**
+ * Assignment operator.
+ * Replaces the contents of the current Sequence with a copy of another Sequence.
+ * This makes sure that the nodes in this list are deleted before sharing
+ * the blocks of s, copy-on-write like the copy constructor (or copying
+ * them, if s has handed out a writable reference).
+ *
+ * @param s Sequence object to copy from. (RHS).
+ * @return Reference to the new Sequence object (LHS)
+ */
+template<class T, class Alloc>
+BasicSequence<T, Alloc> &BasicSequence<T, Alloc>::operator=(const BasicSequence &s) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::COPY);
+    //Prevent shallow copy**
+    if (this != &s) {
+        // Checking if this sequence object = current object s (LHS = RHS)
+        // Copying from: s (const - cannot be modified)
+        // Assigning to: this
+
+        // Delete any remaining nodes in the section we are using
+        clear();
+
+        // Share the blocks of s until one of the two changes
+        if (s.unshareable) {
+            seed = s.seed;
+            copyNodes(s.head, s.numElts);
+        } else {
+            shareWith(s);
+        }
+        touchIndex();
+    }
+
+    return *this; // Chaining: a=b=c
+}
+
+/**
+ * Move assignment operator.
+ * Destroys the current contents, then takes over the blocks, index and arena
+ * of s. s is left as an empty sequence. If the two allocators cannot free
+ * each other's memory the arena stays with s, which lives on until the
+ * blocks taken from it are let go; blocks are only ever freed into the
+ * arena they came from. The elements are moved over one by one instead
+ * only when s is a plain sequence whose blocks nobody else holds, so that
+ * nothing is left behind in s's allocator.
+ *
+ * @param s Sequence object to move from. (RHS).
+ * @return Reference to this Sequence object (LHS)
+ */
+template<class T, class Alloc>
+BasicSequence<T, Alloc> &BasicSequence<T, Alloc>::operator=(BasicSequence &&s) {
+    if (this == &s) {
+        return *this;
+    }
+    constexpr bool propagate = std::allocator_traits<Alloc>::propagate_on_container_move_assignment::value;
+    const bool takeArena = propagate || canTake(s);
+    Shared *record = s.shared.load(std::memory_order_relaxed);
+
+    if (!takeArena && record == nullptr && !s.lent) {
+        clear();
+        for (Node *current = s.head; current != nullptr; current = current->next) {
+            for (size_t i = 0; i < current->count; i++) {
+                emplace_back(std::move(current->elements()[i]));
+            }
+        }
+        s.clear();
+        return *this;
+    }
+
+    destroyNodes();
+    letGo();
+    head = s.head;
+    tail = s.tail;
+    root = s.root;
+    numElts = s.numElts;
+    seed = s.seed;
+    finger.store(s.finger.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    fingerStart.store(s.fingerStart.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    shared.store(record, std::memory_order_relaxed);
+    mixed = s.mixed;
+    unshareable = s.unshareable;
+    if (takeArena) {
+        if constexpr (propagate) {
+            alloc = s.alloc;
+        }
+        arena = s.arena;
+        lent = s.lent;
+        s.arena = nullptr;
+    } else {
+        lent = true; // the blocks stay in s's arena
+        s.letGo();
+    }
+
+    s.head = nullptr;
+    s.tail = nullptr;
+    s.root = nullptr;
+    s.numElts = 0;
+    s.finger.store(nullptr, std::memory_order_relaxed);
+    s.shared.store(nullptr, std::memory_order_relaxed);
+    s.lent = false;
+    s.mixed = false;
+    s.unshareable = false;
+    if (s.index) {
+        s.index->clear();
+    }
+    touchIndex();
+    return *this;
+}
+
+/**
+ * Deconstructor.
+ * Destroys all dynamically allocated memory in the nodes of the sequence.
+ * This goes through the list destroying each node, then the arena frees
+ * its slabs in one go.
+ */
+template<class T, class Alloc>
+BasicSequence<T, Alloc>::~BasicSequence() {
+    destroyNodes();
+    letGo();
+}
+
+/**
+ * Returns the arena new blocks come from, creating it on first use. An
+ * empty sequence that never allocates never creates one.
+ *
+ * @return This sequence's arena.
+ */
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::Arena *BasicSequence<T, Alloc>::ownArena() {
+    if (arena == nullptr) {
+        arena = new Arena{SequencePool<Alloc>(sizeof(Node), alignof(Node), alloc),
+                          SequencePool<Alloc>(sizeof(Chunk), alignof(Chunk), alloc), 1, nullptr, nullptr};
+    }
+    return arena;
+}
+
+/**
+ * Stops allocating from the arena. Slots other sequences still hold keep
+ * it alive, and whichever of them frees the last slot deletes it, which
+ * returns its slabs to the allocator.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::letGo() {
+    if (arena != nullptr && arena->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete arena;
+    }
+    arena = nullptr;
+    lent = false;
+    mixed = false;
+}
+
+/**
+ * Takes an empty chunk from the arena. Slots other sequences handed back
+ * since the last call are put on the pool's free list first.
+ *
+ * @return The new chunk, used by one block.
+ */
+template<class T, class Alloc>
+SequenceChunk<T> *BasicSequence<T, Alloc>::newChunk() {
+    Arena *from = ownArena();
+    if (from->returnedChunks.load(std::memory_order_relaxed) != nullptr) {
+        void *slot = from->returnedChunks.exchange(nullptr, std::memory_order_acquire);
+        while (slot != nullptr) {
+            void *next = *static_cast<void **>(slot);
+            from->chunks.deallocate(slot);
+            slot = next;
+        }
+    }
+    Chunk *chunk = new(from->chunks.allocate()) Chunk();
+    chunk->home = from;
+    from->refs.fetch_add(1, std::memory_order_relaxed);
+    return chunk;
+}
+
+/**
+ * Constructs an empty block in a header slot taken from the arena, with a
+ * chunk of its own, or reading the given chunk. The caller counts itself
+ * among the given chunk's users beforehand.
+ *
+ * @param chunk Chunk the block reads, or nullptr for a new one.
+ * @return The new block.
+ */
+template<class T, class Alloc>
+SequenceNode<T> *BasicSequence<T, Alloc>::newNode(Chunk *chunk) {
+#ifdef SEQUENCE_PROFILE
+    const auto start = std::chrono::steady_clock::now();
+#endif
+    const bool fresh = chunk == nullptr;
+    if (fresh) {
+        chunk = newChunk();
+    }
+    Arena *from = ownArena();
+    if (from->returnedNodes.load(std::memory_order_relaxed) != nullptr) {
+        void *slot = from->returnedNodes.exchange(nullptr, std::memory_order_acquire);
+        while (slot != nullptr) {
+            void *next = *static_cast<void **>(slot);
+            from->nodes.deallocate(slot);
+            slot = next;
+        }
+    }
+    void *slot;
+    try {
+        slot = from->nodes.allocate();
+    } catch (...) {
+        if (fresh) {
+            freeChunk(chunk);
+        }
+        throw;
+    }
+#ifdef SEQUENCE_PROFILE
+    SequenceProfiler::allocation(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+#endif
+    Node *node = new(slot) Node();
+    node->chunk = chunk;
+    node->home = from;
+    from->refs.fetch_add(1, std::memory_order_relaxed);
+    return node;
+}
+
+/**
+ * Returns a chunk slot to the arena it came from: straight onto the pool's
+ * free list if that is this sequence's arena, otherwise onto the arena's
+ * hand-back list, which any thread may push to. The chunk's elements must
+ * already be destroyed.
+ *
+ * @param chunk Chunk to free.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::freeChunk(Chunk *chunk) {
+    Arena *from = static_cast<Arena *>(chunk->home);
+    chunk->~Chunk();
+    if (from == arena) {
+        from->chunks.deallocate(chunk);
+    } else {
+        void *top = from->returnedChunks.load(std::memory_order_relaxed);
+        do {
+            *reinterpret_cast<void **>(chunk) = top;
+        } while (!from->returnedChunks.compare_exchange_weak(top, chunk, std::memory_order_release,
+                                                             std::memory_order_relaxed));
+    }
+    if (from->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete from; // its owner let go before this last slot
+    }
+}
+
+/**
+ * Returns a block header slot to the arena it came from, like freeChunk().
+ *
+ * @param node Header to free; its chunk must already be released.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::freeNode(Node *node) {
+    Arena *from = static_cast<Arena *>(node->home);
+    node->~Node();
+    if (from == arena) {
+        from->nodes.deallocate(node);
+    } else {
+        void *top = from->returnedNodes.load(std::memory_order_relaxed);
+        do {
+            *reinterpret_cast<void **>(node) = top;
+        } while (!from->returnedNodes.compare_exchange_weak(top, node, std::memory_order_release,
+                                                            std::memory_order_relaxed));
+    }
+    if (from->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete from;
+    }
+}
+
+/**
+ * Drops node's use of its chunk. The last block using a chunk destroys the
+ * elements in it and frees it. A count of one needs no atomic update: no
+ * other sequence can start using a chunk that only this one reads.
+ *
+ * @param node Block whose chunk is let go of.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::releaseChunk(Node *node) {
+    Chunk *chunk = node->chunk;
+    if (chunk->users.load(std::memory_order_acquire) == 1
+        || chunk->users.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        destroyRange(node->elements(), node->count);
+        freeChunk(chunk);
+    }
+    node->chunk = nullptr;
+}
+
+/**
+ * Moves n constructed elements into n raw slots, leaving the source slots
+ * raw. Trivially copyable elements are moved as bytes in one memcpy.
+ *
+ * @param from First element to move.
+ * @param n Number of elements.
+ * @param to First destination slot; must not overlap the source.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::relocate(T *from, size_t n, T *to) {
+    if constexpr (TRIVIAL) {
+        if (n != 0) {
+            std::memcpy(static_cast<void *>(to), static_cast<const void *>(from), n * sizeof(T));
+        }
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            new(&to[i]) T(std::move(from[i]));
+            from[i].~T();
+        }
+    }
+}
+
+/**
+ * Destroys a block along with its elements (unless a copy still reads
+ * them) and recycles its slots for the next newNode().
+ *
+ * @param node Block to delete.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::deleteNode(Node *node) {
+    if (node == finger.load(std::memory_order_relaxed)) {
+        finger.store(nullptr, std::memory_order_relaxed);
+    }
+    SEQUENCE_PROFILE_FREE();
+    releaseChunk(node);
+    freeNode(node);
+}
+
+/**
+ * Deletes every block of a chain that neither the list nor the index of
+ * this sequence links any more, handing each slot back to its arena. For
+ * large chains of elements that need destroying, the chunks no other
+ * block uses are emptied on several threads first.
+ *
+ * @param first First block of the chain.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::dropNodes(Node *first) {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        size_t elements = 0;
+        std::vector<Node *> nodes;
+        try {
+            for (Node *current = first; current != nullptr; current = current->next) {
+                nodes.push_back(current);
+                elements += current->count;
+            }
+        } catch (...) {
+            nodes.clear(); // no memory for the block list: destroy while freeing below
+        }
+        const unsigned workers = workersFor(elements);
+        if (workers > 1 && !nodes.empty()) {
+            forEachChunk(nodes.size(), workers, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    if (nodes[i]->chunk->users.load(std::memory_order_acquire) == 1) {
+                        destroyRange(nodes[i]->elements(), nodes[i]->count);
+                        nodes[i]->count = 0; // nothing left for releaseChunk() to destroy
+                    }
+                }
+            });
+        }
+    }
+
+    while (first != nullptr) {
+        Node *next = first->next;
+        releaseChunk(first);
+        freeNode(first);
+        first = next;
+    }
+}
+
+/**
+ * Destroys every block and returns all of the arena's slabs at once instead
+ * of recycling slot by slot. Shared headers are only let go of; the last
+ * sequence sharing them deletes them. Blocks that may be held by or come
+ * from other sequences are handed back one by one, and the arena is let go
+ * of, since its slabs may still be in use. The list fields are left for
+ * the caller.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::destroyNodes() {
+    Shared *record = shared.load(std::memory_order_relaxed);
+    if (record != nullptr) {
+        shared.store(nullptr, std::memory_order_relaxed);
+        if (record->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete record;
+            dropNodes(head);
+        }
+        letGo();
+    } else if (lent) {
+        dropNodes(head);
+        letGo();
+    } else if (arena != nullptr) {
+        destroyElements(head, numElts);
+        arena->nodes.release();
+        arena->chunks.release();
+        arena->refs.store(1, std::memory_order_relaxed);
+    }
+    head = nullptr;
+    finger.store(nullptr, std::memory_order_relaxed);
+}
+
+/**
+ * Destroys the elements of every block in a chain. Blocks of trivially
+ * destructible elements need no teardown, so the walk is skipped; for
+ * large sequences of other types the blocks are emptied on several
+ * threads. The block memory itself is left to the arena.
+ *
+ * @param head First block of the chain.
+ * @param elements Number of elements in the chain.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::destroyElements(Node *head, size_t elements) {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        const unsigned workers = workersFor(elements);
+        if (workers > 1) {
+            std::vector<Node *> nodes;
+            try {
+                for (Node *current = head; current != nullptr; current = current->next) {
+                    nodes.push_back(current);
+                }
+                forEachChunk(nodes.size(), workers, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        destroyRange(nodes[i]->elements(), nodes[i]->count);
+                    }
+                });
+                head = nullptr;
+            } catch (...) {
+                // No memory for the block list: fall back to the serial walk below
+            }
+        }
+
+        while (head != nullptr) {
+            destroyRange(head->elements(), head->count); // Destroy old head's elements
+            head = head->next; // Move head forward
+        }
+    }
+}
+
+/**
+ * Destroys n constructed elements, leaving their slots raw.
+ *
+ * @param items First element.
+ * @param n Number of elements.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::destroyRange(T *items, size_t n) {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        for (size_t i = 0; i < n; i++) {
+            items[i].~T();
+        }
+    }
+}
+
+/**
+ * Gives node a chunk of its own before its elements change: while another
+ * block, of a copy of this sequence, still uses the chunk, the elements
+ * are copied into a fresh one. Only this block's elements are copied.
+ *
+ * @param node Block about to change.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::ownChunk(Node *node) {
+    Chunk *old = node->chunk;
+    if (old->users.load(std::memory_order_acquire) == 1) {
+        return;
+    }
+    Chunk *fresh = newChunk();
+    const T *items = node->elements();
+    T *copies = fresh->slots() + node->start;
+    size_t done = 0;
+    try {
+        if constexpr (TRIVIAL) {
+            if (node->count != 0) {
+                std::memcpy(static_cast<void *>(copies), static_cast<const void *>(items), node->count * sizeof(T));
+            }
+            done = node->count;
+        } else {
+            for (; done < node->count; done++) {
+                new(&copies[done]) T(items[done]);
+            }
+        }
+    } catch (...) {
+        destroyRange(copies, done);
+        freeChunk(fresh);
+        throw;
+    }
+    node->chunk = fresh;
+    if (old->users.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        destroyRange(old->slots() + node->start, node->count); // the copies let go meanwhile
+        freeChunk(old);
+    }
+}
+
+/**
+ * unshare(), then gives every block a chunk of its own, for changes that
+ * may touch any element. Only a sequence that has shared its blocks since
+ * the last call walks them.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::ownAll() {
+    unshare();
+    if (mixed) {
+        for (Node *current = head; current != nullptr; current = current->next) {
+            ownChunk(current);
+        }
+        mixed = false;
+    }
+}
+
+/**
+ * Slides node's elements so the first one sits in slot start of its chunk,
+ * moving them in the order that never overwrites one still to be moved.
+ * The chunk must already be node's own.
+ *
+ * @param node Block whose elements move.
+ * @param start New first slot; start + count must fit in the chunk.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::moveStart(Node *node, size_t start) {
+    if (start == node->start) {
+        return;
+    }
+    T *from = node->elements();
+    T *to = node->chunk->slots() + start;
+    const size_t n = node->count;
+    if constexpr (TRIVIAL) {
+        if (n != 0) {
+            std::memmove(static_cast<void *>(to), static_cast<const void *>(from), n * sizeof(T));
+        }
+    } else if (to < from) {
+        for (size_t i = 0; i < n; i++) {
+            new(&to[i]) T(std::move(from[i]));
+            from[i].~T();
+        }
+    } else {
+        for (size_t i = n; i-- > 0;) {
+            new(&to[i]) T(std::move(from[i]));
+            from[i].~T();
+        }
+    }
+    node->start = start;
+}
+
+/**
+ * Moves the head's elements back to the start of its chunk. Only the head
+ * may keep a start offset, so anything about to link another block in
+ * front of it, or to reorder the blocks, calls this first.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::normalizeHead() {
+    if (head != nullptr && head->start != 0) {
+        ownChunk(head);
+        moveStart(head, 0);
+    }
+}
+
+/**
+ * Draws the priority for a new index node from a xorshift generator. The
+ * index stays balanced in expectation as long as priorities look random.
+ *
+ * @return A pseudo-random priority.
+ */
+template<class T, class Alloc>
+unsigned BasicSequence<T, Alloc>::nextPriority() {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/**
+ * Finds the block holding the element at position. The given finger block
+ * and its two neighbours, then the head and tail blocks, are tried first in
+ * O(1); anything further away descends the position index in O(log n)
+ * expected time.
+ *
+ * @param position Index of the desired element, must be < numElts.
+ * @param cached Finger block to start from, or nullptr.
+ * @param cachedStart Index of cached's first element.
+ * @param start Receives the index of the found block's first element.
+ * @return The block holding that element.
+ */
+template<class T, class Alloc>
+SequenceNode<T> *BasicSequence<T, Alloc>::findNode(size_t position, Node *cached, size_t cachedStart,
+                                                   size_t &start) const {
+    if (cached != nullptr) {
+        if (position >= cachedStart) {
+            if (position - cachedStart < cached->count) {
+                start = cachedStart;
+                return cached;
+            }
+            if (cached->next != nullptr && position - cachedStart - cached->count < cached->next->count) {
+                start = cachedStart + cached->count;
+                return cached->next; // Next block over, the usual case for a forward scan
+            }
+        } else if (cached->prev != nullptr && cachedStart - position <= cached->prev->count) {
+            start = cachedStart - cached->prev->count;
+            return cached->prev; // Previous block, for a backward scan
+        }
+    }
+
+    if (position < head->count) {
+        start = 0;
+        return head;
+    }
+    if (position >= numElts - tail->count) {
+        start = numElts - tail->count;
+        return tail;
+    }
+
+    Node *current = root; // Too far from anything cached: descend the index
+    size_t remaining = position;
+    while (true) {
+        if (remaining < current->leftWeight) {
+            current = current->left; // Element is in the left subtree
+        } else if (remaining < current->leftWeight + current->count) {
+            break;
+        } else {
+            remaining -= current->leftWeight + current->count; // Skip the left subtree and this block
+            current = current->right;
+        }
+        SEQUENCE_PROFILE_HOPS(1);
+    }
+    start = position - (remaining - current->leftWeight);
+    return current;
+}
+
+/**
+ * Finds the block holding the element at position, starting from the
+ * finger, and makes it the new finger. Only one thread may use a non-const
+ * Sequence, so the finger is read and moved without any protocol.
+ *
+ * @param position Index of the desired element, must be < numElts.
+ * @param offset Receives the slot of the element inside the block.
+ * @return The block holding that element.
+ */
+template<class T, class Alloc>
+SequenceNode<T> *BasicSequence<T, Alloc>::nodeAt(size_t position, size_t &offset) {
+    size_t start;
+    Node *current = findNode(position, finger.load(std::memory_order_relaxed),
+                             fingerStart.load(std::memory_order_relaxed), start);
+    SEQUENCE_PROFILE_HOPS(1);
+    finger.store(current, std::memory_order_relaxed);
+    fingerStart.store(start, std::memory_order_relaxed);
+    offset = position - start;
+    return current;
+}
+
+/**
+ * Finds the block holding the element at position through a const
+ * Sequence, starting from the finger, and makes it the new finger.
+ *
+ * Lookups through a const Sequence may run on several threads at once, so
+ * the finger is read and moved under a sequence counter: a lookup that
+ * catches another one moving it searches without it, and only one of two
+ * lookups racing to move it does so.
+ *
+ * @param position Index of the desired element, must be < numElts.
+ * @param offset Receives the slot of the element inside the block.
+ * @return The block holding that element.
+ */
+template<class T, class Alloc>
+SequenceNode<T> *BasicSequence<T, Alloc>::nodeAt(size_t position, size_t &offset) const {
+    const unsigned version = fingerVersion.load(std::memory_order_acquire);
+    Node *cached = finger.load(std::memory_order_acquire);
+    const size_t cachedStart = fingerStart.load(std::memory_order_acquire);
+    if (version % 2 != 0 || fingerVersion.load(std::memory_order_relaxed) != version) {
+        cached = nullptr; // being moved: the two halves may not match
+    }
+
+    size_t start;
+    Node *current = findNode(position, cached, cachedStart, start);
+    SEQUENCE_PROFILE_HOPS(1);
+    unsigned expected = version;
+    if (current != cached && version % 2 == 0
+        && fingerVersion.compare_exchange_strong(expected, version + 1, std::memory_order_relaxed)) {
+        finger.store(current, std::memory_order_release); // a reader that sees it sees the odd version
+        fingerStart.store(start, std::memory_order_release);
+        fingerVersion.store(version + 2, std::memory_order_release);
+    }
+    offset = position - start;
+    return current;
+}
+
+/**
+ * Keeps fingerStart right after node gained or lost delta elements: the
+ * finger only moves when node comes before it.
+ *
+ * @param node Block whose count changed; must not have been deleted.
+ * @param delta Change in the block's count.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::shiftFinger(const Node *node, std::ptrdiff_t delta) {
+    const Node *cached = finger.load(std::memory_order_relaxed);
+    const size_t start = fingerStart.load(std::memory_order_relaxed);
+    if (cached != nullptr && node != cached && indexOf(node) < start) {
+        fingerStart.store(start + delta, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Records that node gained (or lost, for a negative delta) elements by
+ * updating every ancestor that has node in its left subtree. Blocks on the
+ * right spine, like the tail, never touch any leftWeight.
+ *
+ * @param node Block whose count changed.
+ * @param delta Change in the block's count.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::adjustWeight(Node *node, std::ptrdiff_t delta) {
+    for (Node *child = node, *above = node->parent; above != nullptr;
+         child = above, above = above->parent) {
+        SEQUENCE_PROFILE_HOPS(1);
+        if (above->left == child) {
+            above->leftWeight += delta;
+        }
+    }
+}
+
+/**
+ * Joins two index subtrees where every element of a comes before every
+ * element of b. The root of the result has a stale parent pointer that the
+ * caller must set.
+ *
+ * @param a Subtree holding the earlier elements.
+ * @param aWeight Number of elements in a.
+ * @param b Subtree holding the later elements.
+ * @return Root of the joined subtree.
+ */
+template<class T, class Alloc>
+SequenceNode<T> *BasicSequence<T, Alloc>::merge(Node *a, size_t aWeight, Node *b) {
+    if (a == nullptr) {
+        return b;
+    }
+    if (b == nullptr) {
+        return a;
+    }
+
+    if (a->priority >= b->priority) {
+        // a stays on top, b joins its right subtree
+        a->right = merge(a->right, aWeight - a->leftWeight - a->count, b);
+        a->right->parent = a;
+        return a;
+    }
+
+    // b stays on top, a joins its left subtree
+    b->left = merge(a, aWeight, b->left);
+    b->left->parent = b;
+    b->leftWeight += aWeight;
+    return b;
+}
+
+/**
+ * Cuts an index subtree so that l receives its first k elements and r the
+ * rest. k must fall on a block boundary. The roots of l and r have stale
+ * parent pointers that the caller must set.
+ *
+ * @param t Subtree to cut.
+ * @param k Number of elements that go to l.
+ * @param l Receives the subtree of the first k elements.
+ * @param r Receives the subtree of the remaining elements.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::split(Node *t, size_t k, Node *&l, Node *&r) {
+    if (t == nullptr) {
+        l = nullptr;
+        r = nullptr;
+        return;
+    }
+
+    if (k <= t->leftWeight) {
+        // The cut is inside the left subtree, t goes right
+        split(t->left, k, l, t->left);
+        if (t->left != nullptr) {
+            t->left->parent = t;
+        }
+        t->leftWeight -= k;
+        r = t;
+    } else {
+        // The cut is inside the right subtree, t goes left
+        split(t->right, k - t->leftWeight - t->count, t->right, r);
+        if (t->right != nullptr) {
+            t->right->parent = t;
+        }
+        l = t;
+    }
+}
+
+/**
+ * Adds node as the last entry of the position index. The new node only
+ * climbs the right spine past nodes with lower priority, which is O(1)
+ * expected, and no leftWeight above it changes.
+ *
+ * @param node Block that was just linked in as the tail.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::indexAppend(Node *node) {
+    node->priority = nextPriority();
+
+    Node *spine = node->prev; // old tail, the bottom of the right spine
+    Node *child = nullptr;
+    size_t childWeight = 0;
+    while (spine != nullptr && spine->priority < node->priority) {
+        childWeight += spine->leftWeight + spine->count; // spine node and its left subtree move under node
+        child = spine;
+        spine = spine->parent;
+    }
+
+    node->left = child;
+    node->leftWeight = childWeight;
+    if (child != nullptr) {
+        child->parent = node;
+    }
+
+    node->parent = spine;
+    if (spine != nullptr) {
+        spine->right = node;
+    } else {
+        root = node;
+    }
+}
+
+/**
+ * Adds node to the position index so that its first element ends up at
+ * position. position must fall on a block boundary.
+ *
+ * @param position Index the node's first element will have once inserted.
+ * @param node Block to insert.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::indexInsert(size_t position, Node *node) {
+    node->priority = nextPriority();
+
+    Node *l;
+    Node *r;
+    split(root, position, l, r);
+    root = merge(merge(l, position, node), position + node->count, r);
+    root->parent = nullptr;
+}
+
+/**
+ * Removes node from the position index and fixes the leftWeight of every
+ * ancestor that had it in its left subtree.
+ *
+ * @param node Block to remove.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::indexErase(Node *node) {
+    adjustWeight(node, -static_cast<std::ptrdiff_t>(node->count));
+
+    Node *sub = merge(node->left, node->leftWeight, node->right);
+    Node *above = node->parent;
+    if (sub != nullptr) {
+        sub->parent = above;
+    }
+
+    if (above == nullptr) {
+        root = sub;
+    } else if (above->left == node) {
+        above->left = sub;
+    } else {
+        above->right = sub;
+    }
+}
+
+/**
+ * Links a block that already holds its elements in as the new tail.
+ *
+ * @param node Filled block to append.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::appendNode(Node *node) {
+    if (head == nullptr) {
+        head = node; // list is empty -> new node will be both head and tail
+        tail = node;
+    } else {
+        tail->next = node; // Attach block to the end
+        node->prev = tail;
+        tail = node;
+    }
+
+    indexAppend(node);
+    numElts += node->count;
+}
+
+/**
+ * Unlinks a block from the list and the index and deletes it along with
+ * any elements it still holds. numElts is left to the caller.
+ *
+ * @param node Block to remove.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::removeNode(Node *node) {
+    indexErase(node);
+
+    // tail
+    if (node->next != nullptr) {
+        node->next->prev = node->prev;
+    } else {
+        tail = node->prev; // Removing last block
+    }
+
+    // head
+    if (node->prev != nullptr) {
+        node->prev->next = node->next;
+    } else {
+        head = node->next; // Remove first block
+    }
+
+    deleteNode(node);
+}
+
+/**
+ * Moves every element of a block from slot keep on into a new block linked
+ * right after it. Splitting a full block at its middle makes room for
+ * inserts into either half.
+ *
+ * @param node Block to split.
+ * @param start Index of node's first element.
+ * @param keep Number of elements that stay in node, 0 < keep < count.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::splitNode(Node *node, size_t start, size_t keep) {
+    const size_t moved = node->count - keep;
+
+    ownChunk(node);
+    Node *newNode = this->newNode();
+    relocate(node->elements() + keep, moved, newNode->elements());
+    node->count = keep;
+    newNode->count = moved;
+    adjustWeight(node, -static_cast<std::ptrdiff_t>(moved));
+
+    // Link the new block after node
+    newNode->prev = node;
+    newNode->next = node->next;
+    if (node->next != nullptr) {
+        node->next->prev = newNode;
+    } else {
+        tail = newNode;
+    }
+    node->next = newNode;
+
+    indexInsert(start + keep, newNode);
+    if (index) {
+        for (size_t i = 0; i < moved; i++) {
+            index->moved(newNode->elements()[i], node, newNode);
+        }
+    }
+}
+
+/**
+ * Moves every element of the block after node to the end of node and
+ * removes the emptied block. The two counts must fit in one block.
+ *
+ * @param node Block that absorbs its successor.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::mergeNext(Node *node) {
+    Node *other = node->next;
+    ownChunk(node);
+    ownChunk(other);
+    moveStart(node, 0); // a head may hold a front offset; both must fit
+    const size_t moved = other->count;
+    if (index) {
+        for (size_t i = 0; i < moved; i++) {
+            index->moved(other->elements()[i], other, node);
+        }
+    }
+    relocate(other->elements(), moved, node->elements() + node->count);
+
+    adjustWeight(node, static_cast<std::ptrdiff_t>(moved));
+    node->count += moved;
+    adjustWeight(other, -static_cast<std::ptrdiff_t>(moved));
+    other->count = 0;
+    removeNode(other); // nothing left to destroy
+}
+
+/**
+ * Folds node into a neighbour when it has fallen below a quarter full and
+ * the two fit in one block, keeping blocks dense. node and offset are
+ * updated to keep naming the same element (or slot) after the move.
+ *
+ * @param node Block to check.
+ * @param offset Slot inside node to keep track of.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::mergeIfSparse(Node *&node, size_t &offset) {
+    if (node->count >= Node::CAPACITY / 4) {
+        return;
+    }
+
+    if (node->next != nullptr && node->count + node->next->count <= Node::CAPACITY) {
+        mergeNext(node); // node keeps its elements where they are
+    } else if (node->prev != nullptr && node->prev->count + node->count <= Node::CAPACITY) {
+        Node *into = node->prev;
+        offset += into->count;
+        mergeNext(into);
+        node = into;
+    }
+}
+
+/**
+ * Makes sure a block starts exactly at position, splitting the block that
+ * holds it if needed.
+ *
+ * @param position Index that should start a block, <= numElts.
+ * @return The block starting at position, or nullptr at the end.
+ */
+template<class T, class Alloc>
+SequenceNode<T> *BasicSequence<T, Alloc>::splitAt(size_t position) {
+    if (position == numElts) {
+        return nullptr;
+    }
+
+    size_t offset;
+    Node *node = nodeAt(position, offset);
+    if (offset == 0) {
+        return node;
+    }
+
+    splitNode(node, position - offset, offset);
+    return node->next;
+}
+
+/**
+ * Unlinks the elements [position, position + count) from the list and the
+ * index in O(log n), after splitting the blocks at both ends. The removed
+ * blocks form a chain linked through next and ending in nullptr; they are
+ * no longer counted in numElts, nor in the hash index, but still belong to
+ * this sequence.
+ *
+ * @param position Index of the first element to cut, count > 0.
+ * @param count Number of elements to cut.
+ * @param run Receives the root of the index over the removed blocks, if
+ *            not null; otherwise their index links are left stale.
+ * @return First block of the removed chain.
+ */
+template<class T, class Alloc>
+SequenceNode<T> *BasicSequence<T, Alloc>::cutRange(size_t position, size_t count, Node **run) {
+    Node *first = splitAt(position);
+    Node *after = splitAt(position + count);
+    Node *last = after != nullptr ? after->prev : tail;
+    Node *before = first->prev;
+    if (index) {
+        // Reported while the blocks are still linked, so the index can place them
+        for (Node *current = first; current != after; current = current->next) {
+            for (size_t i = 0; i < current->count; i++) {
+                index->erased(current->elements()[i], current);
+            }
+        }
+    }
+
+    // Take the run out of the index
+    Node *l;
+    Node *middle;
+    Node *r;
+    split(root, position, l, middle);
+    split(middle, count, middle, r);
+    root = merge(l, position, r);
+    if (root != nullptr) {
+        root->parent = nullptr;
+    }
+    if (run != nullptr) {
+        middle->parent = nullptr;
+        *run = middle;
+    }
+
+    // Take the run out of the list
+    if (before != nullptr) {
+        before->next = after;
+    } else {
+        head = after;
+    }
+    if (after != nullptr) {
+        after->prev = before;
+    } else {
+        tail = before;
+    }
+    first->prev = nullptr;
+    last->next = nullptr;
+
+    numElts -= count;
+    finger.store(nullptr, std::memory_order_relaxed); // every block after the cut moved
+    return first;
+}
+
+/**
+ * Copies the elements of one block into an empty block. If a copy throws,
+ * to->count says how many elements were constructed.
+ *
+ * @param from Block to copy.
+ * @param to Empty block to copy into.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::copyBlock(const Node *from, Node *to) {
+    const T *items = from->elements();
+    T *copies = to->elements();
+    if constexpr (TRIVIAL) {
+        std::memcpy(static_cast<void *>(copies), static_cast<const void *>(items), from->count * sizeof(T));
+        to->count = from->count; // the whole block in one copy
+    } else {
+        for (; to->count < from->count; to->count++) {
+            new(&copies[to->count]) T(items[to->count]); // Copy each element of the block
+        }
+    }
+}
+
+/**
+ * Returns how many threads a pass over every element should use: one for
+ * sequences under SequenceParallelism::minElements(), otherwise up to
+ * SequenceParallelism::maxWorkers() with at least half that many elements
+ * each.
+ *
+ * @param elements Number of elements the pass touches.
+ * @return Number of threads, the calling one included.
+ */
+template<class T, class Alloc>
+unsigned BasicSequence<T, Alloc>::workersFor(size_t elements) {
+    const size_t minElements = SequenceParallelism::minElements();
+    if (elements < minElements) {
+        return 1;
+    }
+    const size_t byWork = elements / (minElements / 2);
+    const size_t limit = SequenceParallelism::maxWorkers();
+    return static_cast<unsigned>(limit < byWork ? limit : byWork);
+}
+
+/**
+ * Splits [0, n) into one contiguous chunk per worker and calls fn(begin,
+ * end) for each: the calling thread takes the first chunk and new threads
+ * the rest. The first exception thrown by any chunk is rethrown once every
+ * thread has finished.
+ *
+ * @param n Number of items.
+ * @param workers Number of chunks, at least 1.
+ * @param fn Callable taking (size_t begin, size_t end).
+ */
+template<class T, class Alloc>
+template<class Fn>
+void BasicSequence<T, Alloc>::forEachChunk(size_t n, unsigned workers, Fn fn) {
+    std::vector<std::exception_ptr> errors(workers);
+    auto run = [&](unsigned w) {
+        try {
+            fn(n * w / workers, n * (w + 1) / workers);
+        } catch (...) {
+            errors[w] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    try {
+        for (unsigned w = 1; w < workers; w++) {
+            threads.emplace_back(run, w);
+        }
+    } catch (...) {
+        // Could not start a thread: do its chunks here instead
+        for (unsigned w = static_cast<unsigned>(threads.size()) + 1; w < workers; w++) {
+            run(w);
+        }
+    }
+    run(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (const std::exception_ptr &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/**
+ * Appends a copy of every block in a chain to this sequence, keeping the
+ * block layout of the source.
+ *
+ * Large sequences are copied in parallel: the empty blocks are taken from
+ * the arena up front, worker threads each copy a contiguous run of blocks,
+ * and the filled blocks are then linked in order. Only the element copies
+ * run concurrently; the arena and the index are touched by this thread alone.
+ *
+ * @param first First block to copy.
+ * @param elements Number of elements in the chain.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::copyNodes(const Node *first, size_t elements) {
+    const unsigned workers = workersFor(elements);
+    if (workers <= 1) {
+        const Node *current = first; // node object to serve as the pointer for *this list
+
+        while (current != nullptr) {
+            // make sure pointer isn't pointing at nothing
+            Node *newNode = this->newNode();
+            try {
+                copyBlock(current, newNode);
+            } catch (...) {
+                deleteNode(newNode); // destroys what was copied so far
+                throw;
+            }
+
+            appendNode(newNode);
+            current = current->next; // Move to the next node
+        }
+        return;
+    }
+
+    std::vector<const Node *> sources;
+    for (const Node *current = first; current != nullptr; current = current->next) {
+        sources.push_back(current);
+    }
+    std::vector<Node *> copies;
+    copies.reserve(sources.size());
+
+    ownArena()->nodes.reserve(sources.size()); // one slab for every copy
+    arena->chunks.reserve(sources.size());
+    try {
+        for (size_t i = 0; i < sources.size(); i++) {
+            copies.push_back(newNode());
+        }
+        forEachChunk(sources.size(), workers, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                copyBlock(sources[i], copies[i]);
+            }
+        });
+    } catch (...) {
+        for (Node *node : copies) {
+            deleteNode(node); // destroys what was copied so far
+        }
+        throw;
+    }
+
+    for (Node *node : copies) {
+        appendNode(node);
+    }
+}
+
+/**
+ * Builds elements at the end of the sequence while more() is true, each
+ * one constructed in its slot by make(slot). The tail block is topped up
+ * first, then fresh blocks are filled completely before each is linked in
+ * with one appendNode, instead of the per-element checks and relinking of
+ * emplace_back. If make throws, the elements built before it stay.
+ *
+ * @param more Callable returning whether another element follows.
+ * @param make Callable constructing the next element in the raw slot given.
+ */
+template<class T, class Alloc>
+template<class More, class Make>
+void BasicSequence<T, Alloc>::appendEach(More more, Make make) {
+    unshare();
+    if (tail != nullptr && tail->count < Node::CAPACITY && more()) {
+        ownChunk(tail);
+        moveStart(tail, 0); // a tail that is also the head may hold a front offset
+        // The tail is on the right spine, so no leftWeight changes
+        do {
+            make(&tail->elements()[tail->count]);
+            tail->count++;
+            numElts++;
+            if (index) {
+                index->pushed(tail->elements()[tail->count - 1], tail);
+            }
+        } while (tail->count < Node::CAPACITY && more());
+    }
+
+    while (more()) {
+        Node *node = newNode();
+        try {
+            do {
+                make(&node->elements()[node->count]);
+                node->count++;
+                if (index) {
+                    index->pushed(node->elements()[node->count - 1], node);
+                }
+            } while (node->count < Node::CAPACITY && more());
+        } catch (...) {
+            if (node->count == 0) {
+                deleteNode(node);
+            } else {
+                appendNode(node); // keep what was built
+            }
+            throw;
+        }
+        appendNode(node);
+    }
+}
+
+/**
+ * Makes this empty sequence point at the blocks of s instead of copying
+ * them. The first time s is shared it gets a Shared record counting the
+ * sequences that read its block headers, published with one
+ * compare-exchange. The blocks stay in the arena of s, which outlives s
+ * while anyone holds them. Nothing else in s changes, so several threads
+ * may copy one const sequence at once.
+ *
+ * @param s Sequence whose blocks to share.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::shareWith(const BasicSequence &s) {
+    if (s.head == nullptr) {
+        return;
+    }
+
+    Shared *record = s.shared.load(std::memory_order_acquire);
+    if (record == nullptr) {
+        auto *fresh = new Shared{2};
+        if (s.shared.compare_exchange_strong(record, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            record = fresh;
+        } else {
+            delete fresh; // another copy published one first; record now holds it
+            record->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        record->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shared.store(record, std::memory_order_relaxed);
+    lent = true;
+    mixed = true;
+    head = s.head;
+    tail = s.tail;
+    root = s.root;
+    numElts = s.numElts;
+    seed = s.seed;
+    finger.store(nullptr, std::memory_order_relaxed);
+}
+
+/**
+ * Called before any change: makes sure the block headers belong to this
+ * sequence alone, so the list and index can be relinked. O(1) when they
+ * already do. The elements may still be shared after this; a change to a
+ * block's elements calls ownChunk() first. A change also ends the life of
+ * any reference handed out before it, so copies may share the blocks
+ * again, and the index accounts for whatever was written through them.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::unshare() {
+    if (index) {
+        index->settle(); // the blocks are still as the references saw them
+    }
+    unshareable = false;
+    if (shared.load(std::memory_order_relaxed) != nullptr) {
+        detach();
+    }
+}
+
+/**
+ * Gives this sequence block headers of its own. When every other sharer
+ * has let go already, the headers are simply kept. Otherwise a header is
+ * made for every block, O(n / CAPACITY), pointing at the same chunk as
+ * the shared one, and the share is released; no element is copied. If
+ * that throws, nothing changes.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::detach() {
+    Shared *old = shared.load(std::memory_order_relaxed);
+    lent = true;
+    mixed = true;
+    if (old->refs.load(std::memory_order_acquire) == 1) {
+        delete old; // the last sharer: nothing to rebuild
+        shared.store(nullptr, std::memory_order_relaxed);
+        return;
+    }
+
+    Node *oldHead = head;
+    Node *oldTail = tail;
+    Node *oldRoot = root;
+    const size_t elements = numElts;
+    head = tail = root = nullptr;
+    numElts = 0;
+    finger.store(nullptr, std::memory_order_relaxed);
+    try {
+        for (Node *current = oldHead; current != nullptr; current = current->next) {
+            current->chunk->users.fetch_add(1, std::memory_order_relaxed);
+            Node *node;
+            try {
+                node = newNode(current->chunk);
+            } catch (...) {
+                current->chunk->users.fetch_sub(1, std::memory_order_relaxed);
+                throw;
+            }
+            node->count = current->count;
+            node->start = current->start;
+            appendNode(node);
+        }
+    } catch (...) {
+        dropNodes(head); // only drops this sequence's uses of the chunks
+        head = oldHead;
+        tail = oldTail;
+        root = oldRoot;
+        numElts = elements;
+        throw;
+    }
+    shared.store(nullptr, std::memory_order_relaxed);
+    if (index) {
+        index->reordered(); // the block lists name the shared headers
+    }
+
+    if (old->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete old; // the others let go while the headers were built
+        dropNodes(oldHead);
+    }
+}
+
+/**
+ * Copies the sequence into blocks of the copy's own, from the same
+ * allocator, instead of sharing them: O(n), in parallel for large
+ * sequences, but the copy never has to copy a block later.
+ *
+ * @return The copy.
+ */
+template<class T, class Alloc>
+BasicSequence<T, Alloc> BasicSequence<T, Alloc>::clone() const {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::COPY);
+    BasicSequence copy(0, alloc);
+    copy.seed = seed;
+    copy.copyNodes(head, numElts);
+    return copy;
+}
+
+/**
+ * Checks if a copy still reads this sequence's block headers, so that the
+ * next change would have to rebuild them first.
+ *
+ * @return true while another sequence shares the blocks.
+ */
+template<class T, class Alloc>
+bool BasicSequence<T, Alloc>::sharing() const {
+    const Shared *record = shared.load(std::memory_order_acquire);
+    return record != nullptr && record->refs.load(std::memory_order_acquire) > 1;
+}
+
+/**
+ * Checks whether other's blocks may be linked into this sequence as they
+ * are. They stay in other's arena, so this sequence would then hold memory
+ * of other's allocator, which is only right when the two compare equal.
+ *
+ * @param other Sequence whose blocks would be taken.
+ * @return true if the allocators compare equal.
+ */
+template<class T, class Alloc>
+bool BasicSequence<T, Alloc>::canTake(const BasicSequence &other) const {
+    if constexpr (std::allocator_traits<Alloc>::is_always_equal::value) {
+        return true;
+    } else {
+        return alloc == other.alloc;
+    }
+}
+
+/**
+ * Provides access to a specified element by index. Will throw exception if
+ * the position is outside the sequence bounds. Indexes at or next to the
+ * previous lookup, or in the first or last block, are found in O(1).
+ *
+ * @param position Index of the desired element
+ * @return Reference to the string element at the specific position.
+ * @throws std::out_of_range if position >= numElts
+ */
+template<class T, class Alloc>
+T &BasicSequence<T, Alloc>::operator[](size_t position) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::INDEX);
+    if (position >= numElts) {
+        throw std::out_of_range("Index is out of range");
+    }
+    prepareAccess();
+
+    size_t offset;
+    Node *current = nodeAt(position, offset);
+    return handOut(current, offset);
+}
+
+/**
+ * Replaces the element at position with value. Unlike a write through
+ * operator[] the index is updated right away, so nothing is left for the
+ * next change or query to settle.
+ *
+ * @param position Index of the element to replace.
+ * @param value The new value.
+ * @throws std::out_of_range if position >= numElts
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::set(size_t position, T value) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::INDEX);
+    if (position >= numElts) {
+        throw std::out_of_range("Index is out of range");
+    }
+    unshare();
+
+    size_t offset;
+    Node *current = nodeAt(position, offset);
+    ownChunk(current);
+    T &slot = current->elements()[offset];
+    if (index) {
+        index->replaced(slot, value, current);
+    }
+    slot = std::move(value);
+}
+
+/**
+ * Readies the sequence for non-const access to an element: a shared one
+ * gets block headers of its own, and the sequence becomes unshareable.
+ * Unlike unshare() this leaves the elements handed out before pending in
+ * the index, since their references may still be written through along
+ * with the new one.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::prepareAccess() {
+    if (shared.load(std::memory_order_relaxed) != nullptr) {
+        unshare(); // nothing is pending: an unshareable sequence is never shared
+    }
+    unshareable = true;
+}
+
+/**
+ * Hands out the element in slot offset of node for writing: the block gets
+ * a chunk of its own, and the index remembers the element's value so the
+ * next change or query can account for a write through the reference.
+ *
+ * @param node Block holding the element.
+ * @param offset Slot of the element.
+ * @return Reference to the element.
+ */
+template<class T, class Alloc>
+T &BasicSequence<T, Alloc>::handOut(Node *node, size_t offset) {
+    ownChunk(node);
+    if (index) {
+        index->handedOut(node, offset);
+    }
+    return node->elements()[offset];
+}
+
+/**
+ * Read-only access to a specified element by index.
+ *
+ * @param position Index of the desired element
+ * @return Const reference to the string element at the specific position.
+ * @throws std::out_of_range if position >= numElts
+ */
+template<class T, class Alloc>
+const T &BasicSequence<T, Alloc>::operator[](size_t position) const {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::INDEX);
+    if (position >= numElts) {
+        throw std::out_of_range("Index is out of range");
+    }
+
+    size_t offset;
+    const Node *current = nodeAt(position, offset);
+    return current->elements()[offset];
+}
+
+/**
+ * Adds a new element to the end of the sequence. The item goes into the
+ * tail block when it has room; otherwise a new block is dynamically
+ * allocated and attached to the tail end (becomes tail ptr) of the list.
+ * The item is moved into place, not copied.
+ *
+ * @param item The element that is added to the sequence.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::push_back(T item) {
+    emplace_back(std::move(item));
+}
+
+/**
+ * Constructs a new element at the end of the sequence directly from args,
+ * inside the tail block when it has room or in a fresh block otherwise. No
+ * temporary element is created.
+ *
+ * @param args Arguments forwarded to the constructor of T.
+ * @return Reference to the new element.
+ */
+template<class T, class Alloc>
+template<class... Args>
+T &BasicSequence<T, Alloc>::emplace_back(Args &&... args) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::PUSH_BACK);
+    unshare();
+    if (tail != nullptr && tail->count < Node::CAPACITY) {
+        ownChunk(tail);
+        // The tail is on the right spine, so no leftWeight changes
+        if (tail->start + tail->count == Node::CAPACITY) {
+            // A lone head pushed onto from the front: leave room on both sides,
+            // building the element first since args may name one that moves
+            T item(std::forward<Args>(args)...);
+            moveStart(tail, (Node::CAPACITY - tail->count) / 2);
+            new(&tail->elements()[tail->count]) T(std::move(item));
+        } else {
+            new(&tail->elements()[tail->count]) T(std::forward<Args>(args)...);
+        }
+        tail->count++;
+        numElts++;
+        if (index) {
+            index->pushed(tail->elements()[tail->count - 1], tail);
+        }
+        return tail->elements()[tail->count - 1];
+    }
+
+    Node *node = newNode();
+    try {
+        new(&node->elements()[0]) T(std::forward<Args>(args)...);
+    } catch (...) {
+        deleteNode(node); // nothing was linked in yet
+        throw;
+    }
+    node->count = 1;
+    appendNode(node);
+    if (index) {
+        index->pushed(node->elements()[0], node);
+    }
+    return node->elements()[0];
+}
+
+/**
+ * Removes last element of the sequence. This destroys the last element of
+ * the tail block and decreases the sequence by one, deleting the block once
+ * it is empty. Throws an exception if the list is empty.
+ *
+ * @throws std::out_of_range if the sequence is empty.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::pop_back() {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::POP_BACK);
+    // An exception if there is no head and thus rest of the s
+    if (head == nullptr) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    unshare();
+    ownChunk(tail);
+    if (index) {
+        index->popped(tail->elements()[tail->count - 1]);
+    }
+
+    tail->count--;
+    tail->elements()[tail->count].~T();
+
+    if (tail->count == 0) {
+        Node *oldTail = tail; // initialize old tail reference
+        tail = tail->prev; // move tail back one node
+        if (tail != nullptr) {
+            tail->next = nullptr; // Tail now points to end
+        } else {
+            head = nullptr; // It was the only node
+        }
+
+        // The tail never has a right child, so its left subtree takes its place
+        Node *above = oldTail->parent;
+        if (oldTail->left != nullptr) {
+            oldTail->left->parent = above;
+        }
+        if (above != nullptr) {
+            above->right = oldTail->left;
+        } else {
+            root = oldTail->left;
+        }
+
+        deleteNode(oldTail); // Delete old tail to prevent leak
+    }
+
+    numElts--; // Decrement element count
+}
+
+/**
+ * Adds an element to the front of the sequence.
+ *
+ * @param item The value to prepend.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::push_front(T item) {
+    emplace_front(std::move(item));
+}
+
+/**
+ * Constructs a new element at the front of the sequence, in the free slot
+ * just before the head block's start. The head keeps its elements at the
+ * end of its chunk, so only a head that last grew at the back slides them
+ * up once; when the head is full a new block holding just the element in
+ * its last slot is linked in before it, so a run of push_front calls fills
+ * whole blocks, as push_back does.
+ *
+ * @param args Arguments forwarded to the constructor of T.
+ * @return Reference to the new element.
+ */
+template<class T, class Alloc>
+template<class... Args>
+T &BasicSequence<T, Alloc>::emplace_front(Args &&... args) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::PUSH_FRONT);
+    if (head == nullptr) {
+        return emplace_back(std::forward<Args>(args)...);
+    }
+    unshare();
+
+    T *slot;
+    if (head->count == Node::CAPACITY) {
+        Node *node = newNode();
+        node->start = Node::CAPACITY - 1; // right-aligned for the next push_front
+        try {
+            new(&node->elements()[0]) T(std::forward<Args>(args)...);
+        } catch (...) {
+            deleteNode(node); // nothing was linked in yet
+            throw;
+        }
+        node->count = 1;
+        node->next = head;
+        head->prev = node;
+        head = node;
+        indexInsert(0, node);
+        numElts++;
+        if (finger.load(std::memory_order_relaxed) != nullptr) {
+            // every other block moved up one
+            fingerStart.store(fingerStart.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        slot = &node->elements()[0];
+    } else {
+        ownChunk(head);
+        if (head->start == 0) {
+            // Right-align the head, or centre a lone one that is also the tail,
+            // building the element first since args may name one that moves
+            T item(std::forward<Args>(args)...);
+            moveStart(head, head == tail ? (Node::CAPACITY - head->count + 1) / 2
+                                         : Node::CAPACITY - head->count);
+            slot = head->elements() - 1;
+            new(slot) T(std::move(item));
+        } else {
+            slot = head->elements() - 1;
+            new(slot) T(std::forward<Args>(args)...);
+        }
+        head->start--;
+        head->count++;
+        adjustWeight(head, 1);
+        const Node *cached = finger.load(std::memory_order_relaxed);
+        if (cached != nullptr && cached != head) {
+            fingerStart.store(fingerStart.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        numElts++;
+    }
+    if (index) {
+        index->inserted(*slot, head);
+    }
+    return *slot;
+}
+
+/**
+ * Removes the first element of the sequence by moving the head block's
+ * start past it, without shifting the rest. The head is not merged with its neighbour when it runs low,
+ * only deleted once empty, so draining a sequence from the front (a queue)
+ * never moves elements between blocks.
+ *
+ * @throws std::out_of_range if the sequence is empty.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::pop_front() {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::POP_FRONT);
+    if (head == nullptr) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    unshare();
+    ownChunk(head);
+
+    T *items = head->elements();
+    if (index) {
+        if (numElts == 1) {
+            index->popped(items[0]);
+        } else {
+            index->erased(items[0], head);
+        }
+    }
+    items[0].~T();
+    head->start++;
+    head->count--;
+    adjustWeight(head, -1);
+    const Node *cached = finger.load(std::memory_order_relaxed);
+    if (cached != nullptr && cached != head) {
+        fingerStart.store(fingerStart.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+    numElts--;
+
+    if (head->count == 0) {
+        removeNode(head);
+    }
+}
+
+/**
+ * Inserts a new element holding the item at the provided position in sequence.
+ * Shifts the other elements of its block so that they "fit around" the new
+ * element, splitting the block first if it is full. Throws an exception if
+ * position is invalid. Inserting at position numElts appends the item.
+ *
+ * @param position The specified index where the new item should be inserted.
+ * @param item The value to insert
+ * @throws std::out_of_range if position > numElts
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::insert(size_t position, T item) {
+    emplace(position, std::move(item));
+}
+
+/**
+ * Constructs a new element from args and moves it into position, shifting
+ * the rest of its block like insert. Emplacing at position numElts is the
+ * same as emplace_back, and at position 0 the same as emplace_front.
+ *
+ * @param position Index the new element will have.
+ * @param args Arguments forwarded to the constructor of T.
+ * @return Reference to the new element.
+ * @throws std::out_of_range if position > numElts
+ */
+template<class T, class Alloc>
+template<class... Args>
+T &BasicSequence<T, Alloc>::emplace(size_t position, Args &&... args) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::INSERT);
+    if (position > numElts) {
+        throw std::out_of_range("Position is out of range");
+    }
+    if (position == numElts) {
+        return emplace_back(std::forward<Args>(args)...);
+    }
+    if (position == 0) {
+        return emplace_front(std::forward<Args>(args)...);
+    }
+    unshare();
+
+    T item(std::forward<Args>(args)...); // built before the list changes
+    size_t offset;
+    Node *current = nodeAt(position, offset);
+    T *slot = openSlot(current, offset);
+    *slot = std::move(item);
+    if (index) {
+        index->inserted(*slot, current);
+    }
+    return *slot;
+}
+
+/**
+ * Constructs a new element from args and moves it in before pos. The block
+ * is found through the iterator, so only the block shift and the index
+ * count update remain: O(CAPACITY + log n) instead of a descent from the
+ * root. Emplacing before end() is the same as emplace_back, and before
+ * begin() the same as emplace_front.
+ *
+ * @param pos Iterator to the element the new one goes before.
+ * @param args Arguments forwarded to the constructor of T.
+ * @return Iterator to the new element.
+ */
+template<class T, class Alloc>
+template<class... Args>
+typename BasicSequence<T, Alloc>::iterator BasicSequence<T, Alloc>::emplace(const_iterator pos, Args &&... args) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::INSERT);
+    pos = unshareAt(pos);
+    if (pos == cend()) {
+        emplace_back(std::forward<Args>(args)...);
+        return iterator(tail, tail->count - 1);
+    }
+    if (pos.node == head && pos.offset == 0) {
+        emplace_front(std::forward<Args>(args)...);
+        return iterator(head, 0);
+    }
+
+    T item(std::forward<Args>(args)...); // built before the list changes
+    Node *current = const_cast<Node *>(pos.node);
+    size_t offset = pos.offset;
+    T *slot = openSlot(current, offset);
+    *slot = std::move(item);
+    if (index) {
+        index->inserted(*slot, current);
+    }
+    return iterator(current, offset);
+}
+
+/**
+ * Gives a shared sequence its own block headers and re-points pos, which
+ * may point into the shared ones, at the same place in the new ones.
+ *
+ * @param pos Iterator into this sequence.
+ * @return Iterator to the same position, safe to change through.
+ */
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::const_iterator BasicSequence<T, Alloc>::unshareAt(const_iterator pos) {
+    if (shared.load(std::memory_order_relaxed) == nullptr) {
+        unshare(); // nothing to detach, but writes may need settling
+        return pos;
+    }
+
+    const size_t index = pos == cend() ? numElts : indexOf(pos.node) + pos.offset;
+    unshare();
+    if (index == numElts) {
+        return cend();
+    }
+    size_t offset;
+    Node *node = nodeAt(index, offset);
+    return const_iterator(node, offset);
+}
+
+/**
+ * Inserts an element before pos. See emplace(const_iterator, args...).
+ *
+ * @param pos Iterator to the element the new one goes before.
+ * @param item The value to insert.
+ * @return Iterator to the new element.
+ */
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::iterator BasicSequence<T, Alloc>::insert(const_iterator pos, T item) {
+    return emplace(pos, std::move(item));
+}
+
+/**
+ * Returns the index of a block's first element by walking up the index and
+ * adding everything that sits to its left. O(log n) expected.
+ *
+ * @param node Block in this sequence.
+ * @return Index of node's first element.
+ */
+template<class T, class Alloc>
+size_t BasicSequence<T, Alloc>::indexOf(const Node *node) const {
+    size_t index = node->leftWeight;
+    for (const Node *child = node, *above = node->parent; above != nullptr;
+         child = above, above = above->parent) {
+        SEQUENCE_PROFILE_HOPS(1);
+        if (above->right == child) {
+            index += above->leftWeight + above->count;
+        }
+    }
+    return index;
+}
+
+/**
+ * Opens a slot for a new element at slot offset of node. The block is split
+ * first if it is full, the rest of the block shifts right (or, in a head
+ * with room in front, the elements before the slot shift left), and the
+ * counts are updated. The returned slot holds a moved-from element that the caller
+ * assigns the new value to.
+ *
+ * @param node Block the element goes into; updated if the slot moves.
+ * @param offset Slot the element goes into; updated if the slot moves.
+ * @return The slot for the new element.
+ */
+template<class T, class Alloc>
+T *BasicSequence<T, Alloc>::openSlot(Node *&node, size_t &offset) {
+    Node *current = node;
+    ownChunk(current);
+    if (current->count == Node::CAPACITY) {
+        splitNode(current, indexOf(current), current->count / 2);
+        if (offset >= current->count) {
+            // The slot moved to the new block
+            offset -= current->count;
+            current = current->next;
+        }
+    }
+
+    T *items = current->elements();
+    if (current->start != 0 && offset != 0) {
+        // A head with room in front: open the slot by shifting the elements before it left
+        if constexpr (TRIVIAL) {
+            std::memmove(static_cast<void *>(items - 1), static_cast<const void *>(items), offset * sizeof(T));
+        } else {
+            new(&items[-1]) T(std::move(items[0]));
+            std::move(items + 1, items + offset, items);
+        }
+        current->start--;
+        items--;
+    } else {
+        if (current->start + current->count == Node::CAPACITY) {
+            moveStart(current, current->start - 1); // a head with no room after its elements
+            items = current->elements();
+        }
+        // Open a slot at offset by shifting the rest of the block right
+        if constexpr (TRIVIAL) {
+            std::memmove(static_cast<void *>(items + offset + 1), static_cast<const void *>(items + offset),
+                         (current->count - offset) * sizeof(T));
+        } else {
+            new(&items[current->count]) T(std::move(items[current->count - 1]));
+            std::move_backward(items + offset, items + current->count - 1, items + current->count);
+        }
+    }
+
+    current->count++;
+    adjustWeight(current, 1);
+    shiftFinger(current, 1);
+    numElts++;
+    node = current;
+    return &items[offset];
+}
+
+/**
+ * Returns the first element in the sequence.
+ *
+ * @return Reference to the string stored at the front of the head node.
+ * @throws std::out_of_range if the sequence is null.
+ */
+template<class T, class Alloc>
+T &BasicSequence<T, Alloc>::front() {
+    if (head == nullptr) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    prepareAccess();
+    return handOut(head, 0);
+}
+
+/**
+ * Returns the first element in the sequence without allowing changes.
+ *
+ * @return Const reference to the string stored at the front of the head node.
+ * @throws std::out_of_range if the sequence is null.
+ */
+template<class T, class Alloc>
+const T &BasicSequence<T, Alloc>::front() const {
+    if (head == nullptr) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    return head->elements()[0];
+}
+
+/**
+ * Returns the last element in the sequence.
+ *
+ * @return Reference to the string stored at the end of the tail node
+ * @throws std::out_of_range if sequence is null.
+ */
+template<class T, class Alloc>
+T &BasicSequence<T, Alloc>::back() {
+    if (tail == nullptr) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    prepareAccess();
+    return handOut(tail, tail->count - 1);
+}
+
+/**
+ * Returns the last element in the sequence without allowing changes.
+ *
+ * @return Const reference to the string stored at the end of the tail node
+ * @throws std::out_of_range if sequence is null.
+ */
+template<class T, class Alloc>
+const T &BasicSequence<T, Alloc>::back() const {
+    if (tail == nullptr) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    return tail->elements()[tail->count - 1];
+}
+
+/**
+ * Checks if the sequence is empty.
+ *
+ * @return true if the sequence is empty, false otherwise.
+ */
+template<class T, class Alloc>
+bool BasicSequence<T, Alloc>::empty() const {
+    return head == nullptr && tail == nullptr;
+}
+
+/**
+ * Returns the number of elements that are currently in the sequence.
+ *
+ * @return The total number of elements.
+ */
+template<class T, class Alloc>
+size_t BasicSequence<T, Alloc>::size() const {
+    return numElts;
+}
+
+/**
+ * Returns a copy of the allocator the block pools draw their slabs from.
+ *
+ * @return The sequence's allocator.
+ */
+template<class T, class Alloc>
+Alloc BasicSequence<T, Alloc>::get_allocator() const {
+    return alloc;
+}
+
+/**
+ * Returns the counters of this sequence's arena, headers and chunks
+ * together, so callers can see how many allocations were recycled instead
+ * of hitting the global heap. A copy still sharing another sequence's
+ * blocks reports its own arena, which has not allocated anything yet.
+ *
+ * @return The block allocation counters.
+ */
+template<class T, class Alloc>
+SequencePoolStats BasicSequence<T, Alloc>::allocationStats() const {
+    SequencePoolStats result;
+    if (arena != nullptr) {
+        for (const SequencePool<Alloc> *pool : {&arena->nodes, &arena->chunks}) {
+            const SequencePoolStats &stats = pool->stats();
+            result.nodeAllocations += stats.nodeAllocations;
+            result.nodeFrees += stats.nodeFrees;
+            result.freeListReuses += stats.freeListReuses;
+            result.slabAllocations += stats.slabAllocations;
+            result.slabFrees += stats.slabFrees;
+            result.bytesReserved += stats.bytesReserved;
+        }
+    }
+    return result;
+}
+
+/**
+ * Measures the memory behind the sequence: its blocks, the slabs the arena
+ * holds for them and anything the elements allocated themselves. Shared
+ * blocks are counted by every sequence sharing them, their slabs only by
+ * the sequence whose arena they came from. O(n) for elements that can own
+ * memory, O(blocks) otherwise.
+ *
+ * @return The measurements.
+ */
+template<class T, class Alloc>
+SequenceFootprint BasicSequence<T, Alloc>::footprint() const {
+    SequenceFootprint result;
+    result.elements = numElts;
+    result.reservedBytes = allocationStats().bytesReserved;
+    for (const Node *current = head; current != nullptr; current = current->next) {
+        result.blocks++;
+        if constexpr (!std::is_trivially_copyable_v<T>) {
+            const T *items = current->elements();
+            for (size_t i = 0; i < current->count; i++) {
+                result.heapBytes += sequenceHeapBytes(items[i]);
+            }
+        }
+    }
+    result.blockBytes = result.blocks * (sizeof(Node) + sizeof(Chunk));
+    return result;
+}
+
+/**
+ * Returns the position of the first element equal to value, at or after
+ * from. With the hash index enabled this is a binary search over the
+ * blocks holding value, O(log k log n) for k occurrences, plus a scan of
+ * the block it lands in; without the index the blocks are scanned once,
+ * starting from the block that holds from.
+ *
+ * @param value Value to look for.
+ * @param from First position to consider.
+ * @return The position, or npos if there is none.
+ */
+template<class T, class Alloc>
+size_t BasicSequence<T, Alloc>::find(const T &value, size_t from) const {
+    if (from >= numElts) {
+        return npos;
+    }
+    if constexpr (SequenceHashable<T>) {
+        if (index) {
+            syncIndex(true);
+            return index->find(value, from);
+        }
+    }
+    return find_if([&value](const T &item) { return item == value; }, from);
+}
+
+/**
+ * Returns the position of the first element, at or after from, for which
+ * pred returns true. The blocks are walked directly, one pass at most.
+ *
+ * @param pred Callable taking const T&.
+ * @param from First position to consider.
+ * @return The position, or npos if there is none.
+ */
+template<class T, class Alloc>
+template<class Pred>
+size_t BasicSequence<T, Alloc>::find_if(Pred pred, size_t from) const {
+    if (from >= numElts) {
+        return npos;
+    }
+
+    size_t offset;
+    const Node *current = nodeAt(from, offset);
+    size_t position = from;
+    for (; current != nullptr; current = current->next, offset = 0) {
+        const T *items = current->elements();
+        for (size_t i = offset; i < current->count; i++, position++) {
+            if (pred(items[i])) {
+                return position;
+            }
+        }
+    }
+    return npos;
+}
+
+/**
+ * Counts the elements equal to value: O(1) expected with the hash index,
+ * one pass otherwise.
+ *
+ * @param value Value to count.
+ * @return Number of occurrences.
+ */
+template<class T, class Alloc>
+size_t BasicSequence<T, Alloc>::count(const T &value) const {
+    if constexpr (SequenceHashable<T>) {
+        if (index) {
+            syncIndex(false);
+            return index->count(value);
+        }
+    }
+
+    size_t total = 0;
+    for (const Node *current = head; current != nullptr; current = current->next) {
+        const T *items = current->elements();
+        for (size_t i = 0; i < current->count; i++) {
+            if (items[i] == value) {
+                total++;
+            }
+        }
+    }
+    return total;
+}
+
+/**
+ * Checks if any element equals value: O(1) expected with the hash index,
+ * otherwise a scan that stops at the first match.
+ *
+ * @param value Value to look for.
+ * @return true if value occurs.
+ */
+template<class T, class Alloc>
+bool BasicSequence<T, Alloc>::contains(const T &value) const {
+    if constexpr (SequenceHashable<T>) {
+        if (index) {
+            syncIndex(false);
+            return index->count(value) != 0;
+        }
+    }
+    return find(value) != npos;
+}
+
+/**
+ * Returns every position holding value, in ascending order. With the hash
+ * index enabled only the blocks holding value are located and scanned;
+ * otherwise every block is scanned once.
+ *
+ * @param value Value to look for.
+ * @return The positions; empty if value does not occur.
+ */
+template<class T, class Alloc>
+std::vector<size_t> BasicSequence<T, Alloc>::positions(const T &value) const {
+    if constexpr (SequenceHashable<T>) {
+        if (index) {
+            syncIndex(true);
+            return index->positions(value);
+        }
+    }
+
+    std::vector<size_t> found;
+    size_t position = 0;
+    for (const Node *current = head; current != nullptr; current = current->next) {
+        const T *items = current->elements();
+        for (size_t i = 0; i < current->count; i++, position++) {
+            if (items[i] == value) {
+                found.push_back(position);
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * Turns on the hash index. It is built by the first query and then kept
+ * up to date: pushes, pops, inserts and erases anywhere, block splits and
+ * merges, set() and writes through operator[], front and back maintain
+ * counts and block lists; reordering (sort, reverse, merge, and the first
+ * change after a copy) keeps the counts and drops the block lists; and
+ * anything else (non-const iterators, splicing, unique, assignment)
+ * leaves it for the next query to rebuild. Each rebuild is one O(n) pass.
+ * Copies do not carry the index.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::enableIndex() requires SequenceHashable<T> {
+    if (!index) {
+        index = std::make_unique<SequenceIndex<T>>();
+        index->invalidate(); // built by the first query
+    }
+}
+
+/**
+ * Turns off the hash index and frees it.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::disableIndex() {
+    index.reset();
+}
+
+/**
+ * Checks if the hash index is enabled.
+ *
+ * @return true after enableIndex(), until disableIndex().
+ */
+template<class T, class Alloc>
+bool BasicSequence<T, Alloc>::indexed() const {
+    return index != nullptr;
+}
+
+/**
+ * Settles writes through handed-out references and rebuilds the hash
+ * index with one pass if the parts a query needs are stale. Queries on one
+ * const sequence may call this from several threads; the index does both
+ * under its own lock. The index must be enabled.
+ *
+ * @param withPositions Whether the query needs the block lists.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::syncIndex(bool withPositions) const {
+    if constexpr (SequenceHashable<T>) {
+        index->refresh(head, withPositions);
+    }
+}
+
+/**
+ * Marks the hash index stale after a change it is not told the details
+ * of, or before handing out an iterator, through which the caller may
+ * change any element.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::touchIndex() {
+    if (index) {
+        index->invalidate();
+    }
+}
+
+/**
+ * Clears the whole sequence.
+ *
+ * Deletes all nodes in the sequence and makes it empty, returning the
+ * arena's slabs whole. After clearing, the sequence can still be reused by
+ * inserting items.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::clear() {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::CLEAR);
+    destroyNodes();
+    head = nullptr;
+    tail = nullptr;
+    root = nullptr;
+    numElts = 0;
+    unshareable = false;
+    if (index) {
+        index->clear();
+    }
+}
+
+/**
+ * Empties the sequence at once and destroys the old elements on a
+ * separate thread, so dropping a huge sequence does not stall the caller.
+ * The sequence can be used again right away. Wait on the returned future
+ * before the program exits, or before destroying the allocator, when the
+ * teardown must be complete. Alloc must be usable from another thread.
+ *
+ * @return Future that becomes ready once every old element is destroyed.
+ */
+template<class T, class Alloc>
+std::future<void> BasicSequence<T, Alloc>::clearAsync() {
+    std::promise<void> done;
+    std::future<void> result = done.get_future();
+    if (head == nullptr) {
+        done.set_value();
+        return result;
+    }
+
+    // The blocks and the slabs under them move to a sequence the thread owns
+    auto dropped = std::make_unique<BasicSequence>(std::move(*this));
+    std::thread([dropped = std::move(dropped), done = std::move(done)]() mutable {
+        dropped.reset();
+        done.set_value();
+    }).detach();
+    return result;
+}
+
+/**
+ * Writes the sequence in the binary layout described in SequenceFormat.h.
+ * Records are gathered into a 64 KiB buffer, strings larger than that go
+ * to the stream directly, and nothing else is allocated, so saving works
+ * on sequences far larger than memory would allow to copy.
+ *
+ * @param os Stream to write to; open it in binary mode.
+ * @throws std::runtime_error if the stream fails.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::save(std::ostream &os) const requires SequenceByteString<T> {
+    constexpr size_t BUFFER_BYTES = size_t(1) << 16;
+    constexpr size_t WORD = SequenceFormat::WORD_BYTES;
+    std::string buffer;
+    buffer.reserve(BUFFER_BYTES);
+    auto put = [&](const char *bytes, size_t n) {
+        if (buffer.size() + n > BUFFER_BYTES) {
+            os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+        if (n > BUFFER_BYTES) {
+            os.write(bytes, static_cast<std::streamsize>(n));
+        } else {
+            buffer.append(bytes, n);
+        }
+    };
+    auto putWord = [&](std::uint64_t value) {
+        char word[WORD];
+        SequenceFormat::putWord(word, value);
+        put(word, WORD);
+    };
+
+    put(SequenceFormat::MAGIC, WORD);
+    putWord(numElts);
+    for (const T &item : *this) {
+        putWord(item.size());
+        put(item.data(), item.size());
+    }
+
+    // The offsets follow from the lengths, so a second pass rebuilds them
+    std::uint64_t offset = SequenceFormat::HEADER_BYTES;
+    for (const T &item : *this) {
+        putWord(offset);
+        offset += WORD + item.size();
+    }
+    putWord(offset); // where the index starts
+    put(SequenceFormat::INDEX_MAGIC, WORD);
+
+    os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!os) {
+        throw std::runtime_error("Could not write the sequence");
+    }
+}
+
+/**
+ * Replaces the contents with a sequence written by save. Records are read
+ * front to back straight into their strings, and the index is only
+ * checked for its position. The sequence is unchanged if this throws.
+ *
+ * @param is Stream positioned at the start of a saved sequence; open it in
+ * binary mode.
+ * @throws std::runtime_error if the data is not a saved sequence or is cut
+ * short.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::load(std::istream &is) requires SequenceByteBuffer<T> {
+    constexpr size_t CHUNK_BYTES = size_t(1) << 20; // a bad length fails before it is allocated
+    constexpr size_t WORD = SequenceFormat::WORD_BYTES;
+    char word[WORD];
+    auto getWord = [&]() {
+        if (!is.read(word, WORD)) {
+            throw std::runtime_error("Sequence file is truncated");
+        }
+        return SequenceFormat::getWord(word);
+    };
+
+    if (!is.read(word, WORD) || std::memcmp(word, SequenceFormat::MAGIC, WORD) != 0) {
+        throw std::runtime_error("Not a sequence file");
+    }
+    const std::uint64_t count = getWord();
+
+    BasicSequence loaded(0, get_allocator());
+    std::uint64_t offset = SequenceFormat::HEADER_BYTES;
+    for (std::uint64_t i = 0; i < count; i++) {
+        const std::uint64_t length = getWord();
+        T item;
+        size_t have = 0;
+        while (have < length) {
+            size_t step = length - have < CHUNK_BYTES ? static_cast<size_t>(length - have) : CHUNK_BYTES;
+            item.resize(have + step);
+            if (!is.read(item.data() + have, static_cast<std::streamsize>(step))) {
+                throw std::runtime_error("Sequence file is truncated");
+            }
+            have += step;
+        }
+        loaded.emplace_back(std::move(item));
+        offset += WORD + length;
+    }
+
+    if (!is.ignore(static_cast<std::streamsize>(count * WORD)) || getWord() != offset
+        || !is.read(word, WORD) || std::memcmp(word, SequenceFormat::INDEX_MAGIC, WORD) != 0) {
+        throw std::runtime_error("Sequence file index is damaged");
+    }
+    *this = std::move(loaded);
+}
+
+/**
+ * Returns the number of characters operator<< writes for this sequence:
+ * the brackets, every element and a ", " between neighbours.
+ *
+ * @return Length of the text.
+ */
+template<class T, class Alloc>
+size_t BasicSequence<T, Alloc>::formattedSize() const requires SequenceByteString<T> {
+    size_t total = 2 + (numElts > 0 ? 2 * (numElts - 1) : 0);
+    for (const Node *current = head; current != nullptr; current = current->next) {
+        const T *items = current->elements();
+        for (size_t i = 0; i < current->count; i++) {
+            total += items[i].size();
+        }
+    }
+    return total;
+}
+
+/**
+ * Produces the same text as operator<< and hands it to sink as
+ * sink(const char *bytes, size_t n). Text is gathered in a buffer on the
+ * stack and passed on whenever that fills, and elements larger than the
+ * buffer are passed on as they are, so nothing is allocated. A sequence
+ * whose text fits in the buffer reaches sink in a single call. To build
+ * a string, reserve formattedSize() characters and append in sink.
+ *
+ * @param sink Callable taking (const char *, size_t).
+ */
+template<class T, class Alloc>
+template<class Sink>
+void BasicSequence<T, Alloc>::format(Sink &&sink) const requires SequenceByteString<T> {
+    constexpr size_t BUFFER_BYTES = 8192;
+    char buffer[BUFFER_BYTES];
+    size_t used = 0;
+    auto put = [&](const char *bytes, size_t n) {
+        if (used + n > BUFFER_BYTES) {
+            if (used > 0) {
+                sink(static_cast<const char *>(buffer), used);
+                used = 0;
+            }
+            if (n > BUFFER_BYTES) {
+                sink(bytes, n);
+                return;
+            }
+        }
+        std::memcpy(buffer + used, bytes, n);
+        used += n;
+    };
+
+    put("<", 1);
+    for (const Node *current = head; current != nullptr; current = current->next) {
+        const T *items = current->elements();
+        for (size_t i = 0; i < current->count; i++) {
+            if (i > 0 || current != head) {
+                put(", ", 2);
+            }
+            put(items[i].data(), items[i].size());
+        }
+    }
+    put(">", 1);
+    sink(static_cast<const char *>(buffer), used);
+}
+
+#if SEQUENCE_HAS_UNISTD
+/**
+ * Writes the text operator<< produces straight to a file descriptor, one
+ * write per buffer of text, bypassing iostreams. Partial writes are
+ * resumed.
+ *
+ * @param fd Open file descriptor, e.g. STDOUT_FILENO or a log file.
+ * @throws std::runtime_error if a write fails.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::print(int fd) const requires SequenceByteString<T> {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::PRINT);
+    format([fd](const char *bytes, size_t n) {
+        while (n > 0) {
+            ssize_t written = ::write(fd, bytes, n);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Could not write the sequence");
+            }
+            bytes += written;
+            n -= static_cast<size_t>(written);
+        }
+    });
+}
+#endif
+
+/**
+ * Removes one element from a specified position. It destroys the element
+ * inside its block and shifts the rest of the block down. An emptied block
+ * is deleted, and a sparse block is merged with its neighbour when the two
+ * fit in one block. Throws an exception if the position is invalid.
+ *
+ * @param position The index of the element to remove.
+ * @throws std::out_of_range if position >= numElts.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::erase(size_t position) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::ERASE);
+    if (position >= numElts) {
+        throw std::out_of_range("Position is out of range");
+    }
+    unshare();
+
+    size_t offset;
+    Node *current = nodeAt(position, offset);
+    eraseSlot(current, offset);
+}
+
+/**
+ * Removes the element at pos without searching for it: O(CAPACITY + log n)
+ * for the block shift and the index count update.
+ *
+ * @param pos Iterator to the element to remove; must not be end().
+ * @return Iterator to the element that followed the removed one.
+ */
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::iterator BasicSequence<T, Alloc>::erase(const_iterator pos) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::ERASE);
+    pos = unshareAt(pos);
+    Node *current = const_cast<Node *>(pos.node);
+    size_t offset = pos.offset;
+    eraseSlot(current, offset);
+
+    if (current == nullptr) {
+        return end();
+    }
+    if (offset == current->count && current->next != nullptr) {
+        return iterator(current->next, 0);
+    }
+    return iterator(current, offset);
+}
+
+/**
+ * Destroys the element in slot offset of node and shifts the rest of the
+ * block down. An emptied block is deleted, and a sparse one is merged into
+ * a neighbour. Afterwards node and offset name the element that followed
+ * the removed one (offset may equal node->count), or node is nullptr if the
+ * removed element was the last one of the sequence and its block is gone.
+ *
+ * @param node Block holding the element.
+ * @param offset Slot of the element.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::eraseSlot(Node *&node, size_t &offset) {
+    Node *current = node;
+    ownChunk(current);
+
+    // Re-structure the block FIRST
+    T *items = current->elements();
+    if (index) {
+        if (current == tail && offset + 1 == current->count) {
+            index->popped(items[offset]);
+        } else {
+            index->erased(items[offset], current);
+        }
+    }
+    if constexpr (TRIVIAL) {
+        std::memmove(static_cast<void *>(items + offset), static_cast<const void *>(items + offset + 1),
+                     (current->count - offset - 1) * sizeof(T));
+        current->count--;
+    } else {
+        std::move(items + offset + 1, items + current->count, items + offset);
+        current->count--;
+        items[current->count].~T();
+    }
+    adjustWeight(current, -1);
+    shiftFinger(current, -1);
+    numElts--; // Delete element and decrement list by one
+
+    if (current->count == 0) {
+        node = current->next != nullptr ? current->next : current->prev;
+        offset = current->next != nullptr ? 0 : (node != nullptr ? node->count : 0);
+        removeNode(current);
+    } else {
+        mergeIfSparse(node, offset); // Keep blocks dense
+    }
+}
+
+/**
+ * Removes all nodes starting at the given position and continues to the
+ * next counted elements. Will delete multiple elements in the sequence.
+ * The run is located once and cut out of the list and index as a whole,
+ * then its blocks are freed in one pass, so this costs O(log n + count)
+ * instead of one erase per element.
+ *
+ * @param position The starting index of removal.
+ * @param count The number of consecutive elements to delete.
+ * @throws std::out_of_range if position + count exceeds limit.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::erase(size_t position, size_t count) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::ERASE_RANGE);
+    if (position >= numElts || count > numElts - position) {
+        throw std::out_of_range("Position and/or count is out of range");
+    }
+    if (count == 0) {
+        return;
+    }
+    unshare();
+
+    Node *current = cutRange(position, count);
+    while (current != nullptr) {
+        Node *newPointer = current->next;
+        deleteNode(current); // Slots go back to the arena's free lists
+        current = newPointer;
+    }
+
+    // The cut can leave a partial block on each side of the gap
+    if (position > 0 && position < numElts) {
+        size_t offset;
+        Node *after = nodeAt(position, offset);
+        if (after->prev->count + after->count <= Node::CAPACITY) {
+            mergeNext(after->prev);
+        }
+    }
+}
+
+/**
+ * Inserts copies of the elements in [first, last) starting at position. The
+ * elements are gathered into blocks of their own first and then spliced in,
+ * so the list is only walked once.
+ *
+ * @param position Index the first new element will have.
+ * @param first Start of the range to insert.
+ * @param last End of the range to insert.
+ * @throws std::out_of_range if position > numElts
+ */
+template<class T, class Alloc>
+template<std::input_iterator InputIt>
+void BasicSequence<T, Alloc>::insert(size_t position, InputIt first, InputIt last) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::SPLICE);
+    if (position > numElts) {
+        throw std::out_of_range("Position is out of range");
+    }
+
+    BasicSequence items(0, get_allocator());
+    items.append(first, last);
+    splice(position, std::move(items));
+}
+
+/**
+ * Appends copies of the elements in [first, last). Blocks are filled
+ * completely before being linked in, and when the size of the range is
+ * known up front the arena allocates every block in one slab. If an
+ * element's constructor throws, the elements before it stay appended.
+ * The range must not come from this sequence.
+ *
+ * @param first Start of the range to append.
+ * @param last End of the range.
+ */
+template<class T, class Alloc>
+template<std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+void BasicSequence<T, Alloc>::append(InputIt first, Sentinel last) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::PUSH_BACK);
+    if constexpr (std::sized_sentinel_for<Sentinel, InputIt>) {
+        reserve(numElts + static_cast<size_t>(last - first));
+    }
+    appendEach([&] { return first != last; }, [&](T *slot) {
+        new(slot) T(*first);
+        ++first;
+    });
+}
+
+/**
+ * Appends copies of a list of elements, e.g. s.append({"a", "b", "c"}).
+ *
+ * @param items Elements to append.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::append(std::initializer_list<T> items) {
+    append(items.begin(), items.end());
+}
+
+/**
+ * Replaces the contents with copies of the elements of range, reusing the
+ * append fast path. The range must not come from this sequence.
+ *
+ * @param range Any input range whose elements T can be constructed from.
+ */
+template<class T, class Alloc>
+template<std::ranges::input_range Range>
+void BasicSequence<T, Alloc>::assign(Range &&range) {
+    clear();
+    if constexpr (std::ranges::sized_range<Range>) {
+        reserve(static_cast<size_t>(std::ranges::size(range)));
+    }
+    append(std::ranges::begin(range), std::ranges::end(range));
+}
+
+/**
+ * Allocates the blocks needed to hold n elements in total, in one slab,
+ * so appending up to n elements then makes no upstream allocations. Does
+ * nothing if the sequence already has room for n elements.
+ *
+ * @param n Number of elements to make room for.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::reserve(size_t n) {
+    const size_t room = numElts + (tail != nullptr ? Node::CAPACITY - tail->count : 0);
+    if (n <= room) {
+        return;
+    }
+    unshare();
+    const size_t blocks = (n - room + Node::CAPACITY - 1) / Node::CAPACITY;
+    ownArena()->nodes.reserve(blocks);
+    arena->chunks.reserve(blocks);
+}
+
+/**
+ * Moves every element of other into this sequence starting at position.
+ * other's blocks are relinked as they are, staying in other's arena until
+ * they are freed, so no element is touched and the cost is O(log n) for
+ * the cut and the index join. If the allocators differ the elements are
+ * moved one at a time instead. other is left empty.
+ *
+ * @param position Index the first element of other will have.
+ * @param other Sequence whose elements are moved in.
+ * @throws std::out_of_range if position > numElts
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::splice(size_t position, BasicSequence &&other) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::SPLICE);
+    if (position > numElts) {
+        throw std::out_of_range("Position is out of range");
+    }
+    if (this == &other || other.empty()) {
+        return;
+    }
+    unshare();
+    other.unshare(); // its blocks are about to be relinked into this list
+
+    if (!canTake(other)) {
+        other.ownAll(); // its elements are moved out
+        size_t at = position;
+        for (Node *current = other.head; current != nullptr; current = current->next) {
+            for (size_t i = 0; i < current->count; i++) {
+                emplace(at++, std::move(current->elements()[i]));
+            }
+        }
+        other.clear();
+        return;
+    }
+
+    if (position == 0) {
+        normalizeHead(); // only the new head may keep a start offset
+    } else {
+        other.normalizeHead();
+    }
+    Node *after = splitAt(position);
+    Node *before = after != nullptr ? after->prev : tail;
+    Node *first = other.head;
+    Node *last = other.tail;
+    const size_t added = other.numElts;
+
+    // Join the index: [0, position) + other + [position, numElts)
+    Node *l;
+    Node *r;
+    split(root, position, l, r);
+    root = merge(merge(l, position, other.root), position + added, r);
+    root->parent = nullptr;
+
+    // Join the list
+    first->prev = before;
+    if (before != nullptr) {
+        before->next = first;
+    } else {
+        head = first;
+    }
+    last->next = after;
+    if (after != nullptr) {
+        after->prev = last;
+    } else {
+        tail = last;
+    }
+    numElts += added;
+    finger.store(nullptr, std::memory_order_relaxed); // every block after the seam moved
+    lent = true; // the blocks of each arena are now spread over both sequences
+    mixed = mixed || other.mixed;
+    other.lent = true;
+
+    other.head = nullptr;
+    other.tail = nullptr;
+    other.root = nullptr;
+    other.numElts = 0;
+    other.finger.store(nullptr, std::memory_order_relaxed);
+    if (other.index) {
+        other.index->clear();
+    }
+    touchIndex(); // other's elements were not counted
+
+    // Fold partial blocks together across the two seams
+    if (before != nullptr && before->count + first->count <= Node::CAPACITY) {
+        if (last == first) {
+            last = before;
+        }
+        mergeNext(before);
+    }
+    if (after != nullptr && last->count + after->count <= Node::CAPACITY) {
+        mergeNext(last);
+    }
+}
+
+/**
+ * Merges the sorted run b into the sorted run a, which directly precedes
+ * it. Ties are taken from a, so the merge is stable. If every element of
+ * b is already >= the end of a, the runs are just chained. Otherwise
+ * elements are moved into output blocks, and each source block goes onto
+ * the spare list once it is drained, to be used again as an output block.
+ * The output never needs more blocks than the input, so two spares are
+ * enough and the arena is never touched: this can run on a worker thread.
+ *
+ * If comp throws, the rest of both runs is moved into the output without
+ * further comparisons before the exception is rethrown, so a still ends
+ * up holding every element.
+ *
+ * @param a Earlier run; receives the merged run.
+ * @param b Later run; left empty ({nullptr, nullptr}).
+ * @param comp Less-than comparison.
+ * @param spare Chain of empty blocks, linked through next; at least two.
+ * Drained blocks are added to it.
+ */
+template<class T, class Alloc>
+template<class Compare>
+void BasicSequence<T, Alloc>::mergeRuns(Run &a, Run &b, Compare &comp, Node *&spare) {
+    if (!comp(b.first->elements()[0], a.last->elements()[a.last->count - 1])) {
+        a.last->next = b.first; // already in order
+        a.last = b.last;
+        b = Run{nullptr, nullptr};
+        return;
+    }
+
+    Node *first = spare;
+    spare = spare->next;
+    first->next = nullptr;
+    Node *out = first;
+
+    Node *x = a.first;
+    Node *y = b.first;
+    a = Run{first, first};
+    b = Run{nullptr, nullptr};
+    size_t xi = 0;
+    size_t yi = 0;
+    auto take = [&](Node *&from, size_t &i) {
+        if (out->count == Node::CAPACITY) {
+            Node *fresh = spare;
+            spare = spare->next;
+            fresh->next = nullptr;
+            out->next = fresh;
+            out = fresh;
+        }
+        T &item = from->elements()[i];
+        new(&out->elements()[out->count]) T(std::move(item));
+        item.~T();
+        out->count++;
+        a.last = out;
+        if (++i == from->count) {
+            Node *drained = from;
+            from = from->next;
+            i = 0;
+            drained->count = 0;
+            drained->next = spare;
+            spare = drained;
+        }
+    };
+
+    try {
+        while (x != nullptr && y != nullptr) {
+            if (comp(y->elements()[yi], x->elements()[xi])) {
+                take(y, yi);
+            } else {
+                take(x, xi);
+            }
+        }
+    } catch (...) {
+        while (x != nullptr) {
+            take(x, xi);
+        }
+        while (y != nullptr) {
+            take(y, yi);
+        }
+        throw;
+    }
+    while (x != nullptr) {
+        take(x, xi);
+    }
+    while (y != nullptr) {
+        take(y, yi);
+    }
+}
+
+/**
+ * Merges adjacent runs pairwise, pass after pass, until one is left, then
+ * links the result back in as the sequence. The merges of one pass are
+ * independent, so large sequences split them across worker threads; the
+ * spare blocks each worker needs are taken from the arena up front and the
+ * ones left over are given back afterwards, both on this thread.
+ *
+ * If a comparison throws, the pass stops, the runs are linked back in
+ * their current order and the exception is rethrown: every
+ * element is kept, in an unspecified order.
+ *
+ * @param runs Sorted runs, in sequence order; emptied.
+ * @param comp Less-than comparison; called from several threads at once
+ * for large sequences.
+ */
+template<class T, class Alloc>
+template<class Compare>
+void BasicSequence<T, Alloc>::mergeAll(std::vector<Run> &runs, Compare &comp) {
+    const unsigned maxWorkers = workersFor(numElts);
+    std::exception_ptr error;
+    while (runs.size() > 1 && error == nullptr) {
+        const size_t pairs = runs.size() / 2;
+        const unsigned workers = maxWorkers < pairs ? maxWorkers : static_cast<unsigned>(pairs);
+        std::vector<Node *> spares(workers, nullptr); // one chain per worker
+        try {
+            for (unsigned w = 0; w < workers; w++) {
+                for (int i = 0; i < 2; i++) {
+                    Node *node = newNode();
+                    node->next = spares[w];
+                    spares[w] = node;
+                }
+            }
+            std::atomic<unsigned> nextWorker{0};
+            forEachChunk(pairs, workers, [&](size_t begin, size_t end) {
+                Node *&spare = spares[nextWorker.fetch_add(1, std::memory_order_relaxed)];
+                for (size_t p = begin; p < end; p++) {
+                    mergeRuns(runs[2 * p], runs[2 * p + 1], comp, spare);
+                }
+            });
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        // Drop the runs merged into their neighbour; after an exception
+        // the pairs not reached yet are kept as they are
+        size_t kept = 0;
+        for (const Run &run : runs) {
+            if (run.first != nullptr) {
+                runs[kept++] = run;
+            }
+        }
+        runs.resize(kept);
+
+        for (Node *spare : spares) {
+            while (spare != nullptr) {
+                Node *following = spare->next;
+                deleteNode(spare); // empty: nothing to destroy
+                spare = following;
+            }
+        }
+    }
+
+    relinkRuns(runs);
+    runs.clear();
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * Makes the list and the position index from the given chains of blocks,
+ * in order. Every block must already hold its elements; the old links and
+ * index are discarded.
+ *
+ * @param runs Chains of blocks, each linked through next and ending with
+ * nullptr.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::relinkRuns(const std::vector<Run> &runs) {
+    head = nullptr;
+    tail = nullptr;
+    root = nullptr;
+    numElts = 0;
+    finger.store(nullptr, std::memory_order_relaxed);
+    for (const Run &run : runs) {
+        Node *node = run.first;
+        while (node != nullptr) {
+            Node *following = node->next;
+            node->next = nullptr;
+            node->prev = nullptr;
+            node->parent = nullptr;
+            node->left = nullptr;
+            node->right = nullptr;
+            node->leftWeight = 0;
+            appendNode(node);
+            node = following;
+        }
+    }
+}
+
+/**
+ * Sorts the elements so that comp never finds one less than an earlier
+ * one, keeping equal elements in their original order. O(n log n) moves
+ * and no element copies.
+ *
+ * Each block is sorted in place first; the blocks are then merged pairwise
+ * as runs, moving elements into drained blocks, so the extra memory is a
+ * couple of blocks rather than a second copy of the sequence. Runs that
+ * are already in order are chained without touching their elements, which
+ * makes sorting sorted or nearly sorted input O(n). Large sequences sort
+ * their blocks and run the merges of each pass on several threads, so
+ * comp must then be safe to call concurrently.
+ *
+ * If comp throws, the sequence keeps its size but its elements are left in
+ * an unspecified order and may have been moved from.
+ *
+ * @param comp Less-than comparison, a strict weak ordering.
+ */
+template<class T, class Alloc>
+template<class Compare>
+void BasicSequence<T, Alloc>::sort(Compare comp) {
+    static_assert(std::is_nothrow_move_constructible_v<T>, "sort moves elements between blocks");
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::SORT);
+    if (numElts < 2) {
+        return;
+    }
+    ownAll();
+    normalizeHead(); // merged runs refill blocks from their first slot
+    if (index) {
+        index->reordered();
+    }
+
+    std::vector<Node *> nodes;
+    for (Node *current = head; current != nullptr; current = current->next) {
+        nodes.push_back(current);
+    }
+    forEachChunk(nodes.size(), workersFor(numElts), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            T *items = nodes[i]->elements();
+            if (!std::is_sorted(items, items + nodes[i]->count, comp)) {
+                std::stable_sort(items, items + nodes[i]->count, comp);
+            }
+        }
+    });
+
+    std::vector<Run> runs;
+    runs.reserve(nodes.size());
+    for (Node *node : nodes) {
+        node->next = nullptr;
+        runs.push_back(Run{node, node});
+    }
+    mergeAll(runs, comp);
+}
+
+/**
+ * Moves every element of other into this sequence, both sorted by comp,
+ * keeping the result sorted. Equal elements of this sequence come before
+ * those of other. O(n + m), or O(1) moves when other's elements all belong
+ * after this sequence's. other's blocks are reused, as with splice; if the
+ * allocators differ the elements are moved one at a time first. other is
+ * left empty.
+ *
+ * If comp throws, every element ends up in this sequence in an unspecified
+ * order.
+ *
+ * @param other Sorted sequence whose elements are moved in.
+ * @param comp Less-than comparison both sequences are sorted by.
+ */
+template<class T, class Alloc>
+template<class Compare>
+void BasicSequence<T, Alloc>::merge(BasicSequence &&other, Compare comp) {
+    static_assert(std::is_nothrow_move_constructible_v<T>, "merge moves elements between blocks");
+    if (this == &other || other.empty()) {
+        return;
+    }
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::SORT);
+    unshare();
+    other.unshare(); // its blocks are about to be relinked into this list, or moved out
+    if (empty() || !canTake(other)) {
+        // Nothing to merge into, or other's blocks cannot be reused: join
+        // the two and let the stable sort interleave them
+        const bool sorted = empty();
+        splice(numElts, std::move(other));
+        if (!sorted) {
+            sort(comp);
+        }
+        return;
+    }
+    ownAll(); // elements move between the blocks of both
+    other.ownAll();
+    normalizeHead(); // merged runs refill blocks from their first slot
+    other.normalizeHead();
+    lent = true;
+    other.lent = true;
+
+    std::vector<Run> runs{Run{head, tail}, Run{other.head, other.tail}};
+    numElts += other.numElts; // sizes the worker count; relinkRuns recounts
+    other.head = nullptr;
+    other.tail = nullptr;
+    other.root = nullptr;
+    other.numElts = 0;
+    other.finger.store(nullptr, std::memory_order_relaxed);
+    if (other.index) {
+        other.index->clear();
+    }
+    touchIndex(); // other's elements were not counted
+    mergeAll(runs, comp);
+}
+
+/**
+ * Removes every element equal to the one before it, keeping the first of
+ * each group, in one pass: the kept elements are moved forward in place
+ * and the surplus is cut from the end. O(n).
+ *
+ * If same throws, the elements already passed may have been moved from.
+ *
+ * @param same Equality predicate, called as same(kept, next).
+ * @return Number of elements removed.
+ */
+template<class T, class Alloc>
+template<class BinaryPredicate>
+size_t BasicSequence<T, Alloc>::unique(BinaryPredicate same) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::SORT);
+    if (numElts < 2) {
+        return 0;
+    }
+    ownAll();
+    touchIndex();
+
+    Node *out = head; // the last kept element is out->elements()[outAt]
+    size_t outAt = 0;
+    size_t kept = 1;
+    for (Node *current = head; current != nullptr; current = current->next) {
+        T *items = current->elements();
+        for (size_t i = current == head ? 1 : 0; i < current->count; i++) {
+            if (same(out->elements()[outAt], items[i])) {
+                continue;
+            }
+            if (++outAt == out->count) {
+                out = out->next;
+                outAt = 0;
+            }
+            if (out != current || outAt != i) {
+                out->elements()[outAt] = std::move(items[i]);
+            }
+            kept++;
+        }
+    }
+
+    const size_t removed = numElts - kept;
+    if (removed != 0) {
+        erase(kept, removed);
+    }
+    return removed;
+}
+
+/**
+ * Reverses the order of the elements: each block is reversed in place and
+ * the blocks are relinked back to front. O(n) swaps, no allocation beyond
+ * a list of the blocks.
+ */
+template<class T, class Alloc>
+void BasicSequence<T, Alloc>::reverse() {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::SORT);
+    if (numElts < 2) {
+        return;
+    }
+    ownAll();
+    normalizeHead(); // the head becomes the tail
+    if (index) {
+        index->reordered();
+    }
+
+    std::vector<Run> runs;
+    for (Node *current = tail; current != nullptr; current = current->prev) {
+        T *items = current->elements();
+        std::reverse(items, items + current->count);
+        runs.push_back(Run{current, current});
+    }
+    for (Run &run : runs) {
+        run.first->next = nullptr;
+    }
+    relinkRuns(runs);
+}
+
+/**
+ * Walks the first min(size(), other.size()) elements of both sequences in
+ * spans that are contiguous in both: each call gets the longest run that
+ * stays inside one block of each, so a comparison over it can be a single
+ * memcmp-style loop.
+ *
+ * @param other Sequence to walk alongside this one.
+ * @param fn Called as fn(const T *mine, const T *theirs, n); returning
+ * false stops the walk.
+ * @return false if fn stopped the walk.
+ */
+template<class T, class Alloc>
+template<class Fn>
+bool BasicSequence<T, Alloc>::zipSpans(const BasicSequence &other, Fn fn) const {
+    const Node *a = head;
+    const Node *b = other.head;
+    size_t ai = 0;
+    size_t bi = 0;
+    for (size_t left = std::min(numElts, other.numElts); left > 0;) {
+        const size_t n = std::min({a->count - ai, b->count - bi, left});
+        if (!fn(a->elements() + ai, b->elements() + bi, n)) {
+            return false;
+        }
+        ai += n;
+        bi += n;
+        left -= n;
+        if (ai == a->count) {
+            a = a->next;
+            ai = 0;
+        }
+        if (bi == b->count) {
+            b = b->next;
+            bi = 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks whether both sequences hold equal elements in the same order.
+ * Different sizes answer at once, and so do copies still sharing their
+ * blocks. Otherwise the blocks are compared span by span: integers, enums
+ * and pointers with one memcmp per span, everything else with its own ==
+ * one by one (strings compare their lengths, then memcmp their bytes). A
+ * trivially copyable class may define == differently from its bytes, as
+ * InternedString does, so only those built-in types are compared as bytes.
+ *
+ * @param other Sequence to compare with.
+ * @return true if the sequences are equal.
+ */
+template<class T, class Alloc>
+bool BasicSequence<T, Alloc>::operator==(const BasicSequence &other) const requires std::equality_comparable<T> {
+    if (numElts != other.numElts) {
+        return false;
+    }
+    if (head == other.head) {
+        return true; // the same sequence, or copies sharing the same blocks
+    }
+    return zipSpans(other, [](const T *a, const T *b, size_t n) {
+        if constexpr (BYTEWISE) {
+            return std::memcmp(static_cast<const void *>(a), static_cast<const void *>(b), n * sizeof(T)) == 0;
+        } else {
+            return std::equal(a, a + n, b);
+        }
+    });
+}
+
+/**
+ * Compares the sequences lexicographically: by the first pair of elements
+ * that differ, or by size if one is a prefix of the other. The blocks are
+ * walked span by span as in operator==.
+ *
+ * @param other Sequence to compare with.
+ * @return The ordering of this sequence relative to other, of the type T's
+ * operator<=> returns.
+ */
+template<class T, class Alloc>
+auto BasicSequence<T, Alloc>::operator<=>(const BasicSequence &other) const requires std::three_way_comparable<T> {
+    using Ordering = std::compare_three_way_result_t<T>;
+    Ordering result = Ordering::equivalent;
+    if (head != other.head) {
+        zipSpans(other, [&result](const T *a, const T *b, size_t n) {
+            result = std::lexicographical_compare_three_way(a, a + n, b, b + n);
+            return result == 0;
+        });
+    }
+    if (result == 0) {
+        result = numElts <=> other.numElts;
+    }
+    return result;
+}
+
+/**
+ * Hashes the elements in order with SequenceHasher (XXH64), so equal
+ * sequences hash equal however their blocks are split. Byte strings feed
+ * their length and bytes, integers, enums and pointers feed whole blocks
+ * at once, and anything else feeds its std::hash.
+ *
+ * @return The hash.
+ */
+template<class T, class Alloc>
+size_t BasicSequence<T, Alloc>::hash() const requires SequenceByteString<T> || SequenceHashable<T> {
+    SequenceHasher hasher;
+    for (const Node *current = head; current != nullptr; current = current->next) {
+        const T *items = current->elements();
+        if constexpr (SequenceByteString<T>) {
+            for (size_t i = 0; i < current->count; i++) {
+                hasher.updateValue(static_cast<std::uint64_t>(items[i].size())); // keeps "ab","c" apart from "a","bc"
+                hasher.update(items[i].data(), items[i].size());
+            }
+        } else if constexpr (BYTEWISE) {
+            hasher.update(items, current->count * sizeof(T));
+        } else {
+            for (size_t i = 0; i < current->count; i++) {
+                hasher.updateValue(static_cast<std::uint64_t>(std::hash<T>()(items[i])));
+            }
+        }
+    }
+    return static_cast<size_t>(hasher.digest());
+}
+
+/**
+ * Returns a read-only slice of the elements [position, position + count)
+ * without copying them. Finding its two ends costs O(log n) at most, O(1)
+ * near the finger.
+ *
+ * @param position Index of the first element of the slice.
+ * @param count Number of elements in the slice.
+ * @return Slice over those elements.
+ * @throws std::out_of_range if position + count exceeds the size.
+ */
+template<class T, class Alloc>
+SequenceSlice<T> BasicSequence<T, Alloc>::view(size_t position, size_t count) const {
+    if (position > numElts || count > numElts - position) {
+        throw std::out_of_range("Position and/or count is out of range");
+    }
+
+    auto at = [this](size_t i) {
+        if (i == numElts) {
+            return end();
+        }
+        size_t offset;
+        const Node *node = nodeAt(i, offset);
+        return const_iterator(node, offset);
+    };
+    const_iterator first = at(position);
+    return SequenceSlice<T>(first, count == 0 ? first : at(position + count), position, count);
+}
+
+/**
+ * Moves the elements [position, position + count) out into a new sequence
+ * and removes them from this one. The run is cut out of the list and the
+ * index in O(log n), as erase does, and its blocks are relinked into the
+ * new sequence along with the index over them, so only the two blocks cut
+ * at the ends move elements. The new sequence borrows this one's arena
+ * for those blocks, as splice does, and chunks a copy of this sequence
+ * still reads stay shared with it.
+ *
+ * Together with splice this moves a slice from one sequence to another:
+ * b.splice(i, a.extract(slice.position(), slice.size())).
+ *
+ * @param position Index of the first element to move out.
+ * @param count Number of elements to move out.
+ * @return Sequence holding those elements, with this one's allocator.
+ * @throws std::out_of_range if position + count exceeds the size.
+ */
+template<class T, class Alloc>
+BasicSequence<T, Alloc> BasicSequence<T, Alloc>::extract(size_t position, size_t count) {
+    static_assert(std::is_nothrow_move_constructible_v<T>, "extract moves elements between blocks");
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::SPLICE);
+    if (position > numElts || count > numElts - position) {
+        throw std::out_of_range("Position and/or count is out of range");
+    }
+    BasicSequence result(0, get_allocator());
+    if (count == 0) {
+        return result;
+    }
+    unshare();
+
+    Node *run;
+    Node *first = cutRange(position, count, &run);
+    Node *last = run; // the rightmost block of the run's index
+    while (last->right != nullptr) {
+        last = last->right;
+    }
+    result.head = first;
+    result.tail = last;
+    result.root = run;
+    result.numElts = count;
+    result.lent = true; // the blocks stay in this sequence's arena
+    result.mixed = mixed;
+    lent = true;
+
+    // The cut can leave a partial block on each side of the gap
+    if (position > 0 && position < numElts) {
+        size_t offset;
+        Node *after = nodeAt(position, offset);
+        if (after->prev->count + after->count <= Node::CAPACITY) {
+            mergeNext(after->prev);
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns an iterator to the first element, equal to end() when empty.
+ * Like every non-const accessor it gives a shared sequence its own blocks
+ * first, copying every chunk a copy still reads, since the caller may
+ * write anywhere; that invalidates iterators taken from it before.
+ *
+ * @return Iterator to the first element.
+ */
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::iterator BasicSequence<T, Alloc>::begin() {
+    ownAll(); // the caller may write through any element
+    touchIndex();
+    unshareable = true;
+    return head != nullptr ? iterator(head, 0) : iterator();
+}
+
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::const_iterator BasicSequence<T, Alloc>::begin() const {
+    return head != nullptr ? const_iterator(head, 0) : const_iterator();
+}
+
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::const_iterator BasicSequence<T, Alloc>::cbegin() const {
+    return begin();
+}
+
+/**
+ * Returns the iterator one past the last element: the slot after the last
+ * element of the tail block.
+ *
+ * @return The end iterator.
+ */
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::iterator BasicSequence<T, Alloc>::end() {
+    ownAll();
+    touchIndex();
+    unshareable = true;
+    return tail != nullptr ? iterator(tail, tail->count) : iterator();
+}
+
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::const_iterator BasicSequence<T, Alloc>::end() const {
+    return tail != nullptr ? const_iterator(tail, tail->count) : const_iterator();
+}
+
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::const_iterator BasicSequence<T, Alloc>::cend() const {
+    return end();
+}
+
+/**
+ * Returns a reverse iterator to the last element.
+ *
+ * @return Reverse iterator starting at the back.
+ */
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::reverse_iterator BasicSequence<T, Alloc>::rbegin() {
+    return reverse_iterator(end());
+}
+
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::const_reverse_iterator BasicSequence<T, Alloc>::rbegin() const {
+    return const_reverse_iterator(end());
+}
+
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::const_reverse_iterator BasicSequence<T, Alloc>::crbegin() const {
+    return rbegin();
+}
+
+/**
+ * Returns the reverse iterator one before the first element.
+ *
+ * @return The reverse end iterator.
+ */
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::reverse_iterator BasicSequence<T, Alloc>::rend() {
+    return reverse_iterator(begin());
+}
+
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::const_reverse_iterator BasicSequence<T, Alloc>::rend() const {
+    return const_reverse_iterator(begin());
+}
+
+template<class T, class Alloc>
+typename BasicSequence<T, Alloc>::const_reverse_iterator BasicSequence<T, Alloc>::crend() const {
+    return rend();
+}
+
+/**
+ * Outputs the sequence elements to an ostream in the following format:
+ * " <item1, item2, item3> "
+ *
+ * Sequences of strings go through format(), which hands the stream whole
+ * buffers of text instead of one element and one separator at a time.
+ *
+ * @param os The output stream.
+ * @param s The sequence object to print out.
+ * @return Output stream object.
+ */
+template<class T, class Alloc>
+std::ostream &operator<<(std::ostream &os, const BasicSequence<T, Alloc> &s) {
+    SEQUENCE_PROFILE_SCOPE(SequenceOp::PRINT);
+    if constexpr (SequenceByteString<T>) {
+        // Strings are written as raw bytes, a buffer at a time. A field
+        // width would pad the "<" alone, so that case keeps the loop below.
+        if (os.width() == 0) {
+            s.format([&os](const char *bytes, size_t n) {
+                os.write(bytes, static_cast<std::streamsize>(n));
+            });
+            return os;
+        }
+    }
+
+    os << "<";
+    const SequenceNode<T> *current = s.head;
+    while (current != nullptr) {
+        const T *items = current->elements();
+        for (size_t i = 0; i < current->count; i++) {
+            os << items[i]; // keep printing out elements
+            if (i + 1 < current->count || current->next != nullptr) {
+                // If next element is not null
+                os << ", ";
+            }
+        }
+
+        current = current->next; // Move to next element
+    }
+
+    os << ">";
+    return os; // Return ostream reference
+}
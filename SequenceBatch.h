@@ -0,0 +1,506 @@
+#ifndef SEQUENCEBATCH_H
+#define SEQUENCEBATCH_H
+
+#include <algorithm> // std::stable_sort, std::max
+#include <chrono> // queue and apply latencies
+#include <condition_variable> // committer wake-ups
+#include <cstddef> // For size_t
+#include <cstdint> // std::uint64_t
+#include <deque> // the queue
+#include <exception> // std::exception_ptr
+#include <future> // std::promise, std::future
+#include <iterator> // std::make_move_iterator
+#include <mutex> // std::mutex, std::scoped_lock
+#include <optional> // inserted values
+#include <ostream> // stats output
+#include <stdexcept> // exceptions
+#include <thread> // the committer
+#include <utility> // std::move
+#include <vector> // batches
+#include "Sequence.h"
+
+/**
+ * Who applies queued mutations in a BasicSequenceBatcher.
+ */
+enum class SequenceCommit {
+    BACKGROUND, // a committer thread applies whatever is queued as soon as it can
+    MANUAL // nothing is applied until someone calls commit() or flush()
+};
+
+/**
+ * Counters kept by a BasicSequenceBatcher. Latencies are in nanoseconds.
+ */
+struct SequenceBatchStats {
+    std::uint64_t batches = 0; // batches applied
+    std::uint64_t operations = 0; // mutations in those batches, rejected ones included
+    std::uint64_t rejected = 0; // mutations whose position was out of range
+    std::uint64_t runs = 0; // erase/insert calls the batches were merged into
+    std::uint64_t largestBatch = 0; // most mutations in one batch
+    std::uint64_t queuedNanos = 0; // time mutations waited before their batch started, summed
+    std::uint64_t applyNanos = 0; // time spent applying batches, summed
+    std::uint64_t slowestApplyNanos = 0; // longest single batch
+
+    double meanBatch() const {
+        return batches == 0 ? 0 : static_cast<double>(operations) / batches;
+    } // mutations per batch
+    double meanApplyNanos() const {
+        return batches == 0 ? 0 : static_cast<double>(applyNanos) / batches;
+    } // time per batch
+    double meanQueuedNanos() const {
+        return operations == 0 ? 0 : static_cast<double>(queuedNanos) / operations;
+    } // time from submit to the start of the mutation's batch
+};
+
+/**
+ * Writes the counters as one line.
+ *
+ * @param os Stream to write to.
+ * @param stats Counters to print.
+ * @return os.
+ */
+inline std::ostream &operator<<(std::ostream &os, const SequenceBatchStats &stats) {
+    return os << stats.batches << " batches, " << stats.operations << " operations (" << stats.rejected
+              << " rejected) in " << stats.runs << " runs, mean batch " << stats.meanBatch() << ", largest "
+              << stats.largestBatch << ", mean apply " << stats.meanApplyNanos() / 1000 << " us, slowest "
+              << stats.slowestApplyNanos / 1000 << " us, mean queued " << stats.meanQueuedNanos() / 1000 << " us";
+}
+
+/**
+ * Group-commit front end for a BasicSequence shared by many writers.
+ * push_back, insert and erase only queue the mutation and return a future;
+ * the queue is applied in batches, each under one short hold of the lock.
+ *
+ * All positions in a batch refer to the sequence as it was when the batch
+ * started, like the lines of a patch: insert(p) goes before the element
+ * that was at p, and erase(p) removes that element, whatever else the
+ * batch does. Several inserts at the same position keep the order they
+ * were submitted in, and push_back appends after everything, inserts at
+ * size() included, even those submitted after it. A mutation
+ * that depends on another one (erasing what was just inserted) must wait
+ * for the first one's future before it is submitted.
+ *
+ * A batch is sorted by position and merged into runs: a stretch of
+ * adjacent erases, together with the inserts that land in it, becomes one
+ * erase(position, count) and one range insert (a few single inserts for
+ * short runs, which fill free slots instead of splitting a block). The
+ * runs are applied from the back of the sequence to the front, so
+ * positions before a run never move and each run costs one O(log n)
+ * lookup in the position index, not one per element.
+ *
+ * A mutation whose position is out of range, or that erases an element
+ * already erased in the same batch, gets std::out_of_range through its
+ * future; the rest of the batch is still applied. stats() reports batch
+ * sizes and apply and queueing latencies.
+ *
+ * @tparam T Element type.
+ * @tparam Alloc Allocator of the underlying sequence.
+ */
+template<class T, class Alloc = std::allocator<T>>
+class BasicSequenceBatcher {
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t END = static_cast<size_t>(-1); // position of push_back
+    static constexpr size_t SMALL_RUN = 16; // fewer inserts than this go in one at a time, not spliced
+
+    struct Mutation {
+        bool erase; // erase at position, or insert value before it
+        size_t position; // in the sequence as the batch starts; END to append
+        std::optional<T> value; // the element to insert
+        std::promise<void> done; // fulfilled once applied or rejected
+        Clock::time_point queued; // when it was submitted
+    };
+
+    // A stretch of adjacent erases and the inserts that land in it
+    struct Run {
+        size_t start; // position of the first erased element, or of the inserts
+        size_t erased = 0; // number of elements erased from start on
+        std::vector<Mutation *> members; // every mutation of the run, inserts in order
+    };
+
+    std::mutex commitLock; // held by whoever is taking and applying a batch, so batches apply in queue order
+    mutable std::mutex listLock; // guards items
+    BasicSequence<T, Alloc> items;
+    mutable std::mutex queueLock; // guards everything below
+    std::condition_variable queuedSignal; // something was queued, or stopping
+    std::condition_variable appliedSignal; // a batch was applied
+    std::deque<Mutation> queue; // mutations not taken by a batch yet
+    std::uint64_t submitted = 0; // mutations ever queued
+    std::uint64_t applied = 0; // mutations whose batch finished
+    SequenceBatchStats counters;
+    const size_t maxBatch; // most mutations taken into one batch
+    bool stopping = false; // the destructor is waiting for the committer
+    std::thread committer; // started last, after everything it uses
+
+    std::future<void> submit(bool erase, size_t position, std::optional<T> value); // Queues one mutation
+    void applyBatch(std::vector<Mutation> &batch); // Applies one batch and completes its futures
+    size_t commitOnce(std::unique_lock<std::mutex> &lock); // Takes and applies the next batch; queueLock held
+    void run(); // Committer thread body
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+
+    explicit BasicSequenceBatcher(SequenceCommit mode = SequenceCommit::BACKGROUND, size_t maxBatch = 4096,
+                                  const Alloc &alloc = Alloc()); // Empty sequence
+    BasicSequenceBatcher(const BasicSequenceBatcher &) = delete; // futures point into this object
+    BasicSequenceBatcher &operator=(const BasicSequenceBatcher &) = delete;
+    ~BasicSequenceBatcher(); // Applies everything still queued
+
+    std::future<void> push_back(T element); // Queues an append.
+    std::future<void> insert(size_t position, T element); // Queues an insert before position.
+    std::future<void> erase(size_t position); // Queues the removal of the element at position.
+
+    size_t commit(); // Applies the mutations queued now on this thread; returns how many.
+    void flush(); // Waits until every mutation submitted so far is applied.
+    BasicSequence<T, Alloc> snapshot(); // Copies the applied contents in O(1).
+    size_t size() const; // Number of elements after the batches applied so far.
+    SequenceBatchStats stats() const; // Batch size and latency counters.
+};
+
+/**
+ * The string version, matching Sequence.
+ */
+using SequenceBatcher = BasicSequenceBatcher<std::string>;
+
+/**
+ * Creates an empty sequence and, in background mode, its committer thread.
+ *
+ * @param mode Whether a thread of its own applies the queue.
+ * @param maxBatch Most mutations applied in one batch, at least 1; the
+ * lock is not held longer than one batch takes.
+ * @param alloc Allocator for the underlying sequence.
+ */
+template<class T, class Alloc>
+BasicSequenceBatcher<T, Alloc>::BasicSequenceBatcher(SequenceCommit mode, size_t maxBatch, const Alloc &alloc)
+    : items(0, alloc), maxBatch(maxBatch == 0 ? 1 : maxBatch) {
+    if (mode == SequenceCommit::BACKGROUND) {
+        committer = std::thread(&BasicSequenceBatcher::run, this);
+    }
+}
+
+/**
+ * Applies every mutation still queued, then stops the committer.
+ */
+template<class T, class Alloc>
+BasicSequenceBatcher<T, Alloc>::~BasicSequenceBatcher() {
+    {
+        std::scoped_lock lock(queueLock);
+        stopping = true;
+    }
+    queuedSignal.notify_all();
+    if (committer.joinable()) {
+        committer.join();
+    } else {
+        flush();
+    }
+}
+
+/**
+ * Queues a mutation and wakes the committer.
+ *
+ * @param erase true to erase, false to insert value.
+ * @param position Position in the sequence as the batch starts, or END.
+ * @param value Element to insert.
+ * @return Future that is ready once the mutation is applied.
+ */
+template<class T, class Alloc>
+std::future<void> BasicSequenceBatcher<T, Alloc>::submit(bool erase, size_t position, std::optional<T> value) {
+    std::future<void> result;
+    bool wake;
+    {
+        std::scoped_lock lock(queueLock);
+        wake = queue.empty(); // the committer only sleeps on an empty queue
+        Mutation &mutation = queue.emplace_back(Mutation{erase, position, std::move(value), {}, Clock::now()});
+        result = mutation.done.get_future();
+        submitted++;
+    }
+    if (wake) {
+        queuedSignal.notify_one();
+    }
+    return result;
+}
+
+/**
+ * Queues an element to append after everything else in its batch.
+ *
+ * @param item The element to append.
+ * @return Future that is ready once it is in the sequence.
+ */
+template<class T, class Alloc>
+std::future<void> BasicSequenceBatcher<T, Alloc>::push_back(T item) {
+    return submit(false, END, std::move(item));
+}
+
+/**
+ * Queues an element to insert before the element now at position.
+ *
+ * @param position Position as of the start of the batch; size() appends.
+ * @param item The element to insert.
+ * @return Future that is ready once it is in the sequence, or holds
+ * std::out_of_range if position was past the end.
+ */
+template<class T, class Alloc>
+std::future<void> BasicSequenceBatcher<T, Alloc>::insert(size_t position, T item) {
+    return submit(false, position, std::move(item));
+}
+
+/**
+ * Queues the removal of the element at position.
+ *
+ * @param position Position as of the start of the batch.
+ * @return Future that is ready once the element is gone, or holds
+ * std::out_of_range if there was no element there or it was already
+ * erased by the same batch.
+ */
+template<class T, class Alloc>
+std::future<void> BasicSequenceBatcher<T, Alloc>::erase(size_t position) {
+    return submit(true, position, std::nullopt);
+}
+
+/**
+ * Applies one batch. The mutations are checked and sorted by position
+ * (inserts at a position before the erase of its element, appends after
+ * every insert at the end, ties in submission order), merged into runs,
+ * and the runs applied from the back.
+ * Futures are completed once the lock is released.
+ *
+ * If applying a run throws (out of memory), that run and the ones before
+ * it get the exception; the runs after it are already applied.
+ *
+ * @param batch Mutations in submission order.
+ */
+template<class T, class Alloc>
+void BasicSequenceBatcher<T, Alloc>::applyBatch(std::vector<Mutation> &batch) {
+    const Clock::time_point start = Clock::now();
+    std::uint64_t queuedNanos = 0;
+    for (const Mutation &mutation : batch) {
+        queuedNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(start - mutation.queued).count();
+    }
+
+    std::vector<Mutation *> order;
+    std::vector<Mutation *> rejected;
+    std::vector<Run> runs;
+    std::exception_ptr error;
+    size_t failedRuns = 0; // runs[0, failedRuns) were not applied
+    {
+        std::scoped_lock lock(listLock);
+        const size_t n = items.size();
+        for (Mutation &mutation : batch) {
+            if (mutation.position != END && (mutation.erase ? mutation.position >= n : mutation.position > n)) {
+                rejected.push_back(&mutation);
+            } else {
+                order.push_back(&mutation);
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [](const Mutation *a, const Mutation *b) {
+            return a->position != b->position ? a->position < b->position : !a->erase && b->erase;
+        });
+        for (Mutation *mutation : order) {
+            if (mutation->position == END) {
+                mutation->position = n; // sorted after the inserts at n, now applied with them
+            }
+        }
+
+        for (Mutation *mutation : order) {
+            Run *last = runs.empty() ? nullptr : &runs.back();
+            const size_t next = last != nullptr ? last->start + last->erased : END; // first position past the run
+            if (mutation->erase && last != nullptr && mutation->position < next) {
+                rejected.push_back(mutation); // its element is already erased
+                continue;
+            }
+            if (last == nullptr || mutation->position != next) {
+                last = &runs.emplace_back(Run{mutation->position, 0, {}});
+            }
+            if (mutation->erase) {
+                last->erased++;
+            }
+            last->members.push_back(mutation);
+        }
+
+        // Back to front, so no run moves the positions of the ones before it
+        size_t r = runs.size();
+        try {
+            for (; r > 0; r--) {
+                Run &run = runs[r - 1];
+                if (run.erased != 0) {
+                    items.erase(run.start, run.erased);
+                }
+                std::vector<T> values;
+                for (Mutation *mutation : run.members) {
+                    if (!mutation->erase) {
+                        values.push_back(std::move(*mutation->value));
+                    }
+                }
+                if (values.size() < SMALL_RUN) {
+                    for (size_t i = 0; i < values.size(); i++) {
+                        items.insert(run.start + i, std::move(values[i])); // fills the block's free slots
+                    }
+                } else {
+                    items.insert(run.start, std::make_move_iterator(values.begin()),
+                                 std::make_move_iterator(values.end()));
+                }
+            }
+        } catch (...) {
+            error = std::current_exception();
+            failedRuns = r;
+        }
+    }
+
+    const std::uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    {
+        std::scoped_lock lock(queueLock);
+        counters.batches++;
+        counters.operations += batch.size();
+        counters.rejected += rejected.size();
+        counters.runs += runs.size();
+        counters.largestBatch = std::max<std::uint64_t>(counters.largestBatch, batch.size());
+        counters.queuedNanos += queuedNanos;
+        counters.applyNanos += nanos;
+        counters.slowestApplyNanos = std::max(counters.slowestApplyNanos, nanos);
+    }
+
+    for (Mutation *mutation : rejected) {
+        mutation->done.set_exception(std::make_exception_ptr(std::out_of_range(
+            mutation->erase ? "Position is out of range or already erased" : "Position is out of range")));
+    }
+    for (size_t r = 0; r < runs.size(); r++) {
+        for (Mutation *mutation : runs[r].members) {
+            if (r < failedRuns) {
+                mutation->done.set_exception(error);
+            } else {
+                mutation->done.set_value();
+            }
+        }
+    }
+}
+
+/**
+ * Takes up to maxBatch mutations off the queue and applies them. Called
+ * with queueLock held; drops it while applying. commitLock is held from
+ * taking the batch until applied is updated, so with several committers
+ * (commit() callers and the committer thread) batches are still applied
+ * one at a time in the order they were queued, and applied only counts a
+ * prefix of the queue.
+ *
+ * @param lock The held queueLock.
+ * @return Number of mutations applied; 0 if another committer emptied the
+ * queue first.
+ */
+template<class T, class Alloc>
+size_t BasicSequenceBatcher<T, Alloc>::commitOnce(std::unique_lock<std::mutex> &lock) {
+    lock.unlock();
+    std::scoped_lock commit(commitLock); // always taken before queueLock
+    lock.lock();
+
+    std::vector<Mutation> batch;
+    const size_t take = queue.size() < maxBatch ? queue.size() : maxBatch;
+    if (take == 0) {
+        return 0;
+    }
+    batch.reserve(take);
+    for (size_t i = 0; i < take; i++) {
+        batch.push_back(std::move(queue.front()));
+        queue.pop_front();
+    }
+
+    lock.unlock();
+    applyBatch(batch);
+    lock.lock();
+    applied += take;
+    appliedSignal.notify_all();
+    return take;
+}
+
+/**
+ * Applies, on the calling thread, the mutations queued when it is called
+ * (in batches of up to maxBatch). Used in manual mode; in background mode
+ * it just helps the committer. Several threads can call it at once: the
+ * batches are still applied in queue order, and each call returns once
+ * everything queued before it is applied, by whichever thread.
+ *
+ * @return Number of mutations this call applied.
+ */
+template<class T, class Alloc>
+size_t BasicSequenceBatcher<T, Alloc>::commit() {
+    std::unique_lock lock(queueLock);
+    const std::uint64_t target = submitted;
+    size_t total = 0;
+    while (applied < target) {
+        if (queue.empty()) {
+            appliedSignal.wait(lock); // another committer is applying the rest
+        } else {
+            total += commitOnce(lock);
+        }
+    }
+    return total;
+}
+
+/**
+ * Waits until every mutation submitted before the call has been applied.
+ * In manual mode this applies them itself.
+ */
+template<class T, class Alloc>
+void BasicSequenceBatcher<T, Alloc>::flush() {
+    std::unique_lock lock(queueLock);
+    const std::uint64_t target = submitted;
+    while (applied < target) {
+        if (!committer.joinable() && !queue.empty()) {
+            commitOnce(lock);
+        } else {
+            appliedSignal.wait(lock);
+        }
+    }
+}
+
+/**
+ * Committer thread: applies whatever is queued, a batch at a time, until
+ * the destructor asks it to stop and the queue is empty.
+ */
+template<class T, class Alloc>
+void BasicSequenceBatcher<T, Alloc>::run() {
+    std::unique_lock lock(queueLock);
+    while (true) {
+        queuedSignal.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return; // stopping, and nothing left
+        }
+        commitOnce(lock);
+    }
+}
+
+/**
+ * Returns a copy of the contents as of the last applied batch. The copy
+ * shares the sequence's blocks, so this is O(1) under the lock.
+ *
+ * @return Copy of every applied element, in order.
+ */
+template<class T, class Alloc>
+BasicSequence<T, Alloc> BasicSequenceBatcher<T, Alloc>::snapshot() {
+    std::scoped_lock lock(listLock);
+    return items;
+}
+
+/**
+ * Returns the number of elements after the batches applied so far;
+ * mutations still queued are not counted.
+ *
+ * @return Number of elements.
+ */
+template<class T, class Alloc>
+size_t BasicSequenceBatcher<T, Alloc>::size() const {
+    std::scoped_lock lock(listLock);
+    return items.size();
+}
+
+/**
+ * Returns a copy of the batch counters.
+ *
+ * @return Batch sizes and latencies so far.
+ */
+template<class T, class Alloc>
+SequenceBatchStats BasicSequenceBatcher<T, Alloc>::stats() const {
+    std::scoped_lock lock(queueLock);
+    return counters;
+}
+
+#endif
@@ -0,0 +1,709 @@
+/**
+ * SequenceBench.cpp
+ * Project 3
+ * CS 3100
+ *
+ * Performance suite for Sequence. Every operation is timed over a sweep of
+ * sizes (10 up to 10^7) and two element kinds: short strings that fit in
+ * the small-string buffer and long strings that live on the heap. Results
+ * are printed as a table, or as JSON in the same layout Google Benchmark
+ * uses so existing comparison scripts can read two runs and diff them.
+ *
+ * Options:
+ *   --benchmark_filter=<text>   only run benchmarks whose name contains text
+ *   --benchmark_format=json     print JSON instead of the table
+ *   --benchmark_out=<file>      also write the JSON results to file
+ *   --benchmark_min_time=<s>    minimum measured time per benchmark (0.1)
+ *   --max_size=<n>              largest size in the sweep (10000000)
+ *   --footprint                 print memory per element instead of timings
+ *
+ * Build with optimizations (e.g. -DCMAKE_BUILD_TYPE=Release) for numbers
+ * worth comparing.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Sequence.h"
+#include "SequenceIntern.h"
+#include "SequenceRing.h"
+#include "SequenceHybrid.h"
+
+#if SEQUENCE_HAS_UNISTD
+#include <fcntl.h> // open /dev/null for print_fd
+#endif
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+/**
+ * Times the measured parts of one benchmark run. Setup done between
+ * start() and stop() pairs is left out, like Google Benchmark's
+ * PauseTiming/ResumeTiming.
+ */
+class Timer {
+private:
+    Clock::time_point begin; // start of the current measured part
+    double elapsed = 0; // seconds measured so far
+
+public:
+    void start() {
+        begin = Clock::now();
+    }
+    void stop() {
+        elapsed += chrono::duration<double>(Clock::now() - begin).count();
+    }
+    double seconds() const {
+        return elapsed;
+    }
+};
+
+/**
+ * One line of output: how long a single operation took on average.
+ */
+struct Result {
+    string name; // operation/element kind/size
+    size_t iterations; // operations measured
+    double nanosPerOp; // average time of one operation
+};
+
+/**
+ * Stream buffer that throws everything away, so operator<< is measured
+ * without the cost of growing a string.
+ */
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+    streamsize xsputn(const char *, streamsize n) override {
+        return n;
+    }
+};
+
+/**
+ * Makes the i-th test element: 8 characters for the short kind, 64 for
+ * the long kind.
+ *
+ * @param i Element number, mixed into the text.
+ * @param longKind true for heap-allocated strings.
+ * @return The element.
+ */
+string makeElement(size_t i, bool longKind) {
+    string item = to_string(i);
+    item.resize(longKind ? 64 : 8, 'x');
+    return item;
+}
+
+/**
+ * Builds a sequence of n test elements.
+ */
+Sequence makeSequence(size_t n, bool longKind) {
+    Sequence s;
+    for (size_t i = 0; i < n; i++) {
+        s.push_back(makeElement(i, longKind));
+    }
+    return s;
+}
+
+/**
+ * Builds a sequence of n test elements in random order.
+ */
+Sequence makeShuffled(size_t n, bool longKind) {
+    vector<size_t> order(n);
+    for (size_t i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    shuffle(order.begin(), order.end(), mt19937_64(n));
+    Sequence s;
+    for (size_t i : order) {
+        s.push_back(makeElement(i, longKind));
+    }
+    return s;
+}
+
+/**
+ * A benchmark body: performs some operations on a sequence of the given
+ * size and returns how many it timed.
+ */
+using Body = function<size_t(size_t n, bool longKind, Timer &timer)>;
+
+/**
+ * Calls body until at least minTime seconds were measured (and at least
+ * once), then reports the average time per operation.
+ */
+Result measure(const string &name, const Body &body, size_t n, bool longKind, double minTime) {
+    Timer timer;
+    size_t iterations = 0;
+    do {
+        iterations += body(n, longKind, timer);
+    } while (timer.seconds() < minTime);
+
+    return {name, iterations, timer.seconds() * 1e9 / static_cast<double>(iterations)};
+}
+
+// Insert or erase at one of three places
+enum class Where { FRONT, MIDDLE, BACK };
+
+size_t positionFor(Where where, size_t size) {
+    switch (where) {
+        case Where::FRONT:
+            return 0;
+        case Where::MIDDLE:
+            return size / 2;
+        default:
+            return size;
+    }
+}
+
+Body insertAt(Where where) {
+    return [where](size_t n, bool longKind, Timer &timer) {
+        Sequence s = makeSequence(n, longKind);
+        const size_t ops = n < 10000 ? n : 10000;
+        string item = makeElement(n, longKind);
+        timer.start();
+        for (size_t i = 0; i < ops; i++) {
+            s.insert(positionFor(where, s.size()), item);
+        }
+        timer.stop();
+        return ops;
+    };
+}
+
+Body eraseAt(Where where) {
+    return [where](size_t n, bool longKind, Timer &timer) {
+        Sequence s = makeSequence(n, longKind);
+        const size_t ops = n / 2 < 10000 ? n / 2 : 10000;
+        timer.start();
+        for (size_t i = 0; i < ops; i++) {
+            size_t position = positionFor(where, s.size());
+            s.erase(position == s.size() ? position - 1 : position);
+        }
+        timer.stop();
+        return ops;
+    };
+}
+
+/**
+ * Every benchmark in the suite, by operation name.
+ */
+vector<pair<string, Body>> suite() {
+    return {
+        {"push_back", [](size_t n, bool longKind, Timer &timer) {
+            vector<string> items;
+            for (size_t i = 0; i < n; i++) {
+                items.push_back(makeElement(i, longKind));
+            }
+            Sequence s;
+            timer.start();
+            for (size_t i = 0; i < n; i++) {
+                s.push_back(items[i]);
+            }
+            timer.stop();
+            return n;
+        }},
+        {"append", [](size_t n, bool longKind, Timer &timer) {
+            vector<string> items;
+            for (size_t i = 0; i < n; i++) {
+                items.push_back(makeElement(i, longKind));
+            }
+            Sequence s;
+            timer.start();
+            s.append(items.begin(), items.end());
+            timer.stop();
+            return n;
+        }},
+        {"construct_n", [](size_t n, bool, Timer &timer) {
+            timer.start();
+            Sequence s(n);
+            timer.stop();
+            return n;
+        }},
+        {"pop_back", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            timer.start();
+            while (!s.empty()) {
+                s.pop_back();
+            }
+            timer.stop();
+            return n;
+        }},
+        {"push_front", [](size_t n, bool longKind, Timer &timer) {
+            vector<string> items;
+            for (size_t i = 0; i < n; i++) {
+                items.push_back(makeElement(i, longKind));
+            }
+            Sequence s;
+            timer.start();
+            for (size_t i = 0; i < n; i++) {
+                s.push_front(items[i]);
+            }
+            timer.stop();
+            return n;
+        }},
+        {"pop_front", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            timer.start();
+            while (!s.empty()) {
+                s.pop_front();
+            }
+            timer.stop();
+            return n;
+        }},
+        {"queue", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            string item = makeElement(n, longKind);
+            timer.start();
+            for (size_t i = 0; i < n; i++) {
+                s.push_back(item);
+                s.pop_front();
+            }
+            timer.stop();
+            return n;
+        }},
+        {"queue_ring", [](size_t n, bool longKind, Timer &timer) {
+            SequenceRing s(n + 1);
+            for (size_t i = 0; i < n; i++) {
+                s.push_back(makeElement(i, longKind));
+            }
+            string item = makeElement(n, longKind);
+            timer.start();
+            for (size_t i = 0; i < n; i++) {
+                s.push_back(item);
+                s.pop_front();
+            }
+            timer.stop();
+            return n;
+        }},
+        {"insert_front", insertAt(Where::FRONT)},
+        {"insert_middle", insertAt(Where::MIDDLE)},
+        {"insert_back", insertAt(Where::BACK)},
+        {"erase_front", eraseAt(Where::FRONT)},
+        {"erase_middle", eraseAt(Where::MIDDLE)},
+        {"erase_back", eraseAt(Where::BACK)},
+        {"index_sequential", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            size_t total = 0;
+            timer.start();
+            for (size_t i = 0; i < n; i++) {
+                total += s[i].size();
+            }
+            timer.stop();
+            volatile size_t sink = total; // keep the loop from being optimized away
+            (void) sink;
+            return n;
+        }},
+        {"index_random", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            vector<size_t> order(n);
+            mt19937_64 rng(n);
+            for (size_t &i : order) {
+                i = rng() % n;
+            }
+            size_t total = 0;
+            timer.start();
+            for (size_t i : order) {
+                total += s[i].size();
+            }
+            timer.stop();
+            volatile size_t sink = total;
+            (void) sink;
+            return n;
+        }},
+        {"index_random_hybrid", [](size_t n, bool longKind, Timer &timer) {
+            HybridSequence s;
+            for (size_t i = 0; i < n; i++) {
+                s.push_back(makeElement(i, longKind));
+            }
+            vector<size_t> order(n);
+            mt19937_64 rng(n);
+            for (size_t &i : order) {
+                i = rng() % n;
+            }
+            size_t total = 0;
+            timer.start();
+            for (size_t i = 0; i < n; i++) {
+                total += s[order[i]].size();
+                if (i % 100 == 0) {
+                    s.push_back(s.back()); // a few changes, where the layout can switch
+                }
+            }
+            timer.stop();
+            volatile size_t sink = total;
+            (void) sink;
+            return n;
+        }},
+        {"insert_middle_hybrid", [](size_t n, bool longKind, Timer &timer) {
+            HybridSequence s;
+            for (size_t i = 0; i < n; i++) {
+                s.push_back(makeElement(i, longKind));
+            }
+            const size_t ops = n / 2 < 10000 ? n / 2 : 10000;
+            string item = makeElement(n, longKind);
+            timer.start();
+            for (size_t i = 0; i < ops; i++) {
+                s.insert(s.size() / 2, item);
+            }
+            timer.stop();
+            return ops;
+        }},
+        {"slice_copy", [](size_t n, bool longKind, Timer &timer) {
+            const Sequence s = makeSequence(n, longKind);
+            timer.start();
+            Sequence slice;
+            for (size_t i = n / 4; i < n / 4 + n / 2; i++) {
+                slice.push_back(s[i]);
+            }
+            timer.stop();
+            return n / 2;
+        }},
+        {"slice_view", [](size_t n, bool longKind, Timer &timer) {
+            const Sequence s = makeSequence(n, longKind);
+            size_t total = 0;
+            timer.start();
+            for (const string &item : s.view(n / 4, n / 2)) {
+                total += item.size();
+            }
+            timer.stop();
+            volatile size_t sink = total;
+            (void) sink;
+            return n / 2;
+        }},
+        {"extract", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            timer.start();
+            Sequence slice = s.extract(n / 4, n / 2);
+            timer.stop();
+            return n / 2;
+        }},
+        {"contains_scan", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            const size_t ops = n < 1000 ? n : 1000;
+            size_t found = 0;
+            timer.start();
+            for (size_t i = 0; i < ops; i++) {
+                found += s.contains(makeElement(i * 7919 % (2 * n), longKind)) ? 1 : 0;
+            }
+            timer.stop();
+            volatile size_t sink = found;
+            (void) sink;
+            return ops;
+        }},
+        {"contains_indexed", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            s.enableIndex();
+            s.contains(""); // build the index outside the timing
+            vector<string> probes;
+            for (size_t i = 0; i < n; i++) {
+                probes.push_back(makeElement(i * 7919 % (2 * n), longKind));
+            }
+            size_t found = 0;
+            timer.start();
+            for (const string &probe : probes) {
+                found += s.contains(probe) ? 1 : 0;
+            }
+            timer.stop();
+            volatile size_t sink = found;
+            (void) sink;
+            return n;
+        }},
+        {"dedup_push_back", [](size_t n, bool longKind, Timer &timer) {
+            vector<string> items;
+            for (size_t i = 0; i < n; i++) {
+                items.push_back(makeElement(i % (n / 4 + 1), longKind)); // every value four times
+            }
+            Sequence s;
+            s.enableIndex();
+            timer.start();
+            for (const string &item : items) {
+                if (!s.contains(item)) {
+                    s.push_back(item);
+                }
+            }
+            timer.stop();
+            return n;
+        }},
+        {"sort", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeShuffled(n, longKind);
+            timer.start();
+            s.sort();
+            timer.stop();
+            return n;
+        }},
+        {"sort_vector", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeShuffled(n, longKind);
+            timer.start();
+            vector<string> items(make_move_iterator(s.begin()), make_move_iterator(s.end()));
+            stable_sort(items.begin(), items.end());
+            s.clear();
+            s.append(make_move_iterator(items.begin()), make_move_iterator(items.end()));
+            timer.stop();
+            return n;
+        }},
+        {"sort_sorted", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeShuffled(n, longKind);
+            s.sort();
+            timer.start();
+            s.sort();
+            timer.stop();
+            return n;
+        }},
+        {"reverse", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            timer.start();
+            s.reverse();
+            timer.stop();
+            return n;
+        }},
+        {"equal", [](size_t n, bool longKind, Timer &timer) {
+            const Sequence a = makeSequence(n, longKind);
+            const Sequence b = makeSequence(n, longKind); // same elements, blocks of its own
+            timer.start();
+            volatile bool same = a == b;
+            timer.stop();
+            (void) same;
+            return n;
+        }},
+        {"equal_printed", [](size_t n, bool longKind, Timer &timer) {
+            const Sequence a = makeSequence(n, longKind);
+            const Sequence b = makeSequence(n, longKind);
+            timer.start();
+            ostringstream left;
+            ostringstream right;
+            left << a;
+            right << b;
+            volatile bool same = left.str() == right.str();
+            timer.stop();
+            (void) same;
+            return n;
+        }},
+        {"hash", [](size_t n, bool longKind, Timer &timer) {
+            const Sequence s = makeSequence(n, longKind);
+            timer.start();
+            volatile size_t h = hash<Sequence>()(s);
+            timer.stop();
+            (void) h;
+            return n;
+        }},
+        {"copy_construct", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            timer.start();
+            Sequence copy(s);
+            timer.stop();
+            return n;
+        }},
+        {"assign", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            Sequence target = makeSequence(n / 2, longKind);
+            timer.start();
+            target = s;
+            timer.stop();
+            return n;
+        }},
+        {"clear", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            timer.start();
+            s.clear();
+            timer.stop();
+            return n;
+        }},
+        {"clear_async", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            timer.start();
+            future<void> done = s.clearAsync(); // only the caller's share is timed
+            timer.stop();
+            done.wait();
+            return n;
+        }},
+        {"stream_out", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            NullBuffer buffer;
+            ostream out(&buffer);
+            timer.start();
+            out << s;
+            timer.stop();
+            return n;
+        }},
+#if SEQUENCE_HAS_UNISTD
+        {"print_fd", [](size_t n, bool longKind, Timer &timer) {
+            Sequence s = makeSequence(n, longKind);
+            int fd = open("/dev/null", O_WRONLY);
+            timer.start();
+            s.print(fd);
+            timer.stop();
+            close(fd);
+            return n;
+        }},
+#endif
+    };
+}
+
+/**
+ * Prints the memory held per element for each element kind, stored as
+ * std::string and as InternedString. The interned figure includes the
+ * string pool. "repeated" draws 24-character values (too long for the
+ * small-string buffer) from 1000 distinct ones.
+ */
+void footprintReport(size_t n) {
+    cout << left << setw(12) << "elements" << setw(12) << "kind" << right
+         << setw(16) << "std::string" << setw(16) << "interned" << "  (bytes per element)" << endl;
+    for (const char *kind : {"short", "long", "repeated"}) {
+        const string name = kind;
+        auto element = [&](size_t i) {
+            if (name == "repeated") {
+                string item = to_string(i % 1000);
+                item.resize(24, 'x');
+                return item;
+            }
+            return makeElement(i, name == "long");
+        };
+
+        Sequence strings;
+        SequenceStringPool pool;
+        BasicSequence<InternedString> interned;
+        for (size_t i = 0; i < n; i++) {
+            strings.push_back(element(i));
+            interned.push_back(InternedString(pool, element(i)));
+        }
+        const double internedBytes = interned.footprint().bytesPerElement()
+                                     + static_cast<double>(pool.bytes()) / static_cast<double>(n);
+        cout << left << setw(12) << n << setw(12) << name << right << fixed << setprecision(1)
+             << setw(16) << strings.footprint().bytesPerElement() << setw(16) << internedBytes << endl;
+    }
+}
+
+/**
+ * Escapes a string for a JSON string literal.
+ */
+string jsonString(const string &text) {
+    string escaped = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped + "\"";
+}
+
+/**
+ * Writes the results in Google Benchmark's JSON layout.
+ */
+void writeJson(ostream &out, const vector<Result> &results) {
+    time_t now = time(nullptr);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    out << "{\n";
+    out << "  \"context\": {\n";
+    out << "    \"date\": " << jsonString(date) << ",\n";
+    out << "    \"executable\": \"SequenceBench\",\n";
+    out << "    \"num_cpus\": " << thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+    out << "    \"library_build_type\": \"release\"\n";
+#else
+    out << "    \"library_build_type\": \"debug\"\n";
+#endif
+    out << "  },\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        out << "    {\n";
+        out << "      \"name\": " << jsonString(r.name) << ",\n";
+        out << "      \"run_name\": " << jsonString(r.name) << ",\n";
+        out << "      \"run_type\": \"iteration\",\n";
+        out << "      \"iterations\": " << r.iterations << ",\n";
+        out << "      \"real_time\": " << r.nanosPerOp << ",\n";
+        out << "      \"cpu_time\": " << r.nanosPerOp << ",\n";
+        out << "      \"time_unit\": \"ns\"\n";
+        out << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+/**
+ * Returns the value of a --name=value option, or an empty string.
+ */
+string option(const string &arg, const string &name) {
+    const string prefix = "--" + name + "=";
+    return arg.compare(0, prefix.size(), prefix) == 0 ? arg.substr(prefix.size()) : "";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    string filter;
+    string format = "console";
+    string outFile;
+    double minTime = 0.1;
+    size_t maxSize = 10000000;
+    bool footprint = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (!option(arg, "benchmark_filter").empty()) {
+            filter = option(arg, "benchmark_filter");
+        } else if (!option(arg, "benchmark_format").empty()) {
+            format = option(arg, "benchmark_format");
+        } else if (!option(arg, "benchmark_out").empty()) {
+            outFile = option(arg, "benchmark_out");
+        } else if (!option(arg, "benchmark_min_time").empty()) {
+            minTime = strtod(option(arg, "benchmark_min_time").c_str(), nullptr);
+        } else if (!option(arg, "max_size").empty()) {
+            maxSize = strtoull(option(arg, "max_size").c_str(), nullptr, 10);
+        } else if (arg == "--footprint") {
+            footprint = true;
+        } else {
+            cerr << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (footprint) {
+        footprintReport(maxSize < 1000000 ? maxSize : 1000000);
+        return 0;
+    }
+
+    vector<Result> results;
+    for (const auto &[operation, body] : suite()) {
+        for (bool longKind : {false, true}) {
+            for (size_t n = 10; n <= maxSize; n *= 10) {
+                string name = operation + (longKind ? "/long/" : "/short/") + to_string(n);
+                if (name.find(filter) == string::npos) {
+                    continue;
+                }
+
+                Result r = measure(name, body, n, longKind, minTime);
+                if (format != "json") {
+                    cout << left << setw(32) << r.name << right << setw(14) << fixed << setprecision(2)
+                         << r.nanosPerOp << " ns/op" << setw(14) << r.iterations << endl;
+                }
+                results.push_back(r);
+            }
+        }
+    }
+
+    if (format == "json") {
+        writeJson(cout, results);
+    }
+    if (!outFile.empty()) {
+        ofstream out(outFile);
+        writeJson(out, results);
+    }
+    return 0;
+}
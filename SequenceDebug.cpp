@@ -6,8 +6,11 @@
  * In this file, you will write your tests as you implement Sequence. If you are using CLion, you need to select
  * SequenceDebug from the drop-down menu next to the Build (hammer icon) if it is on SequenceTestHarness
  */
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include "Sequence.h"
+#include "SequenceView.h"
 
 using namespace std;
 
@@ -53,7 +56,62 @@ int main() {
     cout << boolalpha << s.empty() << endl;
     cout << s << endl;
 
+    // Walk with iterators and edit in place
+    Sequence colors;
+    for (string color : {"Red", "Orange", "Yellow", "Green", "Blue"}) {
+        colors.push_back(color);
+    }
+    for (auto it = colors.begin(); it != colors.end();) {
+        if (it->size() > 4) {
+            it = colors.erase(it);
+        } else {
+            it = ++colors.insert(it, "Light " + *it);
+            ++it;
+        }
+    }
+    cout << colors << endl;
+    for (auto it = colors.rbegin(); it != colors.rend(); ++it) {
+        cout << *it << " ";
+    }
+    cout << endl;
 
+    // Churn through the node pool and check how much of it was recycled
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 1000; i++) {
+            s.push_back("Teal");
+        }
+        while (!s.empty()) {
+            s.pop_back();
+        }
+    }
+    const SequencePoolStats &stats = s.allocationStats();
+    cout << "Node allocations: " << stats.nodeAllocations
+         << ", reused: " << stats.freeListReuses
+         << ", slabs allocated: " << stats.slabAllocations << endl;
+
+    // Save to a file, load it back and read it through a mapped view
+    const char *path = "SequenceDebug.seq";
+    {
+        ofstream out(path, ios::binary);
+        colors.save(out);
+    }
+    Sequence loaded;
+    {
+        ifstream in(path, ios::binary);
+        loaded.load(in);
+    } // closed before the file is removed
+    cout << "Loaded: " << loaded << endl;
+    {
+        SequenceView view(path);
+        cout << "Mapped " << view.size() << " elements, last: " << view[view.size() - 1] << endl;
+    }
+    remove(path);
+
+    // Per-operation profile, when built with SEQUENCE_PROFILE
+    if (SequenceProfiler::ENABLED) {
+        cout << endl << "Profile:" << endl;
+        SequenceProfiler::dump(cout, SequenceProfiler::snapshot());
+    }
 
     return 0;
 }
\ No newline at end of file
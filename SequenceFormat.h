@@ -0,0 +1,77 @@
+#ifndef SEQUENCEFORMAT_H
+#define SEQUENCEFORMAT_H
+
+#include <cstddef> // For size_t
+#include <cstdint> // std::uint64_t
+#include <concepts> // std::same_as
+
+/**
+ * Binary layout written by BasicSequence::save and read by load and by
+ * SequenceView. All integers are unsigned 64-bit little-endian.
+ *
+ *   header   "SEQBIN01"              8 bytes
+ *            element count           8 bytes
+ *   records  count x { length, bytes }
+ *   index    count x record offset   from the start of the file
+ *   trailer  index offset            8 bytes
+ *            "SEQIDX01"              8 bytes
+ *
+ * Records can be read front to back without the index, so save and load
+ * stream. The index and trailer sit at the end, where save knows them,
+ * and let SequenceView find any element of a mapped file in O(1).
+ */
+struct SequenceFormat {
+    static constexpr char MAGIC[8] = {'S', 'E', 'Q', 'B', 'I', 'N', '0', '1'}; // file header tag
+    static constexpr char INDEX_MAGIC[8] = {'S', 'E', 'Q', 'I', 'D', 'X', '0', '1'}; // trailer tag
+    static constexpr size_t HEADER_BYTES = 16; // magic + count
+    static constexpr size_t TRAILER_BYTES = 16; // index offset + magic
+    static constexpr size_t WORD_BYTES = 8; // every integer in the file
+
+    /**
+     * Stores value as 8 little-endian bytes.
+     *
+     * @param to Destination, at least 8 bytes.
+     * @param value Value to store.
+     */
+    static void putWord(char *to, std::uint64_t value) {
+        for (size_t i = 0; i < WORD_BYTES; i++) {
+            to[i] = static_cast<char>(value >> (8 * i));
+        }
+    }
+
+    /**
+     * Reads 8 little-endian bytes.
+     *
+     * @param from Source, at least 8 bytes.
+     * @return The value stored there.
+     */
+    static std::uint64_t getWord(const char *from) {
+        std::uint64_t value = 0;
+        for (size_t i = 0; i < WORD_BYTES; i++) {
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(from[i])) << (8 * i);
+        }
+        return value;
+    }
+};
+
+/**
+ * Element types that can be written as text or saved: contiguous runs of
+ * char, such as std::string, std::pmr::string or InternedString.
+ */
+template<class T>
+concept SequenceByteString = requires(const T cs) {
+    { cs.data() } -> std::same_as<const char *>;
+    { cs.size() } -> std::same_as<size_t>;
+};
+
+/**
+ * Element types that load can also read back: byte strings that can be
+ * resized and written in place.
+ */
+template<class T>
+concept SequenceByteBuffer = SequenceByteString<T> && requires(T s, size_t n) {
+    s.resize(n);
+    { s.data() } -> std::same_as<char *>;
+};
+
+#endif
@@ -0,0 +1,1306 @@
+/**
+ * SequenceFuzz.cpp
+ * Project 3
+ * CS 3100
+ *
+ * Differential fuzz test for Sequence. A stream of bytes is decoded into
+ * operations (push/pop at both ends, insert and erase by position and by
+ * iterator, ranges, splice, copies and snapshots, lookups with and without
+ * the hash index, sort/merge/unique/reverse, save/load, printing) that are
+ * applied both to a Sequence and to a std::vector reference. Every result,
+ * every exception and, every few operations, the whole contents must
+ * match. The first difference stops the run with the last operations that
+ * led to it.
+ *
+ * The first byte of an input picks what is tested: a Sequence of
+ * std::string, one of int, which takes the memcpy/memmove paths for
+ * trivially copyable elements, a HybridSequence, whose layout switches
+ * are forced by bursts of reads and inserts and by setPolicy/optimize, or
+ * a SequenceRing, checked against a std::deque. Its top bit lowers the
+ * SequenceParallelism threshold, so copies, teardown, sort and merge of
+ * the small sequences fuzzed here also run on several threads.
+ *
+ * Standalone, random byte streams are generated from a seed:
+ *
+ *   SequenceFuzz [--ops=N] [--seed=N] [file...]
+ *
+ *   --ops=<n>    operations to run, default 2000000
+ *   --seed=<n>   seed for the byte streams, default from the clock
+ *   file...      replay these inputs (for example crashes saved by
+ *                libFuzzer) instead of generating any
+ *
+ * Configured with -DSEQUENCE_LIBFUZZER=ON (Clang only), the same decoder
+ * is built as a libFuzzer target instead, and libFuzzer chooses the bytes.
+ * Either way, -DSEQUENCE_SANITIZE=ON adds AddressSanitizer and
+ * UndefinedBehaviorSanitizer.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory_resource>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Sequence.h"
+#include "SequenceHybrid.h"
+#include "SequenceRing.h"
+
+using namespace std;
+
+namespace {
+
+constexpr size_t MAX_ELEMENTS = 4000; // beyond this, inputs only shrink the sequence
+constexpr size_t PARALLEL_MIN_ELEMENTS = 256; // smallest sequence split across threads, when forced
+constexpr unsigned PARALLEL_WORKERS = 3; // threads per pass, when forced
+constexpr size_t CHECK_EVERY = 64; // operations between full comparisons
+constexpr size_t TRACE_LENGTH = 24; // operations shown when a check fails
+
+/**
+ * Reads the fuzz input a value at a time. Once the bytes run out every
+ * read returns 0 and done() turns true.
+ */
+class Input {
+private:
+    const uint8_t *bytes;
+    size_t left;
+
+public:
+    Input(const uint8_t *data, size_t size) : bytes(data), left(size) {
+    }
+
+    bool done() const {
+        return left == 0;
+    }
+
+    uint8_t byte() {
+        if (left == 0) {
+            return 0;
+        }
+        left--;
+        return *bytes++;
+    }
+
+    /**
+     * Reads a number in [0, bound); bound must be positive.
+     */
+    size_t below(size_t bound) {
+        size_t value = byte();
+        value = value << 8 | byte();
+        return value % bound;
+    }
+};
+
+/**
+ * The input, the trace of recent operations and the checks shared by the
+ * differential tests.
+ */
+class Checker {
+protected:
+    Input in;
+    const char *subject; // what is checked against the reference, for messages
+    vector<string> trace; // the last few operations, oldest first
+    size_t operations = 0;
+
+    Checker(const char *subject, const uint8_t *data, size_t size) : in(data, size), subject(subject) {
+    }
+    virtual ~Checker() = default;
+    virtual string sizes() const = 0; // Both sizes, for failure messages
+
+    [[noreturn]] void fail(const string &what);
+    void check(bool ok, const string &what);
+    template<class Error, class Fn>
+    void expectThrow(Fn fn, const string &what);
+    template<class Fn>
+    void expectOutOfRange(Fn fn, const string &what);
+    void log(string text);
+    size_t position(size_t bound);
+};
+
+/**
+ * Prints the failed check with the operations that led to it and stops
+ * the process, so libFuzzer records the input as a crash.
+ */
+void Checker::fail(const string &what) {
+    cerr << subject << " and reference differ after " << operations << " operations: " << what << "\n"
+         << "Last operations:\n";
+    for (const string &line : trace) {
+        cerr << "  " << line << "\n";
+    }
+    cerr << sizes() << endl;
+    abort();
+}
+
+void Checker::check(bool ok, const string &what) {
+    if (!ok) {
+        fail(what);
+    }
+}
+
+/**
+ * Checks that fn throws Error, as the reference says it must.
+ */
+template<class Error, class Fn>
+void Checker::expectThrow(Fn fn, const string &what) {
+    try {
+        fn();
+    } catch (const Error &) {
+        return;
+    }
+    fail(what + " did not throw the expected exception");
+}
+
+template<class Fn>
+void Checker::expectOutOfRange(Fn fn, const string &what) {
+    expectThrow<out_of_range>(fn, what);
+}
+
+void Checker::log(string text) {
+    if (trace.size() == TRACE_LENGTH) {
+        trace.erase(trace.begin());
+    }
+    trace.push_back(std::move(text));
+}
+
+/**
+ * Decodes a position in [0, bound]; bound itself is one past the end.
+ */
+size_t Checker::position(size_t bound) {
+    return in.below(bound + 1);
+}
+
+/**
+ * Decodes an element: mostly short values from a small set, so lookups
+ * and unique find duplicates, sometimes a long string that lives on the
+ * heap or a large number.
+ */
+template<class T>
+T decodeValue(Input &in);
+
+template<>
+string decodeValue<string>(Input &in) {
+    const uint8_t kind = in.byte();
+    string item = to_string(in.below(kind < 200 ? 40 : 100000));
+    if (kind >= 240) {
+        item.append(32, 'x');
+    }
+    return item;
+}
+
+template<>
+int decodeValue<int>(Input &in) {
+    const uint8_t kind = in.byte();
+    return static_cast<int>(in.below(kind < 200 ? 40 : 100000));
+}
+
+/**
+ * Text of an element for the trace.
+ */
+string show(const string &item) {
+    return item;
+}
+
+string show(int item) {
+    return to_string(item);
+}
+
+/**
+ * Key for the stable sort with a comparator: ties are common, so the
+ * order of equal elements is checked too.
+ */
+size_t sortKey(const string &item) {
+    return item.size();
+}
+
+size_t sortKey(int item) {
+    return static_cast<size_t>(item) % 10;
+}
+
+/**
+ * Applies one decoded input to a Sequence and to the reference, checking
+ * them against each other as it goes.
+ *
+ * @tparam T Element type, std::string or int.
+ */
+template<class T>
+class Differential : private Checker {
+private:
+    BasicSequence<T> s;
+    vector<T> ref;
+    BasicSequence<T> snapshot; // a copy that later changes to s must not reach
+    vector<T> snapshotRef;
+
+    string sizes() const override;
+    void compareAll();
+    T value();
+    void step();
+
+public:
+    Differential(const uint8_t *data, size_t size) : Checker("Sequence", data, size) {
+    }
+
+    size_t run(); // Runs every operation in the input; returns how many
+};
+
+template<class T>
+string Differential<T>::sizes() const {
+    return "size " + to_string(s.size()) + ", reference size " + to_string(ref.size());
+}
+
+/**
+ * Compares everything observable: size, indexing, forward and backward
+ * iteration, front/back and the printed text, plus the snapshot.
+ */
+template<class T>
+void Differential<T>::compareAll() {
+    check(s.size() == ref.size(), "size");
+    check(s.empty() == ref.empty(), "empty");
+    const BasicSequence<T> &cs = s;
+    check(equal(cs.begin(), cs.end(), ref.begin(), ref.end()), "forward iteration");
+    check(equal(cs.rbegin(), cs.rend(), ref.rbegin(), ref.rend()), "backward iteration");
+    for (size_t i = 0; i < ref.size(); i++) {
+        check(cs[i] == ref[i], "operator[] at " + to_string(i));
+    }
+    if (!ref.empty()) {
+        check(cs.front() == ref.front() && cs.back() == ref.back(), "front/back");
+    }
+    ostringstream text;
+    text << cs;
+    ostringstream expected;
+    expected << "<";
+    for (size_t i = 0; i < ref.size(); i++) {
+        expected << (i == 0 ? "" : ", ") << ref[i];
+    }
+    expected << ">";
+    check(text.str() == expected.str(), "operator<<");
+    if constexpr (SequenceByteString<T>) {
+        check(cs.formattedSize() == expected.str().size(), "formattedSize");
+    }
+    check(equal(snapshot.begin(), snapshot.end(), snapshotRef.begin(), snapshotRef.end()), "snapshot changed");
+}
+
+template<class T>
+T Differential<T>::value() {
+    return decodeValue<T>(in);
+}
+
+/**
+ * Decodes and applies one operation.
+ */
+template<class T>
+void Differential<T>::step() {
+    enum Op {
+        PUSH_BACK, EMPLACE_BACK, POP_BACK, PUSH_FRONT, POP_FRONT, INSERT, INSERT_AT, ERASE, ERASE_AT,
+        ERASE_RANGE, INDEX, ASSIGN_AT, FRONT_BACK, INSERT_RANGE, APPEND, ASSIGN, SPLICE, COPY, MOVE,
+        SNAPSHOT, CLEAR, LOOKUP, INDEXING, SORT, MERGE, UNIQUE, REVERSE, SAVE_LOAD, WALK, RESERVE, VIEW, EXTRACT,
+        COMPARE, COUNT
+    };
+    Op op = static_cast<Op>(in.byte() % COUNT);
+    if (ref.size() > MAX_ELEMENTS && (op == INSERT_RANGE || op == APPEND || op == SPLICE || op == MERGE)) {
+        op = ERASE_RANGE; // keep each operation cheap
+    }
+    const size_t n = ref.size();
+
+    switch (op) {
+        case PUSH_BACK: {
+            T item = value();
+            log("push_back(" + show(item) + ")");
+            s.push_back(item);
+            ref.push_back(item);
+            break;
+        }
+        case EMPLACE_BACK: {
+            const size_t length = in.below(20);
+            if constexpr (is_same_v<T, string>) {
+                log("emplace_back(" + to_string(length) + ", 'e')");
+                check(s.emplace_back(length, 'e') == string(length, 'e'), "emplace_back result");
+                ref.emplace_back(length, 'e');
+            } else {
+                log("emplace_back(" + to_string(length) + ")");
+                check(s.emplace_back(static_cast<T>(length)) == static_cast<T>(length), "emplace_back result");
+                ref.emplace_back(static_cast<T>(length));
+            }
+            break;
+        }
+        case POP_BACK:
+            log("pop_back()");
+            if (n == 0) {
+                expectOutOfRange([&] { s.pop_back(); }, "pop_back on empty");
+            } else {
+                s.pop_back();
+                ref.pop_back();
+            }
+            break;
+        case PUSH_FRONT: {
+            T item = value();
+            log("push_front(" + show(item) + ")");
+            s.push_front(item);
+            ref.insert(ref.begin(), item);
+            break;
+        }
+        case POP_FRONT:
+            log("pop_front()");
+            if (n == 0) {
+                expectOutOfRange([&] { s.pop_front(); }, "pop_front on empty");
+            } else {
+                s.pop_front();
+                ref.erase(ref.begin());
+            }
+            break;
+        case INSERT: {
+            const size_t at = in.below(n + 2); // n + 1 is out of range
+            T item = value();
+            log("insert(" + to_string(at) + ", " + show(item) + ")");
+            if (at > n) {
+                expectOutOfRange([&] { s.insert(at, item); }, "insert past the end");
+            } else {
+                s.insert(at, item);
+                ref.insert(ref.begin() + at, item);
+            }
+            break;
+        }
+        case INSERT_AT: {
+            const size_t at = position(n);
+            T item = value();
+            log("insert(begin() + " + to_string(at) + ", " + show(item) + ")");
+            auto it = s.begin();
+            advance(it, at);
+            auto inserted = s.insert(it, item);
+            ref.insert(ref.begin() + at, item);
+            check(*inserted == item, "insert(iterator) result");
+            check(distance(s.begin(), inserted) == static_cast<ptrdiff_t>(at), "insert(iterator) position");
+            break;
+        }
+        case ERASE: {
+            const size_t at = position(n); // n is out of range
+            log("erase(" + to_string(at) + ")");
+            if (at == n) {
+                expectOutOfRange([&] { s.erase(at); }, "erase past the end");
+            } else {
+                s.erase(at);
+                ref.erase(ref.begin() + at);
+            }
+            break;
+        }
+        case ERASE_AT: {
+            if (n == 0) {
+                break;
+            }
+            const size_t at = in.below(n);
+            log("erase(begin() + " + to_string(at) + ")");
+            auto it = s.begin();
+            advance(it, at);
+            auto after = s.erase(it);
+            ref.erase(ref.begin() + at);
+            check(distance(s.begin(), after) == static_cast<ptrdiff_t>(at), "erase(iterator) position");
+            check(at == ref.size() ? after == s.end() : *after == ref[at], "erase(iterator) result");
+            break;
+        }
+        case ERASE_RANGE: {
+            const size_t at = position(n);
+            const size_t count = in.below(n + 2);
+            log("erase(" + to_string(at) + ", " + to_string(count) + ")");
+            if (at >= n || count > n - at) {
+                expectOutOfRange([&] { s.erase(at, count); }, "erase of a range past the end");
+            } else {
+                s.erase(at, count);
+                ref.erase(ref.begin() + at, ref.begin() + at + count);
+            }
+            break;
+        }
+        case INDEX: {
+            const size_t at = position(n);
+            log("operator[](" + to_string(at) + ")");
+            const BasicSequence<T> &cs = s;
+            if (at == n) {
+                expectOutOfRange([&] { (void) cs[at]; }, "operator[] past the end");
+            } else {
+                check(cs[at] == ref[at], "operator[] at " + to_string(at));
+            }
+            break;
+        }
+        case ASSIGN_AT: {
+            if (n == 0) {
+                break;
+            }
+            const size_t at = in.below(n);
+            T item = value();
+            log("s[" + to_string(at) + "] = " + show(item));
+            s[at] = item;
+            ref[at] = item;
+            break;
+        }
+        case FRONT_BACK:
+            log("front()/back()");
+            if (n == 0) {
+                expectOutOfRange([&] { (void) s.front(); }, "front on empty");
+                expectOutOfRange([&] { (void) s.back(); }, "back on empty");
+            } else {
+                check(s.front() == ref.front() && s.back() == ref.back(), "front/back");
+            }
+            break;
+        case INSERT_RANGE: {
+            const size_t at = in.below(n + 2);
+            vector<T> items(in.below(80));
+            for (T &item : items) {
+                item = value();
+            }
+            log("insert(" + to_string(at) + ", " + to_string(items.size()) + " elements)");
+            if (at > n) {
+                expectOutOfRange([&] { s.insert(at, items.begin(), items.end()); }, "range insert past the end");
+            } else {
+                s.insert(at, items.begin(), items.end());
+                ref.insert(ref.begin() + at, items.begin(), items.end());
+            }
+            break;
+        }
+        case APPEND: {
+            vector<T> items(in.below(120));
+            for (T &item : items) {
+                item = value();
+            }
+            log("append(" + to_string(items.size()) + " elements)");
+            s.append(items.begin(), items.end());
+            ref.insert(ref.end(), items.begin(), items.end());
+            break;
+        }
+        case ASSIGN: {
+            vector<T> items(in.below(120));
+            for (T &item : items) {
+                item = value();
+            }
+            log("assign(" + to_string(items.size()) + " elements)");
+            s.assign(items);
+            ref = items;
+            break;
+        }
+        case SPLICE: {
+            const size_t at = in.below(n + 2);
+            BasicSequence<T> other;
+            vector<T> items(in.below(120));
+            for (T &item : items) {
+                item = value();
+                other.push_back(item);
+            }
+            log("splice(" + to_string(at) + ", " + to_string(items.size()) + " elements)");
+            if (at > n) {
+                expectOutOfRange([&] { s.splice(at, std::move(other)); }, "splice past the end");
+            } else {
+                s.splice(at, std::move(other));
+                ref.insert(ref.begin() + at, items.begin(), items.end());
+                check(other.empty(), "splice left its source non-empty");
+            }
+            break;
+        }
+        case COPY: {
+            log("copy, change the copy, copy back");
+            BasicSequence<T> copy(s);
+            check(copy.size() == n, "copy size");
+            copy.push_back(T());
+            check(s.size() == n, "a change to a copy reached the original");
+            BasicSequence<T> assigned;
+            assigned = copy;
+            assigned.pop_back();
+            s = assigned;
+            break;
+        }
+        case MOVE: {
+            log("move construct and move assign");
+            BasicSequence<T> moved(std::move(s));
+            check(s.empty(), "moved-from sequence not empty");
+            s = std::move(moved);
+            break;
+        }
+        case SNAPSHOT:
+            log("snapshot = s");
+            snapshot = s;
+            snapshotRef = ref;
+            break;
+        case CLEAR:
+            if (in.below(4) != 0) {
+                break; // rare: it throws away everything built so far
+            }
+            log("clear()");
+            s.clear();
+            ref.clear();
+            break;
+        case LOOKUP: {
+            T item = n != 0 && in.below(2) == 0 ? ref[in.below(n)] : value();
+            const size_t from = position(n + 1);
+            log("find/count/contains/positions(" + show(item) + ", " + to_string(from) + ")");
+            const auto found = from < n ? std::find(ref.begin() + from, ref.end(), item) : ref.end();
+            const size_t expected = found == ref.end() ? BasicSequence<T>::npos : static_cast<size_t>(found - ref.begin());
+            check(s.find(item, from) == expected, "find");
+            check(s.count(item) == static_cast<size_t>(std::count(ref.begin(), ref.end(), item)), "count");
+            check(s.contains(item) == (std::find(ref.begin(), ref.end(), item) != ref.end()), "contains");
+            vector<size_t> at;
+            for (size_t i = 0; i < n; i++) {
+                if (ref[i] == item) {
+                    at.push_back(i);
+                }
+            }
+            check(s.positions(item) == at, "positions");
+            break;
+        }
+        case INDEXING:
+            if (s.indexed()) {
+                log("disableIndex()");
+                s.disableIndex();
+            } else {
+                log("enableIndex()");
+                s.enableIndex();
+            }
+            break;
+        case SORT: {
+            auto byKey = [](const T &a, const T &b) { return sortKey(a) < sortKey(b); };
+            if (in.below(2) == 0) {
+                log("sort()");
+                s.sort();
+                stable_sort(ref.begin(), ref.end());
+            } else {
+                log("sort(by key)");
+                s.sort(byKey); // stable: equal keys keep their order
+                stable_sort(ref.begin(), ref.end(), byKey);
+            }
+            break;
+        }
+        case MERGE: {
+            vector<T> items(in.below(120));
+            for (T &item : items) {
+                item = value();
+            }
+            std::sort(items.begin(), items.end());
+            BasicSequence<T> other;
+            other.append(items.begin(), items.end());
+            log("sort(), merge(" + to_string(items.size()) + " sorted elements)");
+            s.sort();
+            std::sort(ref.begin(), ref.end());
+            s.merge(std::move(other));
+            vector<T> merged;
+            std::merge(ref.begin(), ref.end(), items.begin(), items.end(), back_inserter(merged));
+            ref = std::move(merged);
+            check(other.empty(), "merge left its source non-empty");
+            break;
+        }
+        case UNIQUE: {
+            log("unique()");
+            const size_t removed = s.unique();
+            const size_t before = ref.size();
+            ref.erase(std::unique(ref.begin(), ref.end()), ref.end());
+            check(removed == before - ref.size(), "unique count");
+            break;
+        }
+        case REVERSE:
+            log("reverse()");
+            s.reverse();
+            std::reverse(ref.begin(), ref.end());
+            break;
+        case SAVE_LOAD: {
+            if constexpr (SequenceByteString<T>) {
+                log("save, load");
+                stringstream file(ios::in | ios::out | ios::binary);
+                s.save(file);
+                BasicSequence<T> loaded;
+                loaded.push_back("overwritten");
+                loaded.load(file);
+                check(equal(loaded.begin(), loaded.end(), ref.begin(), ref.end()), "save/load round trip");
+            }
+            break;
+        }
+        case WALK: {
+            const size_t at = position(n);
+            log("walk from " + to_string(at));
+            auto it = s.cbegin();
+            advance(it, at);
+            for (size_t i = at; i < n && i < at + 40; i++, ++it) {
+                check(*it == ref[i], "iterator at " + to_string(i));
+            }
+            for (size_t i = 0; i < 40 && it != s.cbegin(); i++) {
+                --it;
+            }
+            break;
+        }
+        case RESERVE: {
+            const size_t extra = in.below(300);
+            log("reserve(size() + " + to_string(extra) + ")");
+            s.reserve(n + extra);
+            break;
+        }
+        case VIEW: {
+            const size_t at = position(n);
+            const size_t count = in.below(n + 2);
+            log("view(" + to_string(at) + ", " + to_string(count) + ")");
+            const BasicSequence<T> &cs = s;
+            if (count > n - at) {
+                expectOutOfRange([&] { (void) cs.view(at, count); }, "view past the end");
+                break;
+            }
+            const SequenceSlice<T> slice = cs.view(at, count);
+            check(slice.size() == count && slice.position() == at, "view size");
+            check(equal(slice.begin(), slice.end(), ref.begin() + at, ref.begin() + at + count), "view elements");
+            if (count != 0) {
+                check(slice.front() == ref[at] && slice.back() == ref[at + count - 1], "view front/back");
+            }
+            break;
+        }
+        case EXTRACT: {
+            const size_t at = position(n);
+            const size_t count = in.below(n + 2);
+            const size_t to = in.below(n + 1);
+            log("extract(" + to_string(at) + ", " + to_string(count) + "), splice at " + to_string(to));
+            if (count > n - at) {
+                expectOutOfRange([&] { (void) s.extract(at, count); }, "extract past the end");
+                break;
+            }
+            BasicSequence<T> moved = s.extract(at, count);
+            vector<T> items(ref.begin() + at, ref.begin() + at + count);
+            ref.erase(ref.begin() + at, ref.begin() + at + count);
+            check(equal(moved.begin(), moved.end(), items.begin(), items.end()), "extract elements");
+            check(s.size() == ref.size(), "size after extract");
+            const size_t back = to < ref.size() ? to : ref.size();
+            s.splice(back, std::move(moved));
+            ref.insert(ref.begin() + back, items.begin(), items.end());
+            break;
+        }
+        case COMPARE: {
+            // The copy is built in one append, so its blocks split differently
+            vector<T> items = ref;
+            const uint8_t change = in.byte() % 4;
+            if (change == 1 && !items.empty()) {
+                items[in.below(items.size())] = value();
+            } else if (change == 2 && !items.empty()) {
+                items.pop_back();
+            } else if (change == 3) {
+                items.push_back(value());
+            }
+            log("compare with a rebuilt copy (change " + to_string(change) + ")");
+            BasicSequence<T> other;
+            other.append(items.begin(), items.end());
+            const BasicSequence<T> &cs = s;
+            check((cs == other) == (ref == items), "operator==");
+            check((cs <=> other) == (ref <=> items), "operator<=>");
+            check((other <=> cs) == (items <=> ref), "operator<=> reversed");
+            if (ref == items) {
+                check(cs.hash() == other.hash(), "hash of equal sequences");
+            }
+            break;
+        }
+        case COUNT:
+            break;
+    }
+
+    check(s.size() == ref.size(), "size");
+    operations++;
+    if (operations % CHECK_EVERY == 0) {
+        compareAll();
+    }
+}
+
+/**
+ * Runs every operation the input encodes, then compares everything once
+ * more.
+ */
+template<class T>
+size_t Differential<T>::run() {
+    if (in.byte() % 2 == 0) {
+        s.enableIndex();
+    }
+    while (!in.done()) {
+        step();
+    }
+    compareAll();
+    return operations;
+}
+
+/**
+ * Applies one decoded input to a HybridSequence and to a vector reference.
+ * Bursts of reads and of middle inserts push the adaptive policy towards
+ * each layout, and setPolicy/optimize force switches, so every operation
+ * is checked in both layouts and across conversions.
+ */
+class HybridDifferential : private Checker {
+private:
+    HybridSequence h;
+    vector<string> ref;
+
+    string sizes() const override;
+    void compareAll();
+    void step();
+
+public:
+    HybridDifferential(const uint8_t *data, size_t size) : Checker("HybridSequence", data, size) {
+    }
+
+    size_t run(); // Runs every operation in the input; returns how many
+};
+
+string HybridDifferential::sizes() const {
+    return "size " + to_string(h.size()) + ", reference size " + to_string(ref.size()) + ", layout "
+           + (h.representation() == SequenceLayout::LINKED ? "linked" : "contiguous");
+}
+
+/**
+ * Compares everything observable: size, indexing, for_each, front/back,
+ * the printed text and the layout reported by stats().
+ */
+void HybridDifferential::compareAll() {
+    check(h.size() == ref.size(), "size");
+    check(h.empty() == ref.empty(), "empty");
+    const HybridSequence &ch = h;
+    for (size_t i = 0; i < ref.size(); i++) {
+        check(ch[i] == ref[i], "operator[] at " + to_string(i));
+    }
+    size_t at = 0;
+    ch.for_each([&](const string &item) {
+        check(at < ref.size() && item == ref[at], "for_each at " + to_string(at));
+        at++;
+    });
+    check(at == ref.size(), "for_each count");
+    if (!ref.empty()) {
+        check(ch.front() == ref.front() && ch.back() == ref.back(), "front/back");
+    }
+    ostringstream text;
+    text << ch;
+    string expected = "<";
+    for (size_t i = 0; i < ref.size(); i++) {
+        expected += (i == 0 ? "" : ", ") + ref[i];
+    }
+    check(text.str() == expected + ">", "operator<<");
+    check(h.stats().layout == h.representation(), "stats layout");
+}
+
+/**
+ * Decodes and applies one operation.
+ */
+void HybridDifferential::step() {
+    enum Op {
+        PUSH_BACK, EMPLACE_BACK, EMPLACE_OWN, POP_BACK, INSERT, ERASE, INDEX, ASSIGN_AT, FRONT_BACK, READS,
+        MIDDLE_INSERTS, CLEAR, POLICY, OPTIMIZE, COUNT
+    };
+    Op op = static_cast<Op>(in.byte() % COUNT);
+    if (ref.size() > MAX_ELEMENTS && (op == PUSH_BACK || op == EMPLACE_BACK || op == MIDDLE_INSERTS)) {
+        op = ERASE; // keep the sequence small enough to compare often
+    }
+    const size_t n = ref.size();
+
+    switch (op) {
+        case PUSH_BACK: {
+            string item = decodeValue<string>(in);
+            log("push_back(" + item + ")");
+            h.push_back(item);
+            ref.push_back(item);
+            break;
+        }
+        case EMPLACE_BACK: {
+            const size_t length = in.below(20);
+            log("emplace_back(" + to_string(length) + ", 'e')");
+            check(h.emplace_back(length, 'e') == string(length, 'e'), "emplace_back result");
+            ref.emplace_back(length, 'e');
+            break;
+        }
+        case EMPLACE_OWN: {
+            if (n == 0) {
+                break;
+            }
+            // Often after a window of scattered reads, so the emplace is the
+            // change that switches to the contiguous layout
+            const size_t reads = in.below(2) == 0 ? 4096 : 0;
+            const size_t at = in.below(n);
+            log(to_string(reads) + " reads, emplace_back(h[" + to_string(at) + "])");
+            for (size_t i = 0; i < reads; i++) {
+                check(h[i * 7919 % n] == ref[i * 7919 % n], "operator[] at " + to_string(i * 7919 % n));
+            }
+            string item = ref[at];
+            check(h.emplace_back(h[at]) == item, "emplace_back of an own element");
+            ref.push_back(item);
+            break;
+        }
+        case POP_BACK:
+            log("pop_back()");
+            if (n == 0) {
+                expectOutOfRange([&] { h.pop_back(); }, "pop_back on empty");
+            } else {
+                h.pop_back();
+                ref.pop_back();
+            }
+            break;
+        case INSERT: {
+            const size_t at = in.below(n + 2); // n + 1 is out of range
+            string item = decodeValue<string>(in);
+            log("insert(" + to_string(at) + ", " + item + ")");
+            if (at > n) {
+                expectOutOfRange([&] { h.insert(at, item); }, "insert past the end");
+            } else {
+                h.insert(at, item);
+                ref.insert(ref.begin() + at, item);
+            }
+            break;
+        }
+        case ERASE: {
+            const size_t at = position(n); // n is out of range
+            log("erase(" + to_string(at) + ")");
+            if (at == n) {
+                expectOutOfRange([&] { h.erase(at); }, "erase past the end");
+            } else {
+                h.erase(at);
+                ref.erase(ref.begin() + at);
+            }
+            break;
+        }
+        case INDEX: {
+            const size_t at = position(n);
+            log("operator[](" + to_string(at) + ")");
+            const HybridSequence &ch = h;
+            if (at == n) {
+                expectOutOfRange([&] { (void) ch[at]; }, "operator[] past the end");
+            } else {
+                check(ch[at] == ref[at], "operator[] at " + to_string(at));
+            }
+            break;
+        }
+        case ASSIGN_AT: {
+            if (n == 0) {
+                break;
+            }
+            const size_t at = in.below(n);
+            string item = decodeValue<string>(in);
+            log("h[" + to_string(at) + "] = " + item);
+            h[at] = item;
+            ref[at] = item;
+            break;
+        }
+        case FRONT_BACK:
+            log("front()/back()");
+            if (n == 0) {
+                expectOutOfRange([&] { (void) h.front(); }, "front on empty");
+                expectOutOfRange([&] { (void) h.back(); }, "back on empty");
+            } else {
+                check(h.front() == ref.front() && h.back() == ref.back(), "front/back");
+            }
+            break;
+        case READS: {
+            // Scattered reads fill the window in favour of the contiguous layout
+            if (n == 0) {
+                break;
+            }
+            const size_t count = in.below(512);
+            const size_t stride = in.below(n) | 1;
+            log(to_string(count) + " reads with stride " + to_string(stride));
+            for (size_t i = 0, at = 0; i < count; i++, at = (at + stride) % n) {
+                check(h[at] == ref[at], "operator[] at " + to_string(at));
+            }
+            break;
+        }
+        case MIDDLE_INSERTS: {
+            // Inserts far from the back favour the linked layout
+            const size_t count = in.below(64);
+            log(to_string(count) + " inserts in the middle");
+            for (size_t i = 0; i < count; i++) {
+                const size_t at = ref.size() / 2;
+                string item = to_string(i);
+                h.insert(at, item);
+                ref.insert(ref.begin() + at, item);
+            }
+            break;
+        }
+        case CLEAR:
+            if (in.below(4) != 0) {
+                break; // rare: it throws away everything built so far
+            }
+            log("clear()");
+            h.clear();
+            ref.clear();
+            break;
+        case POLICY: {
+            const auto policy = static_cast<SequencePolicy>(in.below(3));
+            log("setPolicy(" + to_string(static_cast<int>(policy)) + ")");
+            h.setPolicy(policy);
+            if (policy == SequencePolicy::LINKED) {
+                check(h.representation() == SequenceLayout::LINKED, "setPolicy(LINKED) layout");
+            } else if (policy == SequencePolicy::CONTIGUOUS) {
+                check(h.representation() == SequenceLayout::CONTIGUOUS, "setPolicy(CONTIGUOUS) layout");
+            }
+            check(h.stats().policy == policy, "stats policy");
+            break;
+        }
+        case OPTIMIZE: {
+            log("optimize()");
+            const SequenceLayout before = h.representation();
+            h.optimize();
+            if (h.stats().policy != SequencePolicy::ADAPTIVE) {
+                check(h.representation() == before, "optimize switched a pinned layout");
+            }
+            break;
+        }
+        case COUNT:
+            break;
+    }
+
+    check(h.size() == ref.size(), "size");
+    operations++;
+    if (operations % CHECK_EVERY == 0) {
+        compareAll();
+    }
+}
+
+/**
+ * Runs every operation the input encodes, then compares everything once
+ * more.
+ */
+size_t HybridDifferential::run() {
+    while (!in.done()) {
+        step();
+    }
+    compareAll();
+    return operations;
+}
+
+/**
+ * Applies one decoded input to a SequenceRing and to a std::deque
+ * reference. The capacity is small, so the ring fills, wraps around and
+ * rejects pushes often. Its storage comes from a memory resource, and
+ * copies and moves go through rings on a second resource, so both the
+ * buffer-stealing and the element-by-element assignments are checked.
+ */
+class RingDifferential : private Checker {
+private:
+    using Ring = BasicSequenceRing<string, pmr::polymorphic_allocator<string>>;
+
+    pmr::unsynchronized_pool_resource home; // r's storage
+    pmr::unsynchronized_pool_resource away; // storage of the rings r is copied and moved through
+    Ring r;
+    deque<string> ref;
+    size_t capacity; // r's capacity, fixed for the run
+
+    string sizes() const override;
+    void compareAll();
+    bool matches(const Ring &ring) const;
+    void step();
+
+public:
+    RingDifferential(const uint8_t *data, size_t size)
+        : Checker("SequenceRing", data, size), r(in.below(48), &home), capacity(r.capacity()) {
+    }
+
+    size_t run(); // Runs every operation in the input; returns how many
+};
+
+string RingDifferential::sizes() const {
+    return "size " + to_string(r.size()) + ", reference size " + to_string(ref.size()) + ", capacity "
+           + to_string(capacity);
+}
+
+/**
+ * Checks that ring holds the reference's elements and has r's capacity.
+ */
+bool RingDifferential::matches(const Ring &ring) const {
+    return ring.capacity() == capacity && equal(ring.begin(), ring.end(), ref.begin(), ref.end());
+}
+
+/**
+ * Compares everything observable: size, capacity, indexing, forward and
+ * backward iteration, front/back and the printed text.
+ */
+void RingDifferential::compareAll() {
+    check(r.size() == ref.size(), "size");
+    check(r.empty() == ref.empty() && r.full() == (ref.size() == capacity), "empty/full");
+    check(r.capacity() == capacity, "capacity");
+    const Ring &cr = r;
+    check(equal(cr.begin(), cr.end(), ref.begin(), ref.end()), "forward iteration");
+    check(equal(make_reverse_iterator(cr.end()), make_reverse_iterator(cr.begin()), ref.rbegin(), ref.rend()),
+          "backward iteration");
+    for (size_t i = 0; i < ref.size(); i++) {
+        check(cr[i] == ref[i], "operator[] at " + to_string(i));
+    }
+    if (!ref.empty()) {
+        check(cr.front() == ref.front() && cr.back() == ref.back(), "front/back");
+    }
+    ostringstream text;
+    text << cr;
+    string expected = "<";
+    for (size_t i = 0; i < ref.size(); i++) {
+        expected += (i == 0 ? "" : ", ") + ref[i];
+    }
+    check(text.str() == expected + ">", "operator<<");
+}
+
+/**
+ * Decodes and applies one operation.
+ */
+void RingDifferential::step() {
+    enum Op {
+        PUSH_BACK, EMPLACE_BACK, PUSH_FRONT, EMPLACE_FRONT, POP_BACK, POP_FRONT, INDEX, ASSIGN_AT, FRONT_BACK,
+        WALK, COPY, MOVE, CLEAR, COUNT
+    };
+    const Op op = static_cast<Op>(in.byte() % COUNT);
+    const size_t n = ref.size();
+    const bool full = n == capacity;
+
+    switch (op) {
+        case PUSH_BACK:
+        case PUSH_FRONT: {
+            string item = decodeValue<string>(in);
+            const bool back = op == PUSH_BACK;
+            log(string(back ? "push_back(" : "push_front(") + item + ")");
+            if (full) {
+                expectThrow<length_error>([&] { back ? r.push_back(item) : r.push_front(item); }, "push onto a full ring");
+            } else if (back) {
+                r.push_back(item);
+                ref.push_back(item);
+            } else {
+                r.push_front(item);
+                ref.push_front(item);
+            }
+            break;
+        }
+        case EMPLACE_BACK:
+        case EMPLACE_FRONT: {
+            const size_t length = in.below(40);
+            const bool back = op == EMPLACE_BACK;
+            log(string(back ? "emplace_back(" : "emplace_front(") + to_string(length) + ", 'e')");
+            if (full) {
+                expectThrow<length_error>([&] { back ? r.emplace_back(length, 'e') : r.emplace_front(length, 'e'); },
+                                          "emplace onto a full ring");
+            } else if (back) {
+                check(r.emplace_back(length, 'e') == string(length, 'e'), "emplace_back result");
+                ref.emplace_back(length, 'e');
+            } else {
+                check(r.emplace_front(length, 'e') == string(length, 'e'), "emplace_front result");
+                ref.emplace_front(length, 'e');
+            }
+            break;
+        }
+        case POP_BACK:
+            log("pop_back()");
+            if (n == 0) {
+                expectOutOfRange([&] { r.pop_back(); }, "pop_back on empty");
+            } else {
+                r.pop_back();
+                ref.pop_back();
+            }
+            break;
+        case POP_FRONT:
+            log("pop_front()");
+            if (n == 0) {
+                expectOutOfRange([&] { r.pop_front(); }, "pop_front on empty");
+            } else {
+                r.pop_front();
+                ref.pop_front();
+            }
+            break;
+        case INDEX: {
+            const size_t at = position(n);
+            log("operator[](" + to_string(at) + ")");
+            const Ring &cr = r;
+            if (at == n) {
+                expectOutOfRange([&] { (void) cr[at]; }, "operator[] past the end");
+            } else {
+                check(cr[at] == ref[at], "operator[] at " + to_string(at));
+            }
+            break;
+        }
+        case ASSIGN_AT: {
+            if (n == 0) {
+                break;
+            }
+            const size_t at = in.below(n);
+            string item = decodeValue<string>(in);
+            log("r[" + to_string(at) + "] = " + item);
+            r[at] = item;
+            ref[at] = item;
+            break;
+        }
+        case FRONT_BACK:
+            log("front()/back()");
+            if (n == 0) {
+                expectOutOfRange([&] { (void) r.front(); }, "front on empty");
+                expectOutOfRange([&] { (void) r.back(); }, "back on empty");
+            } else {
+                check(r.front() == ref.front() && r.back() == ref.back(), "front/back");
+            }
+            break;
+        case WALK: {
+            const size_t at = position(n);
+            log("walk from " + to_string(at));
+            check(r.end() - r.begin() == static_cast<ptrdiff_t>(n), "end() - begin()");
+            Ring::iterator it = r.begin() + static_cast<ptrdiff_t>(at);
+            for (size_t i = at; i < n; i++, ++it) {
+                check(*it == ref[i] && r.begin()[static_cast<ptrdiff_t>(i)] == ref[i], "iterator at " + to_string(i));
+            }
+            Ring::const_iterator back = it;
+            for (size_t i = n; i > at; i--) {
+                check(*--back == ref[i - 1], "iterator at " + to_string(i - 1));
+            }
+            break;
+        }
+        case COPY: {
+            log("copy, change the copy, copy assign through another resource and back");
+            Ring copy(r);
+            check(matches(copy), "copy");
+            if (!copy.empty()) {
+                copy.pop_front();
+            } else if (!copy.full()) {
+                copy.push_back("copy");
+            }
+            check(matches(r), "a change to a copy reached the original");
+            Ring other(in.below(48), &away);
+            other = r;
+            check(matches(other), "copy assignment");
+            r = other;
+            break;
+        }
+        case MOVE: {
+            const bool across = in.below(2) == 0;
+            log(string("move construct, move assign through ") + (across ? "another" : "the same") + " resource");
+            Ring moved(std::move(r));
+            check(r.empty() && r.capacity() == 0, "moved-from ring kept its storage");
+            Ring other(in.below(48), across ? &away : &home);
+            other = std::move(moved);
+            check(moved.empty(), "moved-from ring not empty");
+            check(matches(other), "move assignment");
+            r = std::move(other);
+            break;
+        }
+        case CLEAR:
+            log("clear()");
+            r.clear();
+            ref.clear();
+            break;
+        case COUNT:
+            break;
+    }
+
+    check(r.size() == ref.size(), "size");
+    operations++;
+    if (operations % CHECK_EVERY == 0) {
+        compareAll();
+    }
+}
+
+/**
+ * Runs every operation the input encodes, then compares everything once
+ * more.
+ */
+size_t RingDifferential::run() {
+    while (!in.done()) {
+        step();
+    }
+    compareAll();
+    return operations;
+}
+
+/**
+ * Runs one input through the test its first byte picks.
+ *
+ * @return Number of operations run.
+ */
+size_t runInput(const uint8_t *data, size_t size) {
+    enum Target {
+        STRING_SEQUENCE, INT_SEQUENCE, HYBRID, RING, TARGETS
+    };
+    if (size == 0) {
+        return Differential<string>(data, size).run();
+    }
+    // The top bit forces copies, teardown and sorts of a few hundred
+    // elements onto several threads, which MAX_ELEMENTS never reaches otherwise
+    if ((data[0] & 0x80) != 0) {
+        SequenceParallelism::set(PARALLEL_MIN_ELEMENTS, PARALLEL_WORKERS);
+    } else {
+        SequenceParallelism::reset();
+    }
+    switch (static_cast<Target>(data[0] % TARGETS)) {
+        case INT_SEQUENCE:
+            return Differential<int>(data + 1, size - 1).run();
+        case HYBRID:
+            return HybridDifferential(data + 1, size - 1).run();
+        case RING:
+            return RingDifferential(data + 1, size - 1).run();
+        default:
+            return Differential<string>(data + 1, size - 1).run();
+    }
+}
+
+} // namespace
+
+#ifdef SEQUENCE_LIBFUZZER
+
+/**
+ * libFuzzer entry point: one input is one run of the decoder.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    runInput(data, size);
+    return 0;
+}
+
+#else
+
+namespace {
+
+/**
+ * Reads a whole file, for replaying a saved input.
+ */
+vector<uint8_t> readFile(const string &path) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        throw runtime_error("Could not open " + path);
+    }
+    return vector<uint8_t>(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+/**
+ * Returns the value of a --name=value argument, or "" if arg is not one.
+ */
+string option(const string &arg, const string &name) {
+    const string prefix = "--" + name + "=";
+    return arg.compare(0, prefix.size(), prefix) == 0 ? arg.substr(prefix.size()) : "";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t target = 2000000;
+    uint64_t seed = static_cast<uint64_t>(chrono::steady_clock::now().time_since_epoch().count());
+    vector<string> files;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (!option(arg, "ops").empty()) {
+            target = stoull(option(arg, "ops"));
+        } else if (!option(arg, "seed").empty()) {
+            seed = stoull(option(arg, "seed"));
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (!files.empty()) {
+        for (const string &path : files) {
+            vector<uint8_t> input = readFile(path);
+            const size_t done = runInput(input.data(), input.size());
+            cout << path << ": passed " << done << " operations" << endl;
+        }
+        return 0;
+    }
+
+    cout << "seed " << seed << endl;
+    mt19937_64 rng(seed);
+    size_t done = 0;
+    size_t inputs = 0;
+    while (done < target) {
+        vector<uint8_t> input(1 + rng() % 32768);
+        for (uint8_t &byte : input) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        done += runInput(input.data(), input.size());
+        inputs++;
+    }
+    cout << "Fuzz test: passed " << done << " operations in " << inputs << " inputs" << endl;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef SEQUENCEHASH_H
+#define SEQUENCEHASH_H
+
+#include <cstddef> // For size_t
+#include <cstdint> // std::uint64_t
+#include <cstring> // std::memcpy
+#include <type_traits> // std::is_trivially_copyable_v
+
+/**
+ * Streaming 64-bit hash with the XXH64 algorithm: four independent lanes
+ * each take 8 bytes of every 32-byte stripe, so the main loop has no
+ * dependency between lanes and runs close to memory bandwidth. Bytes can
+ * be fed in pieces of any size; the result only depends on the
+ * concatenation. On little-endian machines it equals the reference XXH64.
+ *
+ * Used by BasicSequence::hash(). Not a cryptographic hash.
+ */
+class SequenceHasher {
+private:
+    static constexpr std::uint64_t P1 = 0x9E3779B185EBCA87ULL;
+    static constexpr std::uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr std::uint64_t P3 = 0x165667B19E3779F9ULL;
+    static constexpr std::uint64_t P4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr std::uint64_t P5 = 0x27D4EB2F165667C5ULL;
+    static constexpr size_t STRIPE = 32; // bytes consumed by one round of the four lanes
+
+    std::uint64_t lanes[4]; // accumulators
+    std::uint64_t seed; // starting value, kept for short inputs
+    std::uint64_t total = 0; // bytes fed so far
+    unsigned char buffer[STRIPE]; // start of an incomplete stripe
+    size_t buffered = 0; // bytes in buffer
+
+    static std::uint64_t rotl(std::uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+    static std::uint64_t read64(const unsigned char *p) {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static std::uint32_t read32(const unsigned char *p) {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+        return rotl(acc + input * P2, 31) * P1;
+    }
+    static std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t lane) {
+        return (acc ^ round(0, lane)) * P1 + P4;
+    }
+
+    void stripes(const unsigned char *p, size_t n); // Runs the lanes over n / STRIPE whole stripes
+
+public:
+    explicit SequenceHasher(std::uint64_t seed = 0); // Empty input
+    void update(const void *data, size_t n); // Feeds n more bytes.
+    template<class Word>
+    void updateValue(Word value); // Feeds the bytes of one trivially copyable value.
+    std::uint64_t digest() const; // Hash of everything fed so far.
+};
+
+/**
+ * Starts an empty input.
+ *
+ * @param seed Value that selects one of many unrelated hash functions.
+ */
+inline SequenceHasher::SequenceHasher(std::uint64_t seed)
+    : lanes{seed + P1 + P2, seed + P2, seed, seed - P1}, seed(seed) {
+}
+
+/**
+ * Runs the four lanes over every whole stripe in [p, p + n).
+ *
+ * @param p First byte.
+ * @param n Number of bytes, a multiple of STRIPE.
+ */
+inline void SequenceHasher::stripes(const unsigned char *p, size_t n) {
+    std::uint64_t v1 = lanes[0];
+    std::uint64_t v2 = lanes[1];
+    std::uint64_t v3 = lanes[2];
+    std::uint64_t v4 = lanes[3];
+    for (const unsigned char *end = p + n; p != end; p += STRIPE) {
+        v1 = round(v1, read64(p));
+        v2 = round(v2, read64(p + 8));
+        v3 = round(v3, read64(p + 16));
+        v4 = round(v4, read64(p + 24));
+    }
+    lanes[0] = v1;
+    lanes[1] = v2;
+    lanes[2] = v3;
+    lanes[3] = v4;
+}
+
+/**
+ * Feeds n bytes. Whole stripes are hashed straight from data; only the
+ * ragged ends are copied into the buffer.
+ *
+ * @param data First byte.
+ * @param n Number of bytes.
+ */
+inline void SequenceHasher::update(const void *data, size_t n) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    total += n;
+    if (buffered + n < STRIPE) {
+        if (n != 0) {
+            std::memcpy(buffer + buffered, p, n);
+        }
+        buffered += n;
+        return;
+    }
+    if (buffered != 0) {
+        const size_t fill = STRIPE - buffered;
+        std::memcpy(buffer + buffered, p, fill);
+        stripes(buffer, STRIPE);
+        p += fill;
+        n -= fill;
+        buffered = 0;
+    }
+    const size_t whole = n - n % STRIPE;
+    stripes(p, whole);
+    buffered = n - whole;
+    if (buffered != 0) {
+        std::memcpy(buffer, p + whole, buffered);
+    }
+}
+
+/**
+ * Feeds the object representation of one value, such as a length.
+ *
+ * @param value Value whose bytes are fed.
+ */
+template<class Word>
+void SequenceHasher::updateValue(Word value) {
+    static_assert(std::is_trivially_copyable_v<Word>, "only plain values can be fed as bytes");
+    update(&value, sizeof(value));
+}
+
+/**
+ * Folds the lanes, the length and the buffered tail into the hash. The
+ * hasher can keep being fed afterwards.
+ *
+ * @return Hash of the bytes fed so far.
+ */
+inline std::uint64_t SequenceHasher::digest() const {
+    std::uint64_t h;
+    if (total >= STRIPE) {
+        h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+        for (std::uint64_t lane : lanes) {
+            h = mergeRound(h, lane);
+        }
+    } else {
+        h = seed + P5;
+    }
+    h += total;
+
+    const unsigned char *p = buffer;
+    size_t left = buffered;
+    for (; left >= 8; p += 8, left -= 8) {
+        h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+    }
+    if (left >= 4) {
+        h = rotl(h ^ (static_cast<std::uint64_t>(read32(p)) * P1), 23) * P2 + P3;
+        p += 4;
+        left -= 4;
+    }
+    for (; left > 0; p++, left--) {
+        h = rotl(h ^ (*p * P5), 11) * P1;
+    }
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+#endif
@@ -0,0 +1,647 @@
+#ifndef SEQUENCEHYBRID_H
+#define SEQUENCEHYBRID_H
+
+#include <atomic> // read counters
+#include <bit> // std::bit_width
+#include <cstddef> // For size_t
+#include <cstdint> // std::uint64_t
+#include <iterator> // std::make_move_iterator
+#include <memory> // std::allocator_traits
+#include <ostream> // std::ostream
+#include <stdexcept> // exceptions
+#include <utility> // std::move, std::forward
+#include <vector> // contiguous layout
+#include "Sequence.h"
+
+/**
+ * Where a BasicHybridSequence keeps its elements.
+ */
+enum class SequenceLayout {
+    LINKED, // a BasicSequence: O(log n) inserts and erases anywhere
+    CONTIGUOUS // a vector: O(1) indexing, O(n) inserts and erases away from the end
+};
+
+/**
+ * How a BasicHybridSequence picks its layout.
+ */
+enum class SequencePolicy {
+    ADAPTIVE, // follow the observed mix of operations
+    LINKED, // always linked
+    CONTIGUOUS // always contiguous
+};
+
+/**
+ * Layout decisions of a BasicHybridSequence. The window fields describe the
+ * operations counted for the last decision; costs are rough nanoseconds.
+ */
+struct SequenceHybridStats {
+    SequenceLayout layout = SequenceLayout::LINKED; // layout in use
+    SequencePolicy policy = SequencePolicy::ADAPTIVE; // how it was chosen
+    std::uint64_t switches = 0; // conversions between layouts
+    std::uint64_t decisions = 0; // windows evaluated
+    std::uint64_t nearReads = 0; // window: reads next to the previous one, traversal included
+    std::uint64_t farReads = 0; // window: reads anywhere else
+    std::uint64_t endEdits = 0; // window: pushes and pops at the back
+    std::uint64_t middleEdits = 0; // window: inserts and erases anywhere else
+    std::uint64_t shifted = 0; // window: elements a vector moved, or would have moved, for them
+    std::uint64_t linkedCost = 0; // window: estimated cost in the linked layout
+    std::uint64_t contiguousCost = 0; // window: estimated cost in the contiguous layout
+    std::uint64_t conversionCost = 0; // estimated cost of switching at the last decision
+    std::uint64_t pendingSaving = 0; // saving the other layout would have made over the recent windows
+    const char *reason = "initial layout"; // why the layout is the one in use
+};
+
+/**
+ * Writes the layout, the reason for it and the last window's counters.
+ *
+ * @param os Stream to write to.
+ * @param stats Counters to print.
+ * @return os.
+ */
+inline std::ostream &operator<<(std::ostream &os, const SequenceHybridStats &stats) {
+    static const char *const policies[] = {"adaptive", "linked", "contiguous"};
+    os << (stats.layout == SequenceLayout::LINKED ? "linked" : "contiguous") << " ("
+       << policies[static_cast<int>(stats.policy)] << ": " << stats.reason << "), " << stats.switches
+       << " switches in " << stats.decisions << " windows; last window " << stats.nearReads << " near reads, "
+       << stats.farReads << " far reads, " << stats.endEdits << " end edits, " << stats.middleEdits
+       << " middle edits shifting " << stats.shifted << ", cost linked " << stats.linkedCost << " contiguous "
+       << stats.contiguousCost << " switch " << stats.conversionCost << " pending saving " << stats.pendingSaving;
+    return os;
+}
+
+/**
+ * Sequence that keeps its elements either in a BasicSequence or in one
+ * contiguous vector, and moves them to whichever suits the operations it
+ * sees. Inserts and erases away from the back favour the linked layout;
+ * indexing at scattered positions favours the contiguous one, where it is
+ * a single load instead of a descent of the position index.
+ *
+ * Every operation is counted in a window. Once WINDOW operations have been
+ * counted, or inserts and erases shifted enough elements to matter, the
+ * next change to the sequence (push, pop, insert, erase) estimates what
+ * the window cost in each layout from the per-operation costs below,
+ * measured with SequenceBench. The saving the other layout would have made
+ * is summed over consecutive windows, and the elements move once the sum
+ * exceeds the cost of moving every element over; a window that favours the
+ * layout in use resets it, so a mix near the break-even point does not
+ * flip back and forth. The decision is made after the change itself, so
+ * arguments referring to the sequence's own elements stay valid. Reads
+ * never switch: references they returned stay valid until the next
+ * change, as with BasicSequence. optimize() makes the decision on demand.
+ *
+ * The policy can instead pin either layout. stats() reports the layout,
+ * why it was chosen and the counts and estimates behind the last decision.
+ *
+ * Const reads (operator[], front, back, for_each, operator<<) only bump
+ * relaxed atomic counters, so they may run on several threads at once, as
+ * with BasicSequence; readers racing on a counter may lose a count. Changes
+ * must not overlap with reads.
+ *
+ * @tparam T Element type.
+ * @tparam Alloc Allocator of both layouts.
+ */
+template<class T, class Alloc = std::allocator<T>>
+class BasicHybridSequence {
+private:
+    using Vector = std::vector<T, typename std::allocator_traits<Alloc>::template rebind_alloc<T>>;
+
+    // Rough costs per operation in nanoseconds, short strings, SequenceBench
+    static constexpr std::uint64_t WINDOW = 4096; // operations between decisions
+    static constexpr std::uint64_t LINKED_NEAR_READ = 4; // finger hit
+    static constexpr std::uint64_t LINKED_LEVEL = 16; // one level of the position index
+    static constexpr std::uint64_t LINKED_END_EDIT = 10; // push_back/pop_back on the tail block
+    static constexpr std::uint64_t LINKED_MIDDLE_EDIT = 150; // lookup plus a shift inside one block
+    static constexpr std::uint64_t CONTIGUOUS_READ = 2; // one load
+    static constexpr std::uint64_t CONTIGUOUS_END_EDIT = 3; // amortized push_back/pop_back
+    static constexpr std::uint64_t CONTIGUOUS_SHIFT = 3; // per element moved by an insert or erase
+    static constexpr std::uint64_t CONVERT = 25; // per element moved between layouts
+
+    BasicSequence<T, Alloc> linked; // elements, in the linked layout
+    Vector contiguous; // elements, in the contiguous layout
+    SequenceLayout layout = SequenceLayout::LINKED;
+    SequencePolicy policy;
+
+    // Counter that const reads bump, possibly from several threads; copies take its value.
+    // Plain relaxed loads and stores, not read-modify-writes, so a read stays one load dearer:
+    // racing readers may lose a count, which only blurs the estimate.
+    template<class U>
+    struct ReadCounter {
+        mutable std::atomic<U> value{};
+
+        ReadCounter() = default;
+        ReadCounter(const ReadCounter &other) : value(other.load()) {
+        }
+        ReadCounter &operator=(const ReadCounter &other) {
+            value.store(other.load(), std::memory_order_relaxed);
+            return *this;
+        }
+        U load() const {
+            return value.load(std::memory_order_relaxed);
+        }
+        void add(U n) const {
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+        U exchange(U n) const {
+            const U old = value.load(std::memory_order_relaxed);
+            value.store(n, std::memory_order_relaxed);
+            return old;
+        }
+        void reset() {
+            value.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    // Window counters; reads are counted through const access too
+    ReadCounter<std::uint64_t> nearReads;
+    ReadCounter<std::uint64_t> farReads;
+    ReadCounter<size_t> lastRead; // position of the previous read
+    std::uint64_t endEdits = 0;
+    std::uint64_t middleEdits = 0;
+    std::uint64_t shifted = 0;
+    std::uint64_t pending = 0; // saving the other layout would have made, over the windows since one favoured this
+    SequenceHybridStats decided; // results of the last decision
+
+    std::uint64_t operations() const; // Operations counted in the window
+    void read(size_t position) const; // Counts a read at position
+    void edit(size_t position); // Counts an insert or erase at position, before it is made
+    void maybeSwitch(); // Decides once a window is full; called after each change
+    void decide(); // Estimates the window in both layouts and switches if worth it
+    void convert(SequenceLayout to); // Moves every element to the other layout
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+
+    explicit BasicHybridSequence(SequencePolicy policy = SequencePolicy::ADAPTIVE,
+                                 const Alloc &alloc = Alloc()); // Empty sequence
+
+    T &operator[](size_t position); // Returns a reference to the element at the specified index.
+    const T &operator[](size_t position) const; // Read-only access at the specified index.
+    T &front(); // Returns the first element in the sequence.
+    const T &front() const;
+    T &back(); // Returns the last element in the sequence.
+    const T &back() const;
+
+    void push_back(T element); // Adds an element to the end of the sequence.
+    template<class... Args>
+    T &emplace_back(Args &&... args); // Constructs an element in place at the end.
+    void pop_back(); // Removes the last element of the sequence.
+    void insert(size_t position, T element); // Inserts an element at the given position.
+    void erase(size_t position); // Removes an element at the specified position.
+    void clear(); // Clears all elements from the sequence.
+
+    template<class Fn>
+    void for_each(Fn fn) const; // Calls fn on every element in order.
+    size_t size() const; // Returns the number of elements in the sequence.
+    bool empty() const; // Checks if the sequence in empty.
+
+    SequenceLayout representation() const; // Layout in use.
+    void setPolicy(SequencePolicy policy); // Pins a layout, or goes back to adapting.
+    void optimize(); // Decides the layout now from the operations counted so far.
+    SequenceHybridStats stats() const; // Layout, the reason for it and the counters behind it.
+};
+
+/**
+ * The string version, matching Sequence.
+ */
+using HybridSequence = BasicHybridSequence<std::string>;
+
+/**
+ * Creates an empty sequence, linked unless the policy pins the contiguous
+ * layout.
+ *
+ * @param policy How the layout is chosen.
+ * @param alloc Allocator for both layouts.
+ */
+template<class T, class Alloc>
+BasicHybridSequence<T, Alloc>::BasicHybridSequence(SequencePolicy policy, const Alloc &alloc)
+    : linked(0, alloc), contiguous(alloc), policy(policy) {
+    if (policy == SequencePolicy::CONTIGUOUS) {
+        layout = SequenceLayout::CONTIGUOUS;
+    }
+    decided.layout = layout;
+    decided.policy = policy;
+    decided.reason = policy == SequencePolicy::ADAPTIVE ? "initial layout" : "pinned by the policy";
+}
+
+/**
+ * Returns how many operations the window has counted so far.
+ *
+ * @return Reads plus edits since the last decision.
+ */
+template<class T, class Alloc>
+std::uint64_t BasicHybridSequence<T, Alloc>::operations() const {
+    return nearReads.load() + farReads.load() + endEdits + middleEdits;
+}
+
+/**
+ * Counts a read: near if it is at or next to the previous one, as in a
+ * scan, far otherwise. Readers on other threads may count at the same
+ * time; each compares against whichever read it saw counted last.
+ *
+ * @param position Index read.
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::read(size_t position) const {
+    const size_t last = lastRead.exchange(position);
+    if (position + 1 >= last && position <= last + 1) {
+        nearReads.add(1);
+    } else {
+        farReads.add(1);
+    }
+}
+
+/**
+ * Counts an insert or erase, with the elements after it that a vector
+ * shifts. The caller makes the change and then calls maybeSwitch().
+ *
+ * @param position Index inserted at or erased, checked by the caller.
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::edit(size_t position) {
+    const size_t after = size() - position;
+    if (after <= 1) {
+        endEdits++;
+    } else {
+        middleEdits++;
+        shifted += after;
+    }
+}
+
+/**
+ * Decides the layout once a full window has been counted, or as soon as
+ * the elements shifted by inserts and erases would have paid for two
+ * conversions: a few middle inserts into a large vector already cost more
+ * than a window of anything else. Nothing is decided when a policy pins
+ * the layout.
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::maybeSwitch() {
+    if (policy != SequencePolicy::ADAPTIVE) {
+        return;
+    }
+    const bool shiftedEnough = layout == SequenceLayout::CONTIGUOUS && shifted != 0
+                               && shifted * CONTIGUOUS_SHIFT >= 2 * size() * CONVERT;
+    if (operations() >= WINDOW || shiftedEnough) {
+        decide();
+    }
+}
+
+/**
+ * Estimates what the counted operations cost in each layout. When the
+ * other layout would have been cheaper, the difference is added to the
+ * saving owed by the layout in use; when the layout in use was cheaper,
+ * that saving is forgotten. Once it exceeds the cost of converting, the
+ * elements move. A far read in the linked layout is charged one index
+ * level per doubling of the number of blocks. Starts a new window.
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::decide() {
+    const size_t n = size();
+    const std::uint64_t near = nearReads.load();
+    const std::uint64_t far = farReads.load();
+    const std::uint64_t levels = std::bit_width(n / SequenceNode<T>::CAPACITY + 1);
+    const std::uint64_t linkedCost = near * LINKED_NEAR_READ + far * (LINKED_NEAR_READ + levels * LINKED_LEVEL)
+                                     + endEdits * LINKED_END_EDIT + middleEdits * LINKED_MIDDLE_EDIT;
+    const std::uint64_t contiguousCost = (near + far) * CONTIGUOUS_READ
+                                         + (endEdits + middleEdits) * CONTIGUOUS_END_EDIT + shifted * CONTIGUOUS_SHIFT;
+    const std::uint64_t conversionCost = n * CONVERT;
+    const std::uint64_t inUse = layout == SequenceLayout::LINKED ? linkedCost : contiguousCost;
+    const std::uint64_t other = layout == SequenceLayout::LINKED ? contiguousCost : linkedCost;
+    pending = other < inUse ? pending + (inUse - other) : 0;
+
+    decided.decisions++;
+    decided.nearReads = near;
+    decided.farReads = far;
+    decided.endEdits = endEdits;
+    decided.middleEdits = middleEdits;
+    decided.shifted = shifted;
+    decided.linkedCost = linkedCost;
+    decided.contiguousCost = contiguousCost;
+    decided.conversionCost = conversionCost;
+    decided.pendingSaving = pending;
+    nearReads.reset();
+    farReads.reset();
+    endEdits = middleEdits = shifted = 0;
+
+    if (pending == 0) {
+        decided.reason = "the layout in use is the cheaper one";
+    } else if (pending <= conversionCost) {
+        decided.reason = "the saving so far does not cover a switch";
+    } else if (layout == SequenceLayout::LINKED) {
+        convert(SequenceLayout::CONTIGUOUS);
+        decided.reason = "reads cost less contiguous";
+    } else {
+        convert(SequenceLayout::LINKED);
+        decided.reason = "middle inserts and erases cost less linked";
+    }
+}
+
+/**
+ * Moves every element into the other layout and frees the old one.
+ *
+ * @param to Layout to move to.
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::convert(SequenceLayout to) {
+    if (to == layout) {
+        return;
+    }
+    if (to == SequenceLayout::CONTIGUOUS) {
+        Vector items(contiguous.get_allocator());
+        items.reserve(linked.size());
+        for (T &item : linked) {
+            items.push_back(std::move(item));
+        }
+        contiguous = std::move(items);
+        linked.clear();
+    } else {
+        linked.append(std::make_move_iterator(contiguous.begin()), std::make_move_iterator(contiguous.end()));
+        Vector(contiguous.get_allocator()).swap(contiguous); // give the buffer back, not just the elements
+    }
+    layout = to;
+    pending = 0;
+    decided.layout = to;
+    decided.switches++;
+}
+
+/**
+ * Returns a reference to the element at position.
+ *
+ * @param position Index of the element.
+ * @return Reference to the element.
+ * @throws std::out_of_range if position >= size()
+ */
+template<class T, class Alloc>
+T &BasicHybridSequence<T, Alloc>::operator[](size_t position) {
+    if (position >= size()) {
+        throw std::out_of_range("Index is out of range");
+    }
+    read(position);
+    return layout == SequenceLayout::LINKED ? linked[position] : contiguous[position];
+}
+
+template<class T, class Alloc>
+const T &BasicHybridSequence<T, Alloc>::operator[](size_t position) const {
+    if (position >= size()) {
+        throw std::out_of_range("Index is out of range");
+    }
+    read(position);
+    return layout == SequenceLayout::LINKED ? std::as_const(linked)[position] : contiguous[position];
+}
+
+/**
+ * Returns the first element.
+ *
+ * @return Reference to the first element.
+ * @throws std::out_of_range if the sequence is empty.
+ */
+template<class T, class Alloc>
+T &BasicHybridSequence<T, Alloc>::front() {
+    if (empty()) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    return layout == SequenceLayout::LINKED ? linked.front() : contiguous.front();
+}
+
+template<class T, class Alloc>
+const T &BasicHybridSequence<T, Alloc>::front() const {
+    if (empty()) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    return layout == SequenceLayout::LINKED ? linked.front() : contiguous.front();
+}
+
+/**
+ * Returns the last element.
+ *
+ * @return Reference to the last element.
+ * @throws std::out_of_range if the sequence is empty.
+ */
+template<class T, class Alloc>
+T &BasicHybridSequence<T, Alloc>::back() {
+    if (empty()) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    return layout == SequenceLayout::LINKED ? linked.back() : contiguous.back();
+}
+
+template<class T, class Alloc>
+const T &BasicHybridSequence<T, Alloc>::back() const {
+    if (empty()) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    return layout == SequenceLayout::LINKED ? linked.back() : contiguous.back();
+}
+
+/**
+ * Adds an element to the end.
+ *
+ * @param item The element to append.
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::push_back(T item) {
+    emplace_back(std::move(item));
+}
+
+/**
+ * Constructs an element at the end.
+ *
+ * @param args Arguments forwarded to the constructor of T.
+ * @return Reference to the new element.
+ */
+template<class T, class Alloc>
+template<class... Args>
+T &BasicHybridSequence<T, Alloc>::emplace_back(Args &&... args) {
+    edit(size());
+    if (layout == SequenceLayout::LINKED) {
+        linked.emplace_back(std::forward<Args>(args)...);
+    } else {
+        contiguous.emplace_back(std::forward<Args>(args)...);
+    }
+    maybeSwitch(); // args may refer to an element, so only switch once they are used
+    return layout == SequenceLayout::LINKED ? linked.back() : contiguous.back();
+}
+
+/**
+ * Removes the last element.
+ *
+ * @throws std::out_of_range if the sequence is empty.
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::pop_back() {
+    if (empty()) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    edit(size() - 1);
+    if (layout == SequenceLayout::LINKED) {
+        linked.pop_back();
+    } else {
+        contiguous.pop_back();
+    }
+    maybeSwitch();
+}
+
+/**
+ * Inserts an element before position.
+ *
+ * @param position Index the new element will have.
+ * @param item The element to insert.
+ * @throws std::out_of_range if position > size()
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::insert(size_t position, T item) {
+    if (position > size()) {
+        throw std::out_of_range("Position is out of range");
+    }
+    edit(position);
+    if (layout == SequenceLayout::LINKED) {
+        linked.insert(position, std::move(item));
+    } else {
+        contiguous.insert(contiguous.begin() + static_cast<std::ptrdiff_t>(position), std::move(item));
+    }
+    maybeSwitch();
+}
+
+/**
+ * Removes the element at position.
+ *
+ * @param position Index of the element to remove.
+ * @throws std::out_of_range if position >= size()
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::erase(size_t position) {
+    if (position >= size()) {
+        throw std::out_of_range("Position is out of range");
+    }
+    edit(position);
+    if (layout == SequenceLayout::LINKED) {
+        linked.erase(position);
+    } else {
+        contiguous.erase(contiguous.begin() + static_cast<std::ptrdiff_t>(position));
+    }
+    maybeSwitch();
+}
+
+/**
+ * Removes every element. The layout and the counters stay.
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::clear() {
+    linked.clear();
+    contiguous.clear();
+}
+
+/**
+ * Calls fn on every element in order; counted as one near read each.
+ *
+ * @param fn Called as fn(const T &).
+ */
+template<class T, class Alloc>
+template<class Fn>
+void BasicHybridSequence<T, Alloc>::for_each(Fn fn) const {
+    nearReads.add(size());
+    if (layout == SequenceLayout::LINKED) {
+        for (const T &item : linked) {
+            fn(item);
+        }
+    } else {
+        for (const T &item : contiguous) {
+            fn(item);
+        }
+    }
+}
+
+/**
+ * Returns the number of elements.
+ *
+ * @return Number of elements.
+ */
+template<class T, class Alloc>
+size_t BasicHybridSequence<T, Alloc>::size() const {
+    return layout == SequenceLayout::LINKED ? linked.size() : contiguous.size();
+}
+
+/**
+ * Checks if the sequence has no elements.
+ *
+ * @return true if it is empty.
+ */
+template<class T, class Alloc>
+bool BasicHybridSequence<T, Alloc>::empty() const {
+    return size() == 0;
+}
+
+/**
+ * Returns the layout the elements are in.
+ *
+ * @return LINKED or CONTIGUOUS.
+ */
+template<class T, class Alloc>
+SequenceLayout BasicHybridSequence<T, Alloc>::representation() const {
+    return layout;
+}
+
+/**
+ * Pins a layout, moving the elements there now, or goes back to choosing
+ * one from the operations counted from here on.
+ *
+ * @param newPolicy How the layout is chosen from now on.
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::setPolicy(SequencePolicy newPolicy) {
+    policy = newPolicy;
+    decided.policy = newPolicy;
+    nearReads.reset();
+    farReads.reset();
+    endEdits = middleEdits = shifted = pending = 0;
+    if (newPolicy == SequencePolicy::ADAPTIVE) {
+        decided.reason = "adapting from here on";
+        return;
+    }
+    convert(newPolicy == SequencePolicy::LINKED ? SequenceLayout::LINKED : SequenceLayout::CONTIGUOUS);
+    decided.reason = "pinned by the policy";
+}
+
+/**
+ * Decides the layout now from whatever was counted since the last
+ * decision, without waiting for a full window. Does nothing when the
+ * policy pins the layout.
+ */
+template<class T, class Alloc>
+void BasicHybridSequence<T, Alloc>::optimize() {
+    if (policy == SequencePolicy::ADAPTIVE) {
+        decide();
+    }
+}
+
+/**
+ * Returns the layout in use, why, and the counts and estimates of the
+ * last decision.
+ *
+ * @return Copy of the decision record.
+ */
+template<class T, class Alloc>
+SequenceHybridStats BasicHybridSequence<T, Alloc>::stats() const {
+    return decided;
+}
+
+/**
+ * Outputs the elements in the same "<a, b, c>" format as a sequence.
+ *
+ * @param os The output stream.
+ * @param s The sequence to print.
+ * @return Output stream object.
+ */
+template<class T, class Alloc>
+std::ostream &operator<<(std::ostream &os, const BasicHybridSequence<T, Alloc> &s) {
+    os << "<";
+    bool first = true;
+    s.for_each([&](const T &item) {
+        os << (first ? "" : ", ") << item;
+        first = false;
+    });
+    return os << ">";
+}
+
+#endif
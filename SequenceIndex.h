@@ -0,0 +1,534 @@
+#ifndef SEQUENCEINDEX_H
+#define SEQUENCEINDEX_H
+
+#include <cstddef> // For size_t
+#include <functional> // std::hash
+#include <concepts> // std::convertible_to
+#include <unordered_map> // value -> entry
+#include <vector> // blocks of one value
+#include <algorithm> // std::partition_point, std::find_if
+#include <atomic> // std::atomic
+#include <mutex> // std::mutex, std::lock_guard
+
+/**
+ * Element types the hash index supports: hashable with std::hash and
+ * comparable with ==.
+ */
+template<class T>
+concept SequenceHashable = requires(const T &a, const T &b) {
+    { std::hash<T>()(a) } -> std::convertible_to<size_t>;
+    { a == b } -> std::convertible_to<bool>;
+};
+
+template<class T>
+class SequenceNode;
+
+/**
+ * Secondary index of a BasicSequence from each distinct value to how often
+ * it occurs and where. The sequence reports its changes through the hooks
+ * below, and the index stays exact through all of them except splice,
+ * unique and non-const iterators, which mark it stale; the next query then
+ * rebuilds it with one pass.
+ *
+ * Where a value occurs is kept as the block of each occurrence, in list
+ * order, not as positions: an insert or erase shifts the positions of
+ * every later element but leaves them in their blocks, so it only updates
+ * the list of the value it adds or removes, and a block split or merge
+ * renames the blocks of the elements it moves. A query turns blocks into
+ * positions with the index walk BasicSequence::indexOf does, O(log n), and
+ * a scan of the block: find() is O(log k log n + CAPACITY) for a value
+ * with k occurrences, positions() O(k log n + k CAPACITY) at worst.
+ *
+ * A reference from non-const element access may be written through
+ * behind the index's back, so handedOut() remembers the element and its
+ * value, and the next change or query settles the difference. Past a
+ * handful of such elements the index gives up and marks itself stale.
+ *
+ * refresh() settles and rebuilds under a lock, so several readers of one
+ * const sequence may query the index at once.
+ *
+ * The specialization for types without std::hash is empty, so the hooks
+ * compile to nothing for them.
+ *
+ * @tparam T Element type.
+ */
+template<class T, bool = SequenceHashable<T>>
+class SequenceIndex {
+public:
+    using Node = SequenceNode<T>;
+
+    void pushed(const T &, const Node *) {
+    }
+    void popped(const T &) {
+    }
+    void inserted(const T &, const Node *) {
+    }
+    void erased(const T &, const Node *) {
+    }
+    void moved(const T &, const Node *, const Node *) {
+    }
+    void replaced(const T &, const T &, const Node *) {
+    }
+    void handedOut(const Node *, size_t) {
+    }
+    void settle() {
+    }
+    void reordered() {
+    }
+    void invalidate() {
+    }
+    void clear() {
+    }
+    void refresh(const Node *, bool) {
+    }
+};
+
+template<class T>
+class SequenceIndex<T, true> {
+public:
+    using Node = SequenceNode<T>;
+
+private:
+    static constexpr size_t MAX_WRITES = 16; // handed-out elements tracked before the index gives up
+
+    struct Entry {
+        size_t count = 0; // occurrences of the value
+        std::vector<const Node *> blocks; // block of each occurrence, in list order; valid while positionsValid
+    };
+
+    struct Write {
+        const Node *block; // block of an element handed out for writing
+        size_t offset; // its slot in the block
+        T old; // its value when handed out
+    };
+
+    std::unordered_map<T, Entry> entries; // one entry per value present
+    std::vector<Write> writes; // elements handed out since the last settle()
+    std::atomic<bool> countsValid = true; // counts match the sequence
+    std::atomic<bool> positionsValid = true; // block lists match the sequence
+    std::atomic<bool> settled = true; // writes is empty
+    std::mutex rebuilding; // Held by the reader that rebuilds a stale index
+
+    void remove(const T &value); // Drops one occurrence from the counts
+    static size_t startOf(const Node *block); // Index of a block's first element
+    static typename std::vector<const Node *>::iterator
+    firstIn(std::vector<const Node *> &blocks, const Node *block); // First occurrence in block, or where it goes
+
+public:
+    // Hooks called by the sequence after each change
+    void pushed(const T &value, const Node *block); // value was appended in block, the tail
+    void popped(const T &value); // the last element, value, was removed
+    void inserted(const T &value, const Node *block); // value was inserted before the end, into block
+    void erased(const T &value, const Node *block); // value is about to be removed from block
+    void moved(const T &value, const Node *from, const Node *to); // value moved to a neighbouring block
+    void replaced(const T &old, const T &now, const Node *block); // an element of block changed value
+    void handedOut(const Node *block, size_t offset); // an element may be written through a reference
+    void settle(); // Accounts for writes to the elements handed out
+    void reordered(); // the elements were permuted
+    void invalidate(); // elements changed in ways not reported
+    void clear(); // the sequence was emptied
+
+    bool current(bool withPositions) const; // Whether queries can be answered as is
+    void rebuild(const Node *head); // Recomputes everything from the elements
+    void refresh(const Node *head, bool withPositions); // Rebuilds once if stale, safe from several readers
+
+    size_t count(const T &value) const; // Occurrences of value
+    size_t find(const T &value, size_t from) const; // First position >= from, or size_t(-1)
+    std::vector<size_t> positions(const T &value) const; // Every position of value
+};
+
+/**
+ * Returns the index of a block's first element by walking up the position
+ * index, the way BasicSequence::indexOf does. O(log n) expected.
+ *
+ * @param block Block linked into the sequence.
+ * @return Index of the block's first element.
+ */
+template<class T>
+size_t SequenceIndex<T, true>::startOf(const Node *block) {
+    size_t index = block->leftWeight;
+    for (const Node *child = block, *above = block->parent; above != nullptr;
+         child = above, above = above->parent) {
+        if (above->right == child) {
+            index += above->leftWeight + above->count;
+        }
+    }
+    return index;
+}
+
+/**
+ * Finds the first occurrence listed for block by binary search on the
+ * blocks' positions, or the place an occurrence in block would go.
+ *
+ * @param blocks Block list of one value, in list order.
+ * @param block Block linked into the sequence.
+ * @return Iterator into blocks.
+ */
+template<class T>
+typename std::vector<const SequenceNode<T> *>::iterator
+SequenceIndex<T, true>::firstIn(std::vector<const Node *> &blocks, const Node *block) {
+    const size_t start = startOf(block);
+    return std::partition_point(blocks.begin(), blocks.end(),
+                                [start](const Node *other) { return startOf(other) < start; });
+}
+
+/**
+ * Records an element appended at the end.
+ *
+ * @param value The new element.
+ * @param block The tail block holding it.
+ */
+template<class T>
+void SequenceIndex<T, true>::pushed(const T &value, const Node *block) {
+    if (!countsValid.load(std::memory_order_relaxed)) {
+        return;
+    }
+    Entry &entry = entries[value];
+    entry.count++;
+    if (positionsValid.load(std::memory_order_relaxed)) {
+        entry.blocks.push_back(block); // the last block yet
+    }
+}
+
+/**
+ * Records the removal of the last element.
+ *
+ * @param value The element being removed.
+ */
+template<class T>
+void SequenceIndex<T, true>::popped(const T &value) {
+    if (!countsValid.load(std::memory_order_relaxed)) {
+        return;
+    }
+    auto found = entries.find(value);
+    if (positionsValid.load(std::memory_order_relaxed) && found != entries.end()
+        && !found->second.blocks.empty()) {
+        found->second.blocks.pop_back(); // it was the last occurrence
+    }
+    remove(value);
+}
+
+/**
+ * Records an element inserted before the end. Only value's block list
+ * changes: the other elements keep their blocks, whatever their positions.
+ *
+ * @param value The new element.
+ * @param block Block it was inserted into, with its count updated.
+ */
+template<class T>
+void SequenceIndex<T, true>::inserted(const T &value, const Node *block) {
+    if (!countsValid.load(std::memory_order_relaxed)) {
+        return;
+    }
+    Entry &entry = entries[value];
+    entry.count++;
+    if (positionsValid.load(std::memory_order_relaxed)) {
+        entry.blocks.insert(firstIn(entry.blocks, block), block);
+    }
+}
+
+/**
+ * Records the removal of an element before the end. Called while the
+ * element is still in its block.
+ *
+ * @param value The element being removed.
+ * @param block Block it is removed from.
+ */
+template<class T>
+void SequenceIndex<T, true>::erased(const T &value, const Node *block) {
+    if (!countsValid.load(std::memory_order_relaxed)) {
+        return;
+    }
+    auto found = entries.find(value);
+    if (found == entries.end()) {
+        return;
+    }
+    if (positionsValid.load(std::memory_order_relaxed)) {
+        std::vector<const Node *> &blocks = found->second.blocks;
+        auto at = firstIn(blocks, block);
+        if (at != blocks.end() && *at == block) {
+            blocks.erase(at);
+        }
+    }
+    remove(value);
+}
+
+/**
+ * Records an element moved into a neighbouring block, as a split or merge
+ * does. Both blocks must be linked in with their counts current. A move
+ * into the next block renames the last occurrence listed for from, a move
+ * into the previous one the first, so the list stays in order.
+ *
+ * @param value The element moved.
+ * @param from Block it left.
+ * @param to Block right before or after from.
+ */
+template<class T>
+void SequenceIndex<T, true>::moved(const T &value, const Node *from, const Node *to) {
+    if (!countsValid.load(std::memory_order_relaxed) || !positionsValid.load(std::memory_order_relaxed)) {
+        return;
+    }
+    auto found = entries.find(value);
+    if (found == entries.end()) {
+        return;
+    }
+    std::vector<const Node *> &blocks = found->second.blocks;
+    auto at = firstIn(blocks, from);
+    if (from->next == to) {
+        at = std::partition_point(at, blocks.end(), [from](const Node *block) { return block == from; }) - 1;
+    }
+    *at = to;
+}
+
+/**
+ * Records an element of block that changed from old to now in place.
+ *
+ * @param old Value before the change.
+ * @param now Value after it.
+ * @param block Block holding the element.
+ */
+template<class T>
+void SequenceIndex<T, true>::replaced(const T &old, const T &now, const Node *block) {
+    erased(old, block);
+    inserted(now, block);
+}
+
+/**
+ * Remembers an element handed out through a non-const reference, with its
+ * current value, so settle() can tell whether it was written to. Past
+ * MAX_WRITES of them the index marks itself stale instead.
+ *
+ * @param block Block holding the element.
+ * @param offset Its slot in the block.
+ */
+template<class T>
+void SequenceIndex<T, true>::handedOut(const Node *block, size_t offset) {
+    if (!countsValid.load(std::memory_order_relaxed)) {
+        return; // the rebuild reads whatever is written
+    }
+    for (const Write &write : writes) {
+        if (write.block == block && write.offset == offset) {
+            return; // the first value handed out is the one the index holds
+        }
+    }
+    if (writes.size() == MAX_WRITES) {
+        invalidate();
+        return;
+    }
+    writes.push_back(Write{block, offset, block->elements()[offset]});
+    settled.store(false, std::memory_order_relaxed);
+}
+
+/**
+ * Compares each element handed out since the last call with the value it
+ * had then and records the ones that changed. The sequence calls this
+ * before its next change, while the blocks are still as they were.
+ */
+template<class T>
+void SequenceIndex<T, true>::settle() {
+    if (settled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    for (const Write &write : writes) {
+        const T &now = write.block->elements()[write.offset];
+        if (!(now == write.old)) {
+            replaced(write.old, now, write.block);
+        }
+    }
+    writes.clear();
+    settled.store(true, std::memory_order_release);
+}
+
+/**
+ * Records a permutation of the elements (sort, reverse) or a change of
+ * block headers: the counts stay, the block lists are dropped.
+ */
+template<class T>
+void SequenceIndex<T, true>::reordered() {
+    positionsValid.store(false, std::memory_order_relaxed);
+}
+
+/**
+ * Drops one occurrence of value, and its entry with the last one.
+ *
+ * @param value Value to drop.
+ */
+template<class T>
+void SequenceIndex<T, true>::remove(const T &value) {
+    auto found = entries.find(value);
+    if (found != entries.end() && --found->second.count == 0) {
+        entries.erase(found);
+    }
+}
+
+/**
+ * Marks everything stale after a change the hooks do not describe, such as
+ * writes through a non-const reference.
+ */
+template<class T>
+void SequenceIndex<T, true>::invalidate() {
+    countsValid.store(false, std::memory_order_relaxed);
+    positionsValid.store(false, std::memory_order_relaxed);
+    writes.clear();
+    settled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * Empties the index to match an emptied sequence.
+ */
+template<class T>
+void SequenceIndex<T, true>::clear() {
+    entries.clear();
+    writes.clear();
+    settled.store(true, std::memory_order_relaxed);
+    countsValid.store(true, std::memory_order_relaxed);
+    positionsValid.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * Checks whether the index can answer queries without a rebuild.
+ *
+ * @param withPositions Whether the query needs the position lists.
+ * @return true if the needed parts are up to date.
+ */
+template<class T>
+bool SequenceIndex<T, true>::current(bool withPositions) const {
+    return settled.load(std::memory_order_acquire) && countsValid.load(std::memory_order_acquire)
+           && (!withPositions || positionsValid.load(std::memory_order_acquire));
+}
+
+/**
+ * Recomputes counts and block lists with one pass over the elements. When
+ * only the block lists are stale the entries stay where they are and just
+ * their lists are refilled, so readers that only need the counts can keep
+ * reading them meanwhile.
+ *
+ * @param head First block of the sequence.
+ */
+template<class T>
+void SequenceIndex<T, true>::rebuild(const Node *head) {
+    if (countsValid.load(std::memory_order_relaxed)) {
+        for (auto &[value, entry] : entries) {
+            entry.blocks.clear();
+        }
+        for (const Node *block = head; block != nullptr; block = block->next) {
+            for (size_t i = 0; i < block->count; i++) {
+                entries.find(block->elements()[i])->second.blocks.push_back(block);
+            }
+        }
+        positionsValid.store(true, std::memory_order_release);
+        return;
+    }
+
+    entries.clear();
+    for (const Node *block = head; block != nullptr; block = block->next) {
+        for (size_t i = 0; i < block->count; i++) {
+            Entry &entry = entries[block->elements()[i]];
+            entry.count++;
+            entry.blocks.push_back(block);
+        }
+    }
+    countsValid.store(true, std::memory_order_release);
+    positionsValid.store(true, std::memory_order_release);
+}
+
+/**
+ * Settles writes and rebuilds the index if the parts a query needs are
+ * stale. Readers of a const sequence may call this side by side: the
+ * first to find the index stale brings it up to date under the lock, the
+ * others wait for it and then read what it built. Edits must not run at
+ * the same time.
+ *
+ * @param head First block of the sequence.
+ * @param withPositions Whether the query needs the block lists.
+ */
+template<class T>
+void SequenceIndex<T, true>::refresh(const Node *head, bool withPositions) {
+    if (current(withPositions)) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(rebuilding);
+    settle();
+    if (!current(withPositions)) { // another reader may have rebuilt it meanwhile
+        rebuild(head);
+    }
+}
+
+/**
+ * Returns how often value occurs. The counts must be current.
+ *
+ * @param value Value to look up.
+ * @return Number of occurrences.
+ */
+template<class T>
+size_t SequenceIndex<T, true>::count(const T &value) const {
+    auto found = entries.find(value);
+    return found == entries.end() ? 0 : found->second.count;
+}
+
+/**
+ * Returns the first position of value at or after from: a binary search
+ * for the first listed block that reaches past from, then a scan of the
+ * blocks from there. The block lists must be current.
+ *
+ * @param value Value to look up.
+ * @param from First position to consider.
+ * @return The position, or size_t(-1) if there is none.
+ */
+template<class T>
+size_t SequenceIndex<T, true>::find(const T &value, size_t from) const {
+    auto found = entries.find(value);
+    if (found == entries.end()) {
+        return static_cast<size_t>(-1);
+    }
+    const std::vector<const Node *> &blocks = found->second.blocks;
+    auto at = std::partition_point(blocks.begin(), blocks.end(), [from](const Node *block) {
+        return startOf(block) + block->count <= from;
+    });
+    while (at != blocks.end()) {
+        const Node *block = *at;
+        const size_t start = startOf(block);
+        const T *items = block->elements();
+        for (size_t i = from > start ? from - start : 0; i < block->count; i++) {
+            if (items[i] == value) {
+                return start + i;
+            }
+        }
+        at = std::find_if(at, blocks.end(), [block](const Node *other) { return other != block; });
+    }
+    return static_cast<size_t>(-1);
+}
+
+/**
+ * Returns every position of value in ascending order, locating each listed
+ * block once and scanning it. The block lists must be current.
+ *
+ * @param value Value to look up.
+ * @return The positions; empty if value does not occur.
+ */
+template<class T>
+std::vector<size_t> SequenceIndex<T, true>::positions(const T &value) const {
+    std::vector<size_t> result;
+    auto found = entries.find(value);
+    if (found == entries.end()) {
+        return result;
+    }
+    result.reserve(found->second.count);
+    const Node *last = nullptr;
+    for (const Node *block : found->second.blocks) {
+        if (block == last) {
+            continue;
+        }
+        last = block;
+        const size_t start = startOf(block);
+        const T *items = block->elements();
+        for (size_t i = 0; i < block->count; i++) {
+            if (items[i] == value) {
+                result.push_back(start + i);
+            }
+        }
+    }
+    return result;
+}
+
+#endif
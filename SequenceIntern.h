@@ -0,0 +1,133 @@
+#ifndef SEQUENCEINTERN_H
+#define SEQUENCEINTERN_H
+
+#include <cstddef> // For size_t
+#include <functional> // std::hash
+#include <mutex> // std::mutex, std::scoped_lock
+#include <ostream> // std::ostream
+#include <string> // pooled text
+#include <string_view> // lookups without a temporary string
+#include <unordered_set> // the pool
+
+/**
+ * Owns one copy of every distinct string interned through it. Entries are
+ * never removed, so the pool must outlive every InternedString made from
+ * it; it is meant for vocabularies of repeated tokens (tags, names, keys)
+ * that many elements share. Interning is thread-safe.
+ */
+class SequenceStringPool {
+private:
+    // Hashes std::string and std::string_view alike, for lookups without a copy
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const {
+            return std::hash<std::string_view>()(text);
+        }
+    };
+
+    std::unordered_set<std::string, Hash, std::equal_to<>> strings; // node based: entries never move
+    mutable std::mutex lock; // guards strings
+
+public:
+    SequenceStringPool() = default;
+    SequenceStringPool(const SequenceStringPool &) = delete; // handles point into this pool
+    SequenceStringPool &operator=(const SequenceStringPool &) = delete;
+
+    const std::string *intern(std::string_view text); // The pooled copy of text, added if new
+    size_t size() const; // Number of distinct strings
+    size_t bytes() const; // Approximate memory held by the pool
+};
+
+/**
+ * A string stored as a pointer to its copy in a SequenceStringPool: 8 bytes
+ * per element instead of 32 for std::string, and long repeated values are
+ * stored once. BasicSequence<InternedString> also packs four times as many
+ * elements into each block. Each distinct value costs a pool entry, so
+ * this only pays off when values repeat. The text is immutable; assign a
+ * new InternedString to change an element.
+ */
+class InternedString {
+private:
+    const std::string *text; // never null
+
+    static const std::string &emptyText() {
+        static const std::string empty;
+        return empty;
+    } // shared by every default-constructed handle
+
+public:
+    InternedString() : text(&emptyText()) {
+    } // the empty string, without a pool
+    InternedString(SequenceStringPool &pool, std::string_view value) : text(pool.intern(value)) {
+    } // interns value in pool
+
+    const char *data() const {
+        return text->data();
+    }
+    size_t size() const {
+        return text->size();
+    }
+    bool empty() const {
+        return text->empty();
+    }
+    const std::string &str() const {
+        return *text;
+    } // the pooled string
+    operator std::string_view() const {
+        return *text;
+    }
+
+    friend bool operator==(InternedString a, InternedString b) {
+        return a.text == b.text || *a.text == *b.text; // equal text from different pools still compares equal
+    }
+    friend std::ostream &operator<<(std::ostream &os, InternedString s) {
+        return os << *s.text;
+    }
+};
+
+/**
+ * Returns the pooled copy of text, adding it on first use.
+ *
+ * @param text String to intern.
+ * @return Pointer that stays valid for the life of the pool.
+ */
+inline const std::string *SequenceStringPool::intern(std::string_view text) {
+    std::scoped_lock guard(lock);
+    auto found = strings.find(text);
+    if (found == strings.end()) {
+        found = strings.emplace(text).first;
+    }
+    return &*found;
+}
+
+/**
+ * Returns the number of distinct strings in the pool.
+ *
+ * @return Number of entries.
+ */
+inline size_t SequenceStringPool::size() const {
+    std::scoped_lock guard(lock);
+    return strings.size();
+}
+
+/**
+ * Estimates the memory the pool holds: the bucket array, one hash node per
+ * entry (next pointer, cached hash and the string) and the heap buffer of
+ * every string too long for its inline buffer.
+ *
+ * @return Approximate bytes.
+ */
+inline size_t SequenceStringPool::bytes() const {
+    std::scoped_lock guard(lock);
+    size_t total = strings.bucket_count() * sizeof(void *);
+    for (const std::string &entry : strings) {
+        total += 2 * sizeof(void *) + sizeof(std::string);
+        const char *inside = reinterpret_cast<const char *>(&entry);
+        if (entry.data() < inside || entry.data() >= inside + sizeof(std::string)) {
+            total += entry.capacity() + 1;
+        }
+    }
+    return total;
+}
+
+#endif
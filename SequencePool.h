@@ -0,0 +1,382 @@
+#ifndef SEQUENCEPOOL_H
+#define SEQUENCEPOOL_H
+
+#include <cstddef> // For size_t
+#include <memory> // std::allocator, std::allocator_traits
+
+/**
+ * Allocation counters kept by a SequencePool. They let a caller check how
+ * many node requests were served from recycled slots instead of fresh slab
+ * memory, and how many trips were made to the upstream allocator.
+ */
+struct SequencePoolStats {
+    size_t nodeAllocations = 0; // node slots handed out
+    size_t nodeFrees = 0; // node slots given back one at a time
+    size_t freeListReuses = 0; // allocations served from the free list
+    size_t slabAllocations = 0; // calls to the upstream allocator
+    size_t slabFrees = 0; // slabs returned to the upstream allocator
+    size_t bytesReserved = 0; // slab bytes currently held
+};
+
+/**
+ * Fixed-size slot allocator used by a Sequence for its nodes. Slots are
+ * carved out of geometrically growing slabs, freed slots are kept on an
+ * intrusive free list for reuse, and release() hands every slab back at
+ * once instead of freeing slot by slot.
+ *
+ * Slabs come from Alloc (rebound to an internal unit type), so a Sequence
+ * can be pointed at any standard allocator, std::pmr ones included. The
+ * pool only manages raw memory: callers construct and destroy the objects
+ * living in the slots.
+ *
+ * @tparam Alloc Upstream allocator; only its rebound copy is used.
+ */
+template<class Alloc = std::allocator<std::byte>>
+class SequencePool {
+private:
+    struct alignas(std::max_align_t) Unit {
+        unsigned char bytes[alignof(std::max_align_t)];
+    }; // allocation granule, aligned for any slot
+    using UnitAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Unit>;
+    using UnitTraits = std::allocator_traits<UnitAlloc>;
+
+    struct Slab {
+        Slab *next; // next slab in the chain of everything allocated
+        size_t units; // size of this slab in units, header included
+    };
+    struct FreeSlot {
+        FreeSlot *next; // next free slot
+    };
+
+    static constexpr size_t HEADER_BYTES = (sizeof(Slab) + sizeof(Unit) - 1) / sizeof(Unit) * sizeof(Unit);
+
+    UnitAlloc upstream; // where slabs come from
+    size_t slotSize; // bytes per slot, a multiple of the slot alignment
+    Slab *slabs; // every slab owned by the pool
+    Slab *firstSlab; // oldest slab, the end of the chain
+    FreeSlot *freeList; // slots given back and ready for reuse
+    FreeSlot *freeTail; // last slot on the free list
+    char *cursor; // next never-used slot in the newest slab
+    size_t remaining; // never-used slots left after cursor
+    size_t nextSlabSlots; // slots in the next slab to allocate
+    SequencePoolStats counters; // allocation counters
+
+    void grow(size_t slots); // Allocates a new slab with the given number of slots
+    void reset(); // Forgets every slab without freeing it
+
+public:
+    static constexpr size_t FIRST_SLAB_SLOTS = 2; // slots in the first slab
+    static constexpr size_t MAX_SLAB_SLOTS = 64; // slab growth stops here
+
+    SequencePool(size_t size, size_t align, const Alloc &alloc = Alloc()); // Pool for objects of a given size
+    SequencePool(const SequencePool &) = delete; // slots are owned by one pool
+    SequencePool &operator=(const SequencePool &) = delete;
+    SequencePool(SequencePool &&other) noexcept; // Takes over other's slabs
+    SequencePool &operator=(SequencePool &&other) noexcept; // Frees own slabs, takes over other's
+    ~SequencePool(); // Frees every slab
+
+    void *allocate(); // Returns an uninitialized slot
+    void deallocate(void *slot); // Puts a slot on the free list
+    void reserve(size_t slots); // Makes sure the next slots allocations need no new slab
+    void release(); // Frees every slab; all slots must already be dead
+    void adopt(SequencePool &other); // Takes ownership of other's slabs alongside its own
+
+    bool canAdopt(const SequencePool &other) const; // Whether other's slabs may be freed by this pool
+    bool canMoveFrom(const SequencePool &other) const; // Whether move assignment may take other's slabs
+    Alloc get_allocator() const; // Returns the upstream allocator
+    const SequencePoolStats &stats() const; // Counters since construction
+};
+
+/**
+ * Constructs an empty pool for slots of the given size and alignment. No
+ * memory is allocated until the first slot is requested.
+ *
+ * @param size Size of the objects that will live in the slots.
+ * @param align Alignment of those objects, at most alignof(std::max_align_t);
+ * slabs are not aligned any further (BasicSequence checks its blocks).
+ * @param alloc Allocator the slabs are drawn from.
+ */
+template<class Alloc>
+SequencePool<Alloc>::SequencePool(size_t size, size_t align, const Alloc &alloc)
+    : upstream(alloc), slotSize(0), slabs(nullptr), firstSlab(nullptr), freeList(nullptr), freeTail(nullptr),
+      cursor(nullptr), remaining(0), nextSlabSlots(FIRST_SLAB_SLOTS) {
+    if (size < sizeof(FreeSlot)) {
+        size = sizeof(FreeSlot); // a free slot must be able to hold the list link
+    }
+    if (align < alignof(FreeSlot)) {
+        align = alignof(FreeSlot);
+    }
+    slotSize = (size + align - 1) / align * align;
+}
+
+/**
+ * Move constructor. Takes over every slab, free slot and counter of other,
+ * leaving other as an empty pool for the same slot size.
+ *
+ * @param other Pool to take the slabs from.
+ */
+template<class Alloc>
+SequencePool<Alloc>::SequencePool(SequencePool &&other) noexcept
+    : upstream(std::move(other.upstream)), slotSize(other.slotSize), slabs(other.slabs),
+      firstSlab(other.firstSlab), freeList(other.freeList), freeTail(other.freeTail), cursor(other.cursor),
+      remaining(other.remaining), nextSlabSlots(other.nextSlabSlots), counters(other.counters) {
+    other.reset();
+    other.counters = SequencePoolStats();
+}
+
+/**
+ * Move assignment. Frees this pool's slabs, then takes over other's. Every
+ * slot of this pool must already be dead, and canMoveFrom(other) must hold.
+ *
+ * @param other Pool to take the slabs from.
+ * @return Reference to this pool.
+ */
+template<class Alloc>
+SequencePool<Alloc> &SequencePool<Alloc>::operator=(SequencePool &&other) noexcept {
+    if (this != &other) {
+        release();
+        if constexpr (UnitTraits::propagate_on_container_move_assignment::value) {
+            upstream = std::move(other.upstream);
+        }
+        slotSize = other.slotSize;
+        slabs = other.slabs;
+        firstSlab = other.firstSlab;
+        freeList = other.freeList;
+        freeTail = other.freeTail;
+        cursor = other.cursor;
+        remaining = other.remaining;
+        nextSlabSlots = other.nextSlabSlots;
+        counters = other.counters;
+
+        other.reset();
+        other.counters = SequencePoolStats();
+    }
+    return *this;
+}
+
+/**
+ * Destructor. Frees every slab the pool still holds.
+ */
+template<class Alloc>
+SequencePool<Alloc>::~SequencePool() {
+    release();
+}
+
+/**
+ * Forgets every slab and free slot without freeing anything, after their
+ * ownership moved elsewhere or after they were freed.
+ */
+template<class Alloc>
+void SequencePool<Alloc>::reset() {
+    slabs = nullptr;
+    firstSlab = nullptr;
+    freeList = nullptr;
+    freeTail = nullptr;
+    cursor = nullptr;
+    remaining = 0;
+    nextSlabSlots = FIRST_SLAB_SLOTS;
+}
+
+/**
+ * Allocates a new slab and makes it the source of never-used slots.
+ *
+ * @param slots Number of slots in the slab.
+ */
+template<class Alloc>
+void SequencePool<Alloc>::grow(size_t slots) {
+    const size_t bytes = HEADER_BYTES + slots * slotSize;
+    const size_t units = (bytes + sizeof(Unit) - 1) / sizeof(Unit);
+
+    Slab *slab = reinterpret_cast<Slab *>(std::to_address(UnitTraits::allocate(upstream, units)));
+    slab->next = slabs;
+    slab->units = units;
+    slabs = slab;
+    if (firstSlab == nullptr) {
+        firstSlab = slab;
+    }
+
+    cursor = reinterpret_cast<char *>(slab) + HEADER_BYTES;
+    remaining = slots;
+    counters.slabAllocations++;
+    counters.bytesReserved += units * sizeof(Unit);
+}
+
+/**
+ * Returns an uninitialized slot, preferring recently freed slots.
+ *
+ * @return Pointer to a slot of the pool's size and alignment.
+ */
+template<class Alloc>
+void *SequencePool<Alloc>::allocate() {
+    counters.nodeAllocations++;
+
+    if (freeList != nullptr) {
+        FreeSlot *slot = freeList;
+        freeList = slot->next;
+        if (freeList == nullptr) {
+            freeTail = nullptr;
+        }
+        counters.freeListReuses++;
+        return slot;
+    }
+
+    if (remaining == 0) {
+        // Each slab is twice the size of the previous one, up to MAX_SLAB_SLOTS
+        grow(nextSlabSlots);
+        if (nextSlabSlots < MAX_SLAB_SLOTS) {
+            nextSlabSlots *= 2;
+        }
+    }
+    void *slot = cursor;
+    cursor += slotSize;
+    remaining--;
+    return slot;
+}
+
+/**
+ * Puts a slot whose object was already destroyed on the free list.
+ *
+ * @param slot Slot previously returned by allocate().
+ */
+template<class Alloc>
+void SequencePool<Alloc>::deallocate(void *slot) {
+    FreeSlot *freed = static_cast<FreeSlot *>(slot);
+    freed->next = freeList;
+    freeList = freed;
+    if (freeTail == nullptr) {
+        freeTail = freed;
+    }
+    counters.nodeFrees++;
+}
+
+/**
+ * Makes sure the next slots calls to allocate() are served without going
+ * back to the upstream allocator, by allocating one slab for all of them.
+ * The never-used slots left in the current slab go on the free list first,
+ * so none are lost. Slots already on the free list are not counted.
+ *
+ * @param slots Number of allocations to prepare for.
+ */
+template<class Alloc>
+void SequencePool<Alloc>::reserve(size_t slots) {
+    if (slots <= remaining) {
+        return;
+    }
+
+    const size_t missing = slots - remaining;
+    for (; remaining > 0; remaining--, cursor += slotSize) {
+        FreeSlot *spare = reinterpret_cast<FreeSlot *>(cursor);
+        spare->next = freeList;
+        freeList = spare;
+        if (freeTail == nullptr) {
+            freeTail = spare;
+        }
+    }
+    grow(missing);
+}
+
+/**
+ * Frees every slab at once. The objects in all slots handed out must have
+ * been destroyed first. The pool can be used again afterwards.
+ */
+template<class Alloc>
+void SequencePool<Alloc>::release() {
+    while (slabs != nullptr) {
+        Slab *slab = slabs;
+        slabs = slab->next;
+        counters.bytesReserved -= slab->units * sizeof(Unit);
+        UnitTraits::deallocate(upstream, reinterpret_cast<Unit *>(slab), slab->units);
+        counters.slabFrees++;
+    }
+
+    reset();
+}
+
+/**
+ * Takes ownership of every slab and free slot of other in O(1), so objects
+ * living in other's slots can move into this pool's owner without being
+ * copied. The never-used tail of other's newest slab is kept but not handed
+ * out again. other is left empty. canAdopt(other) must hold.
+ *
+ * @param other Pool whose slabs are taken over.
+ */
+template<class Alloc>
+void SequencePool<Alloc>::adopt(SequencePool &other) {
+    if (other.slabs == nullptr || this == &other) {
+        return;
+    }
+
+    // Older slabs sit at the end of the chain, so other's chain goes in front
+    other.firstSlab->next = slabs;
+    slabs = other.slabs;
+    if (firstSlab == nullptr) {
+        firstSlab = other.firstSlab;
+    }
+
+    if (other.freeList != nullptr) {
+        other.freeTail->next = freeList;
+        freeList = other.freeList;
+        if (freeTail == nullptr) {
+            freeTail = other.freeTail;
+        }
+    }
+
+    counters.nodeAllocations += other.counters.nodeAllocations;
+    counters.nodeFrees += other.counters.nodeFrees;
+    counters.freeListReuses += other.counters.freeListReuses;
+    counters.slabAllocations += other.counters.slabAllocations;
+    counters.slabFrees += other.counters.slabFrees;
+    counters.bytesReserved += other.counters.bytesReserved;
+
+    other.reset();
+    other.counters = SequencePoolStats();
+}
+
+/**
+ * Checks whether this pool may take over other's slabs alongside its own
+ * with adopt(), and later free them with its own allocator. That needs the
+ * two allocators to free each other's memory; propagation does not help,
+ * as adopt() keeps this pool's allocator.
+ *
+ * @param other Pool whose slabs would be adopted.
+ * @return true if adopt(other) is allowed.
+ */
+template<class Alloc>
+bool SequencePool<Alloc>::canAdopt(const SequencePool &other) const {
+    return UnitTraits::is_always_equal::value || upstream == other.upstream;
+}
+
+/**
+ * Checks whether move assignment from other may take its slabs, which
+ * holds when the allocator moves along with them or when adopt() would
+ * be allowed.
+ *
+ * @param other Pool that would be moved from.
+ * @return true if move assignment from other is allowed.
+ */
+template<class Alloc>
+bool SequencePool<Alloc>::canMoveFrom(const SequencePool &other) const {
+    return UnitTraits::propagate_on_container_move_assignment::value || canAdopt(other);
+}
+
+/**
+ * Returns a copy of the upstream allocator, rebound back to Alloc.
+ *
+ * @return The allocator slabs are drawn from.
+ */
+template<class Alloc>
+Alloc SequencePool<Alloc>::get_allocator() const {
+    return Alloc(upstream);
+}
+
+/**
+ * Returns the allocation counters collected since the pool was created.
+ *
+ * @return The pool's counters.
+ */
+template<class Alloc>
+const SequencePoolStats &SequencePool<Alloc>::stats() const {
+    return counters;
+}
+
+#endif
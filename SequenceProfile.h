@@ -0,0 +1,331 @@
+#ifndef SEQUENCEPROFILE_H
+#define SEQUENCEPROFILE_H
+
+#include <cstddef> // For size_t
+#include <cstdint> // std::uint64_t
+#include <atomic> // process-wide counters
+#include <chrono> // latency timing
+#include <ostream> // std::ostream
+#include <iomanip> // dump formatting
+
+/**
+ * Sequence operations the profiler keeps separate counters for.
+ */
+enum class SequenceOp {
+    INDEX, // operator[]
+    PUSH_BACK, // push_back, emplace_back, append
+    POP_BACK, // pop_back
+    PUSH_FRONT, // push_front, emplace_front
+    POP_FRONT, // pop_front
+    INSERT, // insert, emplace (single element)
+    ERASE, // erase (single element)
+    ERASE_RANGE, // erase(position, count)
+    SPLICE, // splice, range insert
+    COPY, // copy construction and copy assignment
+    CLEAR, // clear
+    PRINT, // operator<<
+    SORT, // sort, merge, unique, reverse
+    COUNT // number of operation kinds
+};
+
+/**
+ * Counters for one operation kind. Latencies go into power-of-two buckets:
+ * bucket b holds calls that took [2^b, 2^(b+1)) nanoseconds.
+ */
+struct SequenceOpProfile {
+    static constexpr size_t BUCKETS = 40; // up to about 18 minutes
+
+    std::uint64_t calls = 0; // completed operations
+    std::uint64_t nodeHops = 0; // blocks visited by index searches and updates
+    std::uint64_t allocations = 0; // blocks taken from the pool
+    std::uint64_t frees = 0; // blocks given back to the pool
+    std::uint64_t allocNanos = 0; // time spent in the pool's allocate
+    std::uint64_t totalNanos = 0; // time spent in the operation, allocation included
+    std::uint64_t histogram[BUCKETS] = {}; // latency histogram
+
+    std::uint64_t percentile(double p) const; // Upper bound of the bucket holding the p-th percentile
+};
+
+/**
+ * A copy of every operation's counters taken at one moment.
+ */
+struct SequenceProfile {
+    SequenceOpProfile ops[static_cast<size_t>(SequenceOp::COUNT)]; // indexed by SequenceOp
+
+    const SequenceOpProfile &operator[](SequenceOp op) const {
+        return ops[static_cast<size_t>(op)];
+    } // counters of one operation kind
+};
+
+/**
+ * Live, shared counters of one operation kind, copied into a
+ * SequenceOpProfile by SequenceProfiler::snapshot().
+ */
+struct SequenceOpCounters {
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> nodeHops{0};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> frees{0};
+    std::atomic<std::uint64_t> allocNanos{0};
+    std::atomic<std::uint64_t> totalNanos{0};
+    std::atomic<std::uint64_t> histogram[SequenceOpProfile::BUCKETS] = {};
+};
+
+/**
+ * Opt-in instrumentation for Sequence. Build with SEQUENCE_PROFILE defined
+ * to turn it on; otherwise every hook below expands to nothing and the
+ * Sequence code is unchanged. Counters are process-wide and updated with
+ * relaxed atomics, so the totals are safe to read while other threads run.
+ *
+ * Work is charged to the outermost profiled operation on the calling
+ * thread, so an insert that ends in a splice counts once, as an insert.
+ */
+class SequenceProfiler {
+private:
+    using Counters = SequenceOpCounters;
+
+    static inline Counters counters[static_cast<size_t>(SequenceOp::COUNT)];
+    static inline thread_local Counters *current = nullptr; // operation running on this thread
+
+    friend class SequenceProfileScope;
+
+public:
+#ifdef SEQUENCE_PROFILE
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false; // hooks are compiled out
+#endif
+
+    static void hops(std::uint64_t n); // Counts blocks visited
+    static void allocation(std::uint64_t nanos); // Counts a block allocation
+    static void free(); // Counts a block going back to the pool
+
+    static SequenceProfile snapshot(); // Copies every counter
+    static void reset(); // Zeroes every counter
+    static const char *name(SequenceOp op); // Name used in dumps
+    static void dump(std::ostream &os, const SequenceProfile &profile); // Writes a profile as a table
+};
+
+/**
+ * Times one operation and charges the work done inside it, unless another
+ * profiled operation is already running on this thread.
+ */
+class SequenceProfileScope {
+private:
+    SequenceProfiler::Counters *counters; // nullptr when nested
+    std::chrono::steady_clock::time_point start; // when the operation began
+
+public:
+    explicit SequenceProfileScope(SequenceOp op); // Starts timing op
+    SequenceProfileScope(const SequenceProfileScope &) = delete;
+    SequenceProfileScope &operator=(const SequenceProfileScope &) = delete;
+    ~SequenceProfileScope(); // Records the latency
+};
+
+#ifdef SEQUENCE_PROFILE
+#define SEQUENCE_PROFILE_CONCAT2(a, b) a##b
+#define SEQUENCE_PROFILE_CONCAT(a, b) SEQUENCE_PROFILE_CONCAT2(a, b)
+#define SEQUENCE_PROFILE_SCOPE(op) SequenceProfileScope SEQUENCE_PROFILE_CONCAT(sequenceProfileScope, __LINE__)(op)
+#define SEQUENCE_PROFILE_HOPS(n) SequenceProfiler::hops(n)
+#define SEQUENCE_PROFILE_FREE() SequenceProfiler::free()
+#else
+#define SEQUENCE_PROFILE_SCOPE(op) ((void) 0)
+#define SEQUENCE_PROFILE_HOPS(n) ((void) 0)
+#define SEQUENCE_PROFILE_FREE() ((void) 0)
+#endif
+
+/**
+ * Returns the upper bound, in nanoseconds, of the histogram bucket that
+ * holds the p-th percentile call.
+ *
+ * @param p Percentile between 0 and 1.
+ * @return Latency bound, or 0 if there were no calls.
+ */
+inline std::uint64_t SequenceOpProfile::percentile(double p) const {
+    std::uint64_t total = 0;
+    for (std::uint64_t count : histogram) {
+        total += count;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    const double rank = p * static_cast<double>(total);
+    std::uint64_t seen = 0;
+    for (size_t b = 0; b < BUCKETS; b++) {
+        seen += histogram[b];
+        if (static_cast<double>(seen) >= rank) {
+            return std::uint64_t(2) << b;
+        }
+    }
+    return std::uint64_t(2) << (BUCKETS - 1);
+}
+
+/**
+ * Adds n visited blocks to the running operation.
+ *
+ * @param n Number of blocks visited.
+ */
+inline void SequenceProfiler::hops(std::uint64_t n) {
+    if (current != nullptr) {
+        current->nodeHops.fetch_add(n, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Counts one block allocation for the running operation.
+ *
+ * @param nanos Time the pool took to hand out the slot.
+ */
+inline void SequenceProfiler::allocation(std::uint64_t nanos) {
+    if (current != nullptr) {
+        current->allocations.fetch_add(1, std::memory_order_relaxed);
+        current->allocNanos.fetch_add(nanos, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Counts one block going back to the pool for the running operation.
+ */
+inline void SequenceProfiler::free() {
+    if (current != nullptr) {
+        current->frees.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Copies every counter. Each counter is read atomically, but counters
+ * updated by other threads during the copy may be from slightly different
+ * moments.
+ *
+ * @return The current profile.
+ */
+inline SequenceProfile SequenceProfiler::snapshot() {
+    SequenceProfile profile;
+    for (size_t i = 0; i < static_cast<size_t>(SequenceOp::COUNT); i++) {
+        const Counters &from = counters[i];
+        SequenceOpProfile &to = profile.ops[i];
+        to.calls = from.calls.load(std::memory_order_relaxed);
+        to.nodeHops = from.nodeHops.load(std::memory_order_relaxed);
+        to.allocations = from.allocations.load(std::memory_order_relaxed);
+        to.frees = from.frees.load(std::memory_order_relaxed);
+        to.allocNanos = from.allocNanos.load(std::memory_order_relaxed);
+        to.totalNanos = from.totalNanos.load(std::memory_order_relaxed);
+        for (size_t b = 0; b < SequenceOpProfile::BUCKETS; b++) {
+            to.histogram[b] = from.histogram[b].load(std::memory_order_relaxed);
+        }
+    }
+    return profile;
+}
+
+/**
+ * Zeroes every counter, e.g. between the phases of a program.
+ */
+inline void SequenceProfiler::reset() {
+    for (Counters &c : counters) {
+        c.calls.store(0, std::memory_order_relaxed);
+        c.nodeHops.store(0, std::memory_order_relaxed);
+        c.allocations.store(0, std::memory_order_relaxed);
+        c.frees.store(0, std::memory_order_relaxed);
+        c.allocNanos.store(0, std::memory_order_relaxed);
+        c.totalNanos.store(0, std::memory_order_relaxed);
+        for (std::atomic<std::uint64_t> &bucket : c.histogram) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Returns the name an operation kind is shown under.
+ *
+ * @param op Operation kind.
+ * @return Its name.
+ */
+inline const char *SequenceProfiler::name(SequenceOp op) {
+    switch (op) {
+        case SequenceOp::INDEX: return "operator[]";
+        case SequenceOp::PUSH_BACK: return "push_back";
+        case SequenceOp::POP_BACK: return "pop_back";
+        case SequenceOp::PUSH_FRONT: return "push_front";
+        case SequenceOp::POP_FRONT: return "pop_front";
+        case SequenceOp::INSERT: return "insert";
+        case SequenceOp::ERASE: return "erase";
+        case SequenceOp::ERASE_RANGE: return "erase_range";
+        case SequenceOp::SPLICE: return "splice";
+        case SequenceOp::COPY: return "copy";
+        case SequenceOp::CLEAR: return "clear";
+        case SequenceOp::PRINT: return "operator<<";
+        case SequenceOp::SORT: return "sort";
+        default: return "?";
+    }
+}
+
+/**
+ * Writes one line per operation kind that was called: counts, average
+ * hops, allocation time and latency percentiles (bucket upper bounds).
+ * The stream's format flags and precision are restored afterwards.
+ *
+ * @param os Stream to write to.
+ * @param profile Profile to show, usually snapshot().
+ */
+inline void SequenceProfiler::dump(std::ostream &os, const SequenceProfile &profile) {
+    const std::ios_base::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+    os << std::left << std::setw(12) << "op" << std::right
+       << std::setw(12) << "calls" << std::setw(12) << "hops/call"
+       << std::setw(10) << "allocs" << std::setw(10) << "frees" << std::setw(12) << "alloc ns"
+       << std::setw(12) << "total ns" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << '\n';
+
+    for (size_t i = 0; i < static_cast<size_t>(SequenceOp::COUNT); i++) {
+        const SequenceOpProfile &p = profile.ops[i];
+        if (p.calls == 0) {
+            continue;
+        }
+        os << std::left << std::setw(12) << name(static_cast<SequenceOp>(i)) << std::right
+           << std::setw(12) << p.calls
+           << std::setw(12) << std::fixed << std::setprecision(2)
+           << static_cast<double>(p.nodeHops) / static_cast<double>(p.calls)
+           << std::setw(10) << p.allocations << std::setw(10) << p.frees
+           << std::setw(12) << p.allocNanos << std::setw(12) << p.totalNanos
+           << std::setw(10) << p.percentile(0.5) << std::setw(10) << p.percentile(0.99) << '\n';
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+
+/**
+ * Starts timing op, unless an outer operation is already being profiled on
+ * this thread.
+ *
+ * @param op Operation kind to charge.
+ */
+inline SequenceProfileScope::SequenceProfileScope(SequenceOp op) : counters(nullptr) {
+    if (SequenceProfiler::current == nullptr) {
+        counters = &SequenceProfiler::counters[static_cast<size_t>(op)];
+        SequenceProfiler::current = counters;
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+/**
+ * Records the call and its latency.
+ */
+inline SequenceProfileScope::~SequenceProfileScope() {
+    if (counters == nullptr) {
+        return;
+    }
+
+    const std::uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    size_t bucket = 0;
+    while (bucket + 1 < SequenceOpProfile::BUCKETS && (nanos >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+
+    counters->calls.fetch_add(1, std::memory_order_relaxed);
+    counters->totalNanos.fetch_add(nanos, std::memory_order_relaxed);
+    counters->histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    SequenceProfiler::current = nullptr;
+}
+
+#endif
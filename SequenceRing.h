@@ -0,0 +1,622 @@
+#ifndef SEQUENCERING_H
+#define SEQUENCERING_H
+
+#include <cstddef> // For size_t
+#include <compare> // iterator ordering
+#include <memory> // std::allocator, std::allocator_traits
+#include <ostream> // std::ostream
+#include <stdexcept> // exceptions
+#include <string> // the Sequence element type
+#include <type_traits> // std::conditional_t
+#include <utility> // std::move, std::forward, std::swap, std::exchange
+
+template<class T, class Alloc>
+class BasicSequenceRing;
+
+/**
+ * Random-access iterator over a BasicSequenceRing, in sequence order from
+ * front to back. Invalidated by any change to the ring.
+ *
+ * @tparam T Element type.
+ * @tparam Const true for a const_iterator.
+ */
+template<class T, bool Const>
+class SequenceRingIterator {
+private:
+    using Slot = std::conditional_t<Const, const T, T>;
+
+    Slot *slots; // the ring's storage
+    size_t capacity; // number of slots
+    size_t first; // slot of the front element
+    size_t position; // index of the element from the front
+
+    SequenceRingIterator(Slot *slots, size_t capacity, size_t first, size_t position)
+        : slots(slots), capacity(capacity), first(first), position(position) {
+    } // constructor used by the ring
+
+    template<class, class>
+    friend class BasicSequenceRing;
+    friend class SequenceRingIterator<T, !Const>;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using iterator_concept = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Slot *;
+    using reference = Slot &;
+
+    SequenceRingIterator() : slots(nullptr), capacity(1), first(0), position(0) {
+    } // default constructor (singular iterator)
+    template<bool Other> requires (Const && !Other)
+    SequenceRingIterator(const SequenceRingIterator<T, Other> &it)
+        : slots(it.slots), capacity(it.capacity), first(it.first), position(it.position) {
+    } // iterator -> const_iterator
+
+    reference operator*() const {
+        return (*this)[0];
+    }
+    pointer operator->() const {
+        return &(*this)[0];
+    }
+    reference operator[](difference_type n) const {
+        const size_t at = first + position + n;
+        return slots[at < capacity ? at : at - capacity];
+    }
+
+    SequenceRingIterator &operator++() {
+        position++;
+        return *this;
+    }
+    SequenceRingIterator operator++(int) {
+        SequenceRingIterator old = *this;
+        position++;
+        return old;
+    }
+    SequenceRingIterator &operator--() {
+        position--;
+        return *this;
+    }
+    SequenceRingIterator operator--(int) {
+        SequenceRingIterator old = *this;
+        position--;
+        return old;
+    }
+    SequenceRingIterator &operator+=(difference_type n) {
+        position += n;
+        return *this;
+    }
+    SequenceRingIterator &operator-=(difference_type n) {
+        position -= n;
+        return *this;
+    }
+
+    friend SequenceRingIterator operator+(SequenceRingIterator it, difference_type n) {
+        return it += n;
+    }
+    friend SequenceRingIterator operator+(difference_type n, SequenceRingIterator it) {
+        return it += n;
+    }
+    friend SequenceRingIterator operator-(SequenceRingIterator it, difference_type n) {
+        return it -= n;
+    }
+    friend difference_type operator-(const SequenceRingIterator &a, const SequenceRingIterator &b) {
+        return static_cast<difference_type>(a.position) - static_cast<difference_type>(b.position);
+    }
+    friend bool operator==(const SequenceRingIterator &a, const SequenceRingIterator &b) {
+        return a.position == b.position;
+    }
+    friend std::strong_ordering operator<=>(const SequenceRingIterator &a, const SequenceRingIterator &b) {
+        return a.position <=> b.position;
+    }
+};
+
+/**
+ * Bounded sequence of T in one fixed block of contiguous storage, used as a
+ * circular buffer: for queue workloads where a BasicSequence's block list
+ * is more than needed. Every slot is allocated by the constructor, so
+ * pushing and popping at either end is O(1), never allocates, and the
+ * memory held stays the same for the ring's whole life.
+ *
+ * The interface follows BasicSequence for the operations a ring can do in
+ * O(1): push/pop/emplace at both ends, operator[], front, back, iterators
+ * and operator<<. Pushing onto a full ring throws instead of growing; check
+ * full() first, or pop before pushing to use it as a sliding window.
+ *
+ * @tparam T Element type.
+ * @tparam Alloc Allocator the storage comes from.
+ */
+template<class T, class Alloc = std::allocator<T>>
+class BasicSequenceRing {
+private:
+    using Traits = std::allocator_traits<Alloc>;
+
+    Alloc alloc; // allocator the storage came from
+    T *slots; // capacity raw slots; numElts of them, from first on, hold elements
+    size_t slotCount; // number of slots
+    size_t first; // slot of the front element
+    size_t numElts; // number of elements
+
+    size_t slotAt(size_t position) const; // Slot holding the element at position
+    void release(); // Destroys the elements and frees the storage
+    void takeStorage(BasicSequenceRing &s); // Frees own storage, takes s's; the allocators must be equal
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using iterator = SequenceRingIterator<T, false>;
+    using const_iterator = SequenceRingIterator<T, true>;
+
+    explicit BasicSequenceRing(size_t capacity, const Alloc &alloc = Alloc()); // Empty ring with room for capacity
+    BasicSequenceRing(const BasicSequenceRing &s); // Copy constructor
+    BasicSequenceRing(BasicSequenceRing &&s) noexcept; // Move constructor
+    BasicSequenceRing &operator=(const BasicSequenceRing &s); // Copy assignment operator
+    BasicSequenceRing &operator=(BasicSequenceRing &&s) noexcept(
+        Traits::propagate_on_container_move_assignment::value || Traits::is_always_equal::value); // Move assignment operator
+    ~BasicSequenceRing(); // Destructor
+
+    T &operator[](size_t position); // Returns element at given position.
+    const T &operator[](size_t position) const; // Read-only access to element at position.
+    void push_back(T element); // Adds an element to the back.
+    template<class... Args>
+    T &emplace_back(Args &&... args); // Constructs an element in place at the back.
+    void push_front(T element); // Adds an element to the front.
+    template<class... Args>
+    T &emplace_front(Args &&... args); // Constructs an element in place at the front.
+    void pop_back(); // Removes the last element.
+    void pop_front(); // Removes the first element.
+    T &front(); // Returns the first element.
+    const T &front() const; // Returns the first element (read only).
+    T &back(); // Returns the last element.
+    const T &back() const; // Returns the last element (read only).
+    bool empty() const; // Checks if the ring has no elements.
+    bool full() const; // Checks if every slot holds an element.
+    size_t size() const; // Returns the number of elements.
+    size_t capacity() const; // Returns the fixed number of slots.
+    void clear(); // Removes every element, keeping the storage.
+
+    iterator begin(); // Iterator to the first element.
+    iterator end(); // Iterator past the last element.
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+};
+
+/**
+ * The string version, matching Sequence.
+ */
+using SequenceRing = BasicSequenceRing<std::string>;
+
+/**
+ * Creates an empty ring and allocates its storage.
+ *
+ * @param capacity Most elements the ring will hold.
+ * @param alloc Allocator for the storage.
+ */
+template<class T, class Alloc>
+BasicSequenceRing<T, Alloc>::BasicSequenceRing(size_t capacity, const Alloc &alloc)
+    : alloc(alloc), slots(nullptr), slotCount(capacity), first(0), numElts(0) {
+    if (capacity != 0) {
+        slots = Traits::allocate(this->alloc, capacity);
+    }
+}
+
+/**
+ * Creates a ring with the same capacity and copies of s's elements, packed
+ * from the first slot.
+ *
+ * @param s Ring to copy.
+ */
+template<class T, class Alloc>
+BasicSequenceRing<T, Alloc>::BasicSequenceRing(const BasicSequenceRing &s)
+    : BasicSequenceRing(s.slotCount, Traits::select_on_container_copy_construction(s.alloc)) {
+    try {
+        for (const T &item : s) {
+            emplace_back(item);
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+/**
+ * Takes over s's storage; s is left empty with no capacity.
+ *
+ * @param s Ring to move from.
+ */
+template<class T, class Alloc>
+BasicSequenceRing<T, Alloc>::BasicSequenceRing(BasicSequenceRing &&s) noexcept
+    : alloc(std::move(s.alloc)), slots(std::exchange(s.slots, nullptr)), slotCount(std::exchange(s.slotCount, 0)),
+      first(std::exchange(s.first, 0)), numElts(std::exchange(s.numElts, 0)) {
+}
+
+/**
+ * Replaces this ring with a copy of s, capacity included. The copy is
+ * built first, from s's allocator if it propagates on copy assignment and
+ * from this ring's otherwise, so nothing changes if it throws.
+ *
+ * @param s Ring to copy.
+ * @return Reference to this ring.
+ */
+template<class T, class Alloc>
+BasicSequenceRing<T, Alloc> &BasicSequenceRing<T, Alloc>::operator=(const BasicSequenceRing &s) {
+    if (this != &s) {
+        constexpr bool propagate = Traits::propagate_on_container_copy_assignment::value;
+        BasicSequenceRing copy(s.slotCount, propagate ? s.alloc : alloc);
+        for (const T &item : s) {
+            copy.emplace_back(item);
+        }
+        if constexpr (propagate) {
+            release();
+            alloc = copy.alloc;
+        }
+        takeStorage(copy);
+    }
+    return *this;
+}
+
+/**
+ * Frees this ring's storage and takes over s's when the allocator moves
+ * along with it or both allocators can free each other's memory.
+ * Otherwise the elements are moved one by one into storage from this
+ * ring's allocator, and s keeps its storage, empty.
+ *
+ * @param s Ring to move from.
+ * @return Reference to this ring.
+ */
+template<class T, class Alloc>
+BasicSequenceRing<T, Alloc> &BasicSequenceRing<T, Alloc>::operator=(BasicSequenceRing &&s) noexcept(
+    Traits::propagate_on_container_move_assignment::value || Traits::is_always_equal::value) {
+    if (this == &s) {
+        return *this;
+    }
+    if constexpr (Traits::propagate_on_container_move_assignment::value) {
+        release();
+        alloc = std::move(s.alloc);
+        takeStorage(s);
+    } else if (Traits::is_always_equal::value || alloc == s.alloc) {
+        takeStorage(s);
+    } else {
+        BasicSequenceRing moved(s.slotCount, alloc);
+        for (T &item : s) {
+            moved.emplace_back(std::move(item));
+        }
+        takeStorage(moved);
+        s.clear();
+    }
+    return *this;
+}
+
+/**
+ * Destroys the elements and frees the storage.
+ */
+template<class T, class Alloc>
+BasicSequenceRing<T, Alloc>::~BasicSequenceRing() {
+    release();
+}
+
+/**
+ * Destroys every element and gives the storage back to the allocator.
+ */
+template<class T, class Alloc>
+void BasicSequenceRing<T, Alloc>::release() {
+    clear();
+    if (slots != nullptr) {
+        Traits::deallocate(alloc, slots, slotCount);
+        slots = nullptr;
+    }
+}
+
+/**
+ * Frees this ring's storage and takes over s's, leaving s empty with no
+ * capacity. s's storage must be freeable by this ring's allocator.
+ *
+ * @param s Ring whose storage is taken.
+ */
+template<class T, class Alloc>
+void BasicSequenceRing<T, Alloc>::takeStorage(BasicSequenceRing &s) {
+    release();
+    slots = std::exchange(s.slots, nullptr);
+    slotCount = std::exchange(s.slotCount, 0);
+    first = std::exchange(s.first, 0);
+    numElts = std::exchange(s.numElts, 0);
+}
+
+/**
+ * Maps a position from the front to the slot that holds it, wrapping
+ * around the end of the storage.
+ *
+ * @param position Index from the front; at most capacity().
+ * @return Slot index.
+ */
+template<class T, class Alloc>
+size_t BasicSequenceRing<T, Alloc>::slotAt(size_t position) const {
+    const size_t at = first + position;
+    return at < slotCount ? at : at - slotCount;
+}
+
+/**
+ * Access to a specified element by index.
+ *
+ * @param position Index of the desired element.
+ * @return Reference to the element.
+ * @throws std::out_of_range if position >= size()
+ */
+template<class T, class Alloc>
+T &BasicSequenceRing<T, Alloc>::operator[](size_t position) {
+    if (position >= numElts) {
+        throw std::out_of_range("Index is out of range");
+    }
+    return slots[slotAt(position)];
+}
+
+/**
+ * Read-only access to a specified element by index.
+ *
+ * @param position Index of the desired element.
+ * @return Const reference to the element.
+ * @throws std::out_of_range if position >= size()
+ */
+template<class T, class Alloc>
+const T &BasicSequenceRing<T, Alloc>::operator[](size_t position) const {
+    if (position >= numElts) {
+        throw std::out_of_range("Index is out of range");
+    }
+    return slots[slotAt(position)];
+}
+
+/**
+ * Adds an element after the last one.
+ *
+ * @param item The element to add.
+ * @throws std::length_error if the ring is full.
+ */
+template<class T, class Alloc>
+void BasicSequenceRing<T, Alloc>::push_back(T item) {
+    emplace_back(std::move(item));
+}
+
+/**
+ * Constructs an element after the last one, in the slot past it.
+ *
+ * @param args Arguments forwarded to the constructor of T.
+ * @return Reference to the new element.
+ * @throws std::length_error if the ring is full.
+ */
+template<class T, class Alloc>
+template<class... Args>
+T &BasicSequenceRing<T, Alloc>::emplace_back(Args &&... args) {
+    if (numElts == slotCount) {
+        throw std::length_error("Ring is full");
+    }
+    T *slot = slots + slotAt(numElts);
+    Traits::construct(alloc, slot, std::forward<Args>(args)...);
+    numElts++;
+    return *slot;
+}
+
+/**
+ * Adds an element before the first one.
+ *
+ * @param item The element to add.
+ * @throws std::length_error if the ring is full.
+ */
+template<class T, class Alloc>
+void BasicSequenceRing<T, Alloc>::push_front(T item) {
+    emplace_front(std::move(item));
+}
+
+/**
+ * Constructs an element before the first one, in the slot before it,
+ * wrapping to the end of the storage.
+ *
+ * @param args Arguments forwarded to the constructor of T.
+ * @return Reference to the new element.
+ * @throws std::length_error if the ring is full.
+ */
+template<class T, class Alloc>
+template<class... Args>
+T &BasicSequenceRing<T, Alloc>::emplace_front(Args &&... args) {
+    if (numElts == slotCount) {
+        throw std::length_error("Ring is full");
+    }
+    const size_t before = first == 0 ? slotCount - 1 : first - 1;
+    Traits::construct(alloc, slots + before, std::forward<Args>(args)...);
+    first = before;
+    numElts++;
+    return slots[first];
+}
+
+/**
+ * Removes the last element.
+ *
+ * @throws std::out_of_range if the ring is empty.
+ */
+template<class T, class Alloc>
+void BasicSequenceRing<T, Alloc>::pop_back() {
+    if (numElts == 0) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    Traits::destroy(alloc, slots + slotAt(numElts - 1));
+    numElts--;
+}
+
+/**
+ * Removes the first element; its slot becomes the free slot at the back.
+ *
+ * @throws std::out_of_range if the ring is empty.
+ */
+template<class T, class Alloc>
+void BasicSequenceRing<T, Alloc>::pop_front() {
+    if (numElts == 0) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    Traits::destroy(alloc, slots + first);
+    first = slotAt(1);
+    numElts--;
+    if (numElts == 0) {
+        first = 0; // keep the next run of elements unwrapped
+    }
+}
+
+/**
+ * Returns the first element.
+ *
+ * @return Reference to the first element.
+ * @throws std::out_of_range if the ring is empty.
+ */
+template<class T, class Alloc>
+T &BasicSequenceRing<T, Alloc>::front() {
+    if (numElts == 0) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    return slots[first];
+}
+
+/**
+ * Returns the first element.
+ *
+ * @return Const reference to the first element.
+ * @throws std::out_of_range if the ring is empty.
+ */
+template<class T, class Alloc>
+const T &BasicSequenceRing<T, Alloc>::front() const {
+    if (numElts == 0) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    return slots[first];
+}
+
+/**
+ * Returns the last element.
+ *
+ * @return Reference to the last element.
+ * @throws std::out_of_range if the ring is empty.
+ */
+template<class T, class Alloc>
+T &BasicSequenceRing<T, Alloc>::back() {
+    if (numElts == 0) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    return slots[slotAt(numElts - 1)];
+}
+
+/**
+ * Returns the last element.
+ *
+ * @return Const reference to the last element.
+ * @throws std::out_of_range if the ring is empty.
+ */
+template<class T, class Alloc>
+const T &BasicSequenceRing<T, Alloc>::back() const {
+    if (numElts == 0) {
+        throw std::out_of_range("Sequence is empty");
+    }
+    return slots[slotAt(numElts - 1)];
+}
+
+/**
+ * Checks if the ring holds no elements.
+ *
+ * @return true if size() == 0.
+ */
+template<class T, class Alloc>
+bool BasicSequenceRing<T, Alloc>::empty() const {
+    return numElts == 0;
+}
+
+/**
+ * Checks if the ring has no free slot left.
+ *
+ * @return true if size() == capacity().
+ */
+template<class T, class Alloc>
+bool BasicSequenceRing<T, Alloc>::full() const {
+    return numElts == slotCount;
+}
+
+/**
+ * Returns the number of elements.
+ *
+ * @return Number of elements.
+ */
+template<class T, class Alloc>
+size_t BasicSequenceRing<T, Alloc>::size() const {
+    return numElts;
+}
+
+/**
+ * Returns the number of slots, fixed at construction.
+ *
+ * @return Most elements the ring can hold.
+ */
+template<class T, class Alloc>
+size_t BasicSequenceRing<T, Alloc>::capacity() const {
+    return slotCount;
+}
+
+/**
+ * Destroys every element. The storage is kept for reuse.
+ */
+template<class T, class Alloc>
+void BasicSequenceRing<T, Alloc>::clear() {
+    for (size_t i = 0; i < numElts; i++) {
+        Traits::destroy(alloc, slots + slotAt(i));
+    }
+    first = 0;
+    numElts = 0;
+}
+
+template<class T, class Alloc>
+typename BasicSequenceRing<T, Alloc>::iterator BasicSequenceRing<T, Alloc>::begin() {
+    return iterator(slots, slotCount, first, 0);
+}
+
+template<class T, class Alloc>
+typename BasicSequenceRing<T, Alloc>::iterator BasicSequenceRing<T, Alloc>::end() {
+    return iterator(slots, slotCount, first, numElts);
+}
+
+template<class T, class Alloc>
+typename BasicSequenceRing<T, Alloc>::const_iterator BasicSequenceRing<T, Alloc>::begin() const {
+    return const_iterator(slots, slotCount, first, 0);
+}
+
+template<class T, class Alloc>
+typename BasicSequenceRing<T, Alloc>::const_iterator BasicSequenceRing<T, Alloc>::end() const {
+    return const_iterator(slots, slotCount, first, numElts);
+}
+
+template<class T, class Alloc>
+typename BasicSequenceRing<T, Alloc>::const_iterator BasicSequenceRing<T, Alloc>::cbegin() const {
+    return begin();
+}
+
+template<class T, class Alloc>
+typename BasicSequenceRing<T, Alloc>::const_iterator BasicSequenceRing<T, Alloc>::cend() const {
+    return end();
+}
+
+/**
+ * Writes the elements in the same format as a Sequence: <a, b, c>.
+ *
+ * @param os Stream to write to.
+ * @param s Ring to print.
+ * @return os.
+ */
+template<class T, class Alloc>
+std::ostream &operator<<(std::ostream &os, const BasicSequenceRing<T, Alloc> &s) {
+    os << "<";
+    for (size_t i = 0; i < s.size(); i++) {
+        if (i != 0) {
+            os << ", ";
+        }
+        os << s[i];
+    }
+    os << ">";
+    return os;
+}
+
+#endif
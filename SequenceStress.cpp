@@ -0,0 +1,495 @@
+/**
+ * SequenceStress.cpp
+ * Project 3
+ * CS 3100
+ *
+ * Stress test and throughput benchmark for ConcurrentSequence.
+ *
+ * The stress test runs producers, consumers popping from both ends, a
+ * thread inserting markers in the middle, and a snapshot reader all at
+ * once. It then checks that every produced value was consumed exactly once
+ * and that every snapshot kept each producer's values in order.
+ *
+ * A second test does the same for SequenceBatcher: producers append
+ * through the batch queue while another thread inserts markers, and the
+ * flushed result must hold every value once, in producer order. A third
+ * runs a manual-mode SequenceBatcher with several threads calling commit()
+ * at once; batches must still be applied in the order they were queued.
+ * A fourth has several threads read one Sequence through const lookups,
+ * which share its finger, one HybridSequence, whose reads bump shared
+ * counters, and a ConcurrentSequence through at() while another thread
+ * appends to it; every read must find its element. A fifth pops from a
+ * large ConcurrentSequence while a snapshot taken just before each pop is
+ * still alive, so every pop has to give the sequence its own block headers
+ * again and copy the tail block, and readers calling at() meanwhile time
+ * their longest wait.
+ *
+ * The benchmark runs a push_back/try_pop_back mix on 1, 2, 4, ... threads
+ * up to the number of cores. It compares ConcurrentSequence with a plain
+ * Sequence behind one global mutex. A second table compares inserts at
+ * random positions through ConcurrentSequence and through SequenceBatcher.
+ *
+ * Usage: SequenceStress [operations per thread, default 200000]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ConcurrentSequence.h"
+#include "SequenceBatch.h"
+#include "SequenceHybrid.h"
+
+using namespace std;
+
+namespace {
+
+using Value = long long;
+
+constexpr Value MARKER = -1; // inserted in the middle, never produced
+
+/**
+ * Runs the mixed workload and checks the results.
+ *
+ * @param producers Number of producer threads.
+ * @param perProducer Values each producer appends.
+ * @return true if no value was lost, duplicated or reordered.
+ */
+bool stress(int producers, Value perProducer) {
+    BasicConcurrentSequence<Value> s;
+    const Value total = producers * perProducer;
+    vector<atomic<int>> seen(total);
+    atomic<Value> consumed{0};
+    atomic<long> markersIn{0};
+    atomic<long> markersOut{0};
+    atomic<bool> producing{true};
+    atomic<bool> ordered{true};
+
+    auto take = [&](Value v) {
+        if (v == MARKER) {
+            markersOut++;
+        } else {
+            seen[v]++;
+            consumed++;
+        }
+    };
+
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            for (Value i = 0; i < perProducer; i++) {
+                s.push_back(p * perProducer + i);
+            }
+        });
+    }
+    for (int c = 0; c < 2; c++) {
+        threads.emplace_back([&, c] {
+            Value v;
+            while (producing || !s.empty()) {
+                if (c == 0 ? s.try_pop_front(v) : s.try_pop_back(v)) {
+                    take(v);
+                }
+            }
+        });
+    }
+    threads.emplace_back([&] {
+        unsigned rng = 12345;
+        while (producing) {
+            rng = rng * 1103515245 + 12345;
+            size_t n = s.size();
+            try {
+                s.insert(n == 0 ? 0 : rng % n, MARKER);
+                markersIn++;
+            } catch (const out_of_range &) {
+                // the consumers shrank the sequence in between
+            }
+        }
+    });
+    threads.emplace_back([&] {
+        while (producing) {
+            // Values of one producer must appear in the order they were appended
+            vector<Value> last(producers, -1);
+            const BasicSequence<Value> snapshot = s.snapshot();
+            for (Value v : snapshot) {
+                if (v != MARKER) {
+                    Value p = v / perProducer;
+                    if (v <= last[p]) {
+                        ordered = false;
+                    }
+                    last[p] = v;
+                }
+            }
+        }
+    });
+
+    for (int p = 0; p < producers; p++) {
+        threads[p].join();
+    }
+    producing = false;
+    for (size_t t = producers; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    // Consumers may stop just before the last insert landed
+    Value v;
+    while (s.try_pop_front(v)) {
+        take(v);
+    }
+
+    bool ok = consumed == total && markersIn == markersOut && ordered;
+    for (Value i = 0; i < total; i++) {
+        ok = ok && seen[i] == 1;
+    }
+    return ok;
+}
+
+/**
+ * Appends through a SequenceBatcher from several threads while another one
+ * inserts markers at random positions, then checks the flushed result.
+ *
+ * @param producers Number of producer threads.
+ * @param perProducer Values each producer appends.
+ * @return true if no value was lost, duplicated or reordered and no
+ * mutation was rejected.
+ */
+bool batchStress(int producers, Value perProducer) {
+    BasicSequenceBatcher<Value> s;
+    atomic<bool> producing{true};
+    atomic<long> markers{0};
+
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            for (Value i = 0; i < perProducer; i++) {
+                s.push_back(p * perProducer + i);
+            }
+        });
+    }
+    threads.emplace_back([&] {
+        unsigned rng = 12345;
+        while (producing) {
+            rng = rng * 1103515245 + 12345;
+            size_t n = s.size(); // only grows, so the position stays valid
+            s.insert(n == 0 ? 0 : rng % (n + 1), MARKER);
+            markers++;
+        }
+    });
+
+    for (int p = 0; p < producers; p++) {
+        threads[p].join();
+    }
+    producing = false;
+    threads.back().join();
+    s.flush();
+
+    // Each producer's values must all be there, consecutive and in order
+    vector<Value> last(producers);
+    for (int p = 0; p < producers; p++) {
+        last[p] = p * perProducer - 1;
+    }
+    long markersSeen = 0;
+    bool ok = s.stats().rejected == 0;
+    for (Value v : s.snapshot()) {
+        if (v == MARKER) {
+            markersSeen++;
+        } else {
+            Value p = v / perProducer;
+            ok = ok && v == last[p] + 1;
+            last[p] = v;
+        }
+    }
+    for (int p = 0; p < producers; p++) {
+        ok = ok && last[p] == (p + 1) * perProducer - 1;
+    }
+    return ok && markersSeen == markers;
+}
+
+/**
+ * Appends in order to a manual-mode SequenceBatcher with small batches
+ * while several threads call commit() at once. Every so often the producer
+ * flushes and checks that everything it queued is applied. Last, one
+ * batch holds a push_back and then an insert at size(), and the append
+ * must still come out last.
+ *
+ * @param committers Number of threads calling commit().
+ * @param count Values appended.
+ * @return true if the values came out in order and flush() never
+ * returned early.
+ */
+bool commitStress(int committers, Value count) {
+    BasicSequenceBatcher<Value> s(SequenceCommit::MANUAL, 8);
+    atomic<bool> producing{true};
+    bool ok = true;
+
+    vector<thread> threads;
+    for (int c = 0; c < committers; c++) {
+        threads.emplace_back([&] {
+            while (producing) {
+                s.commit();
+            }
+        });
+    }
+    for (Value i = 0; i < count; i++) {
+        s.push_back(i);
+        if (i % 1000 == 999) {
+            s.flush();
+            ok = ok && s.size() == static_cast<size_t>(i + 1);
+        }
+    }
+    producing = false;
+    for (thread &t : threads) {
+        t.join();
+    }
+    s.flush();
+    s.push_back(count + 1);
+    s.insert(count, count); // same batch, submitted later, still goes before the append
+    s.flush();
+
+    Value expected = 0;
+    for (Value v : s.snapshot()) {
+        ok = ok && v == expected++;
+    }
+    return ok && expected == count + 2;
+}
+
+/**
+ * Reads one sequence from several threads at once, forward, backward and
+ * at random positions, through const lookups that all move its finger,
+ * does the same with a hybrid sequence, whose lookups all count reads, and
+ * reads a ConcurrentSequence with at() while another thread appends.
+ *
+ * @param readers Number of reader threads.
+ * @param reads Lookups each reader makes in each sequence.
+ * @return true if every lookup found the element at its position.
+ */
+bool readStress(int readers, Value reads) {
+    constexpr Value SIZE = 100000;
+    BasicSequence<Value> s;
+    BasicHybridSequence<Value> hybrid;
+    BasicConcurrentSequence<Value> concurrent;
+    for (Value v = 0; v < SIZE - 1; v++) {
+        s.push_back(v);
+        hybrid.push_back(v);
+        concurrent.push_back(v);
+    }
+    hybrid.push_back(SIZE - 1);
+    s.push_back(SIZE - 1);
+    concurrent.insert(SIZE - 1, SIZE - 1); // moves the staged appends into the sequence
+    const BasicSequence<Value> &shared = s;
+    const BasicHybridSequence<Value> &sharedHybrid = hybrid;
+    atomic<bool> ok{true};
+
+    vector<thread> threads;
+    for (int r = 0; r < readers; r++) {
+        threads.emplace_back([&, r] {
+            unsigned rng = 12345 + r;
+            for (Value i = 0; i < reads; i++) {
+                rng = rng * 1103515245 + 12345;
+                const Value position = r % 3 == 0 ? i % SIZE : r % 3 == 1 ? SIZE - 1 - i % SIZE : rng % SIZE;
+                if (shared[position] != position || sharedHybrid[position] != position
+                    || concurrent.at(position) != position) {
+                    ok = false;
+                }
+            }
+        });
+    }
+    threads.emplace_back([&] {
+        for (Value v = SIZE; v < SIZE + reads; v++) {
+            concurrent.push_back(v);
+        }
+    });
+    for (thread &t : threads) {
+        t.join();
+    }
+    const Value last = SIZE + reads - 1;
+    return ok && concurrent.size() == static_cast<size_t>(last + 1) && concurrent.at(last) == last;
+}
+
+/**
+ * Takes a snapshot of a large sequence and pops from its back while the
+ * snapshot is alive, over and over, so that every pop finds the blocks
+ * shared, while readers look up elements with at(). Each pop rebuilds the
+ * block headers and copies one block under the exclusive lock, which must
+ * stay short enough not to hold the readers up. The readers' throughput
+ * shows that even on one core, where the longest wait is mostly down to
+ * the scheduler: readers blocked on the lock sleep.
+ *
+ * @param readers Number of reader threads.
+ * @param pops Snapshots taken, each followed by one pop.
+ * @param popRate Receives the pops per second.
+ * @param readRate Receives the at() calls per second, all readers together.
+ * @param worstWait Receives the longest single at() call, in microseconds.
+ * @return true if every pop and every snapshot saw the right elements.
+ */
+bool snapshotPops(int readers, int pops, double &popRate, double &readRate, double &worstWait) {
+    constexpr Value SIZE = 1000000;
+    BasicConcurrentSequence<Value> s;
+    for (Value v = 0; v < SIZE; v++) {
+        s.push_back(v);
+    }
+    s.insert(SIZE, SIZE); // moves the staged appends into the sequence
+    atomic<bool> popping{true};
+    atomic<bool> ok{true};
+    vector<long long> waits(readers, 0);
+    atomic<long long> reads{0};
+
+    vector<thread> threads;
+    for (int r = 0; r < readers; r++) {
+        threads.emplace_back([&, r] {
+            unsigned rng = 777 + r;
+            while (popping) {
+                rng = rng * 1103515245 + 12345;
+                const Value position = rng % (SIZE - pops);
+                const auto start = chrono::steady_clock::now();
+                const Value found = s.at(position);
+                const auto nanos = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+                waits[r] = max<long long>(waits[r], nanos.count());
+                if (found != position) {
+                    ok = false;
+                }
+                reads.fetch_add(1, memory_order_relaxed);
+            }
+        });
+    }
+
+    const auto start = chrono::steady_clock::now();
+    const long long readsBefore = reads;
+    for (int i = 0; i < pops; i++) {
+        const BasicSequence<Value> snapshot = s.snapshot();
+        Value v;
+        if (!s.try_pop_back(v) || v != SIZE - i || snapshot.size() != static_cast<size_t>(SIZE + 1 - i)
+            || snapshot.back() != SIZE - i) {
+            ok = false;
+        }
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    popRate = pops / seconds;
+    readRate = (reads - readsBefore) / seconds;
+    popping = false;
+    for (thread &t : threads) {
+        t.join();
+    }
+    worstWait = *max_element(waits.begin(), waits.end()) / 1000.0;
+    return ok && s.size() == static_cast<size_t>(SIZE + 1 - pops);
+}
+
+/**
+ * Times a push/pop mix on the given number of threads.
+ *
+ * @param threadCount Threads to run.
+ * @param perThread Operations per thread.
+ * @param op Called as op(thread index, operation index).
+ * @return Million operations per second across all threads.
+ */
+template<class Op>
+double throughput(int threadCount, long perThread, Op op) {
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            for (long i = 0; i < perThread; i++) {
+                op(t, i);
+            }
+        });
+    }
+    for (thread &t : threads) {
+        t.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return threadCount * perThread / seconds / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const long perThread = argc > 1 ? atol(argv[1]) : 200000;
+    const int cores = thread::hardware_concurrency() > 0 ? static_cast<int>(thread::hardware_concurrency()) : 1;
+
+    cout << "Stress test: ";
+    bool ok = stress(cores > 2 ? cores - 2 : 2, perThread / 4 + 1);
+    cout << (ok ? "passed" : "FAILED") << endl;
+    cout << "Batch test: ";
+    bool batchOk = batchStress(cores > 1 ? cores - 1 : 2, perThread / 4 + 1);
+    cout << (batchOk ? "passed" : "FAILED") << endl;
+    ok = ok && batchOk;
+    cout << "Commit test: ";
+    bool commitOk = commitStress(cores > 2 ? cores : 3, perThread / 4 + 1000);
+    cout << (commitOk ? "passed" : "FAILED") << endl;
+    ok = ok && commitOk;
+    cout << "Read test: ";
+    bool readOk = readStress(cores > 2 ? cores : 3, perThread);
+    cout << (readOk ? "passed" : "FAILED") << endl;
+    ok = ok && readOk;
+    cout << "Snapshot pop test: ";
+    double popRate;
+    double readRate;
+    double worstWait;
+    bool snapshotOk = snapshotPops(cores > 2 ? cores - 1 : 2, 200, popRate, readRate, worstWait);
+    cout << (snapshotOk ? "passed" : "FAILED") << " (" << popRate << " pops/s with a live snapshot, "
+         << readRate / 1e6 << " M at()/s alongside, longest " << worstWait << " us)" << endl;
+    ok = ok && snapshotOk;
+
+    cout << "threads  ConcurrentSequence  mutex+Sequence  (Mops/s, 3 push_back : 1 pop_back)" << endl;
+    vector<int> counts;
+    for (int n = 1; n < cores; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(cores); // always finish with every core
+
+    for (int n : counts) {
+        BasicConcurrentSequence<Value> concurrent;
+        double split = throughput(n, perThread, [&](int, long i) {
+            if (i % 4 == 3) {
+                Value v;
+                concurrent.try_pop_back(v);
+            } else {
+                concurrent.push_back(i);
+            }
+        });
+
+        BasicSequence<Value> plain;
+        mutex global;
+        double locked = throughput(n, perThread, [&](int, long i) {
+            scoped_lock lock(global);
+            if (i % 4 == 3) {
+                if (!plain.empty()) {
+                    plain.pop_back();
+                }
+            } else {
+                plain.push_back(i);
+            }
+        });
+
+        cout << n << "\t " << split << "\t\t     " << locked << endl;
+    }
+
+    // Positions below the initial size stay valid as the sequences only grow
+    constexpr Value initial = 1000;
+    cout << "threads  ConcurrentSequence  SequenceBatcher  (Mops/s, insert at random position)" << endl;
+    for (int n : counts) {
+        BasicConcurrentSequence<Value> concurrent;
+        BasicSequenceBatcher<Value> batcher;
+        for (Value v = 0; v < initial; v++) {
+            concurrent.push_back(v);
+            batcher.push_back(v);
+        }
+        batcher.flush();
+
+        double direct = throughput(n, perThread, [&](int t, long i) {
+            concurrent.insert((t * 7919 + i * 104729) % initial, i);
+        });
+        double batched = throughput(n, perThread, [&](int t, long i) {
+            batcher.insert((t * 7919 + i * 104729) % initial, i);
+            if (i == perThread - 1) {
+                batcher.flush(); // count the time until this thread's inserts are applied
+            }
+        });
+
+        cout << n << "\t " << direct << "\t\t     " << batched << "\t(" << batcher.stats() << ")" << endl;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,1048 @@
+/**
+ * SequenceTests.cpp
+ * Project 3
+ * CS 3100
+ *
+ * Unit tests for the parts of Sequence that SequenceTestHarness and the
+ * differential fuzzer do not reach: element types with their own notion of
+ * equality, and the features that sit beside the core list.
+ *
+ * Each test prints its name and "passed", or "FAILED" with the first check
+ * that did not hold. The exit code is 1 if any test failed.
+ *
+ * Usage: SequenceTests [test name...]   (default: every test)
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory_resource>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Sequence.h"
+#include "SequenceIntern.h"
+#include "SequenceView.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Collects the checks of one test and remembers the first that failed.
+ */
+class Checks {
+private:
+    string failure; // first failed check, or empty
+
+public:
+    void operator()(bool ok, const string &what) {
+        if (!ok && failure.empty()) {
+            failure = what;
+        }
+    }
+
+    bool passed() const {
+        return failure.empty();
+    }
+
+    const string &first() const {
+        return failure;
+    }
+};
+
+/**
+ * InternedString compares by text, so equal text interned in two pools is
+ * equal although the handles point at different copies. Sequences of them
+ * must agree with the elements, and hash alike when equal.
+ */
+void internAcrossPools(Checks &check) {
+    SequenceStringPool left;
+    SequenceStringPool right;
+    BasicSequence<InternedString> a;
+    BasicSequence<InternedString> b;
+    for (const char *word : {"hello", "world", "hello", ""}) {
+        a.push_back(InternedString(left, word));
+        b.push_back(InternedString(right, word));
+    }
+    check(a[0].data() != b[0].data(), "the pools hold separate copies");
+    check(a[0] == b[0], "elements with equal text are equal");
+    check(a == b, "sequences with equal text are equal");
+    check(a.hash() == b.hash(), "equal sequences hash alike");
+    check(hash<BasicSequence<InternedString>>()(a) == b.hash(), "std::hash matches hash()");
+    check(a.find(InternedString(right, "world")) == 1, "find across pools");
+    check(a.count(InternedString(right, "hello")) == 2, "count across pools");
+
+    b.back() = InternedString(right, "other");
+    check(!(a == b), "a different last element is unequal");
+    b.back() = InternedString();
+    check(a == b, "the empty string without a pool equals one from a pool");
+}
+
+/**
+ * Interning keeps one copy per distinct text per pool, and handles from
+ * the same pool share it.
+ */
+void internPool(Checks &check) {
+    SequenceStringPool pool;
+    const size_t emptyBytes = pool.bytes();
+    InternedString a(pool, "token");
+    InternedString b(pool, string("tok") + "en");
+    InternedString c(pool, string(100, 'x'));
+    check(a.data() == b.data(), "equal text from one pool shares its copy");
+    check(pool.size() == 2, "one entry per distinct text");
+    check(pool.bytes() > emptyBytes + 100, "pool bytes count a long string's buffer");
+    check(a.str() == "token" && c.size() == 100 && !c.empty(), "the text reads back");
+    check(InternedString().empty() && InternedString() == InternedString(pool, ""), "default handle is the empty string");
+
+    BasicSequence<InternedString> s;
+    SequenceStringPool other;
+    for (const char *word : {"a", "a", "b", "b", "b", "a"}) {
+        s.push_back(InternedString(s.size() % 2 == 0 ? pool : other, word));
+    }
+    check(s.unique() == 3 && s.size() == 3, "unique folds equal text from different pools");
+    check(s[0].str() == "a" && s[1].str() == "b" && s[2].str() == "a", "unique keeps the first of each run");
+}
+
+/**
+ * footprint() counts elements, blocks and their bytes, the slabs behind
+ * them and the heap buffers of long strings, and nothing for short ones.
+ */
+void footprintBytes(Checks &check) {
+    check(BasicSequence<int>().footprint().bytesPerElement() == 0.0, "an empty sequence holds nothing");
+
+    constexpr size_t perBlock = SequenceNode<int>::CAPACITY;
+    BasicSequence<int> ints;
+    vector<int> values(3 * perBlock, 7);
+    ints.append(values.begin(), values.end());
+    SequenceFootprint f = ints.footprint();
+    check(f.elements == 3 * perBlock && f.blocks == 3, "full blocks of int");
+    check(f.blockBytes == 3 * (sizeof(SequenceNode<int>) + sizeof(SequenceChunk<int>)), "block bytes");
+    check(f.reservedBytes >= f.blockBytes && f.reservedBytes == ints.allocationStats().bytesReserved, "reserved bytes");
+    check(f.heapBytes == 0, "ints own no heap memory");
+    check(f.bytesPerElement() == static_cast<double>(f.reservedBytes) / f.elements, "bytes per element");
+
+    Sequence strings;
+    for (size_t i = 0; i < 100; i++) {
+        strings.push_back(i % 2 == 0 ? string("short") : string(100, 'x'));
+    }
+    size_t longBuffers = 0;
+    for (const string &item : std::as_const(strings)) {
+        const char *inside = reinterpret_cast<const char *>(&item);
+        bool local = item.data() >= inside && item.data() < inside + sizeof(string);
+        longBuffers += local ? 0 : item.capacity() + 1;
+    }
+    f = strings.footprint();
+    check(f.blocks == (100 + SequenceNode<string>::CAPACITY - 1) / SequenceNode<string>::CAPACITY, "string blocks");
+    check(f.heapBytes == longBuffers && f.heapBytes >= 50 * 101, "long strings count their buffers");
+
+    Sequence copy(strings);
+    check(copy.footprint().heapBytes == f.heapBytes && copy.footprint().blocks == f.blocks,
+          "a sharing copy counts the shared blocks");
+    strings.clear();
+    check(strings.footprint().blocks == 0 && strings.footprint().heapBytes == 0, "clear leaves nothing");
+
+    constexpr size_t perInterned = SequenceNode<InternedString>::CAPACITY;
+    check(perInterned > SequenceNode<string>::CAPACITY, "interned blocks hold more elements than string blocks");
+    SequenceStringPool pool;
+    vector<InternedString> words(2 * perInterned, InternedString(pool, string(100, 'x')));
+    BasicSequence<InternedString> interned;
+    interned.append(words.begin(), words.end());
+    f = interned.footprint();
+    check(f.blocks == 2 && f.heapBytes == 0, "interned strings keep their text in the pool");
+}
+
+/**
+ * The profiler charges calls, allocations and frees to the outermost
+ * operation, and its dump leaves the stream's formatting as it found it.
+ * The counts are only checked when built with SEQUENCE_PROFILE.
+ */
+void profileCounts(Checks &check) {
+    SequenceProfiler::reset();
+    constexpr size_t perBlock = SequenceNode<int>::CAPACITY;
+    BasicSequence<int> s;
+    for (size_t i = 0; i <= perBlock; i++) {
+        s.push_back(static_cast<int>(i));
+    }
+    s.pop_back(); // empties and frees the second block
+    s.insert(0, -1); // splits the full block
+    s.erase(0);
+    BasicSequence<int> copy(s); // shares the blocks
+    const int first = s[0];
+    SequenceProfile profile = SequenceProfiler::snapshot();
+
+    if constexpr (SequenceProfiler::ENABLED) {
+        const SequenceOpProfile &pushes = profile[SequenceOp::PUSH_BACK];
+        check(pushes.calls == perBlock + 1 && pushes.allocations == 2 && pushes.frees == 0, "push_back counts");
+        const SequenceOpProfile &pops = profile[SequenceOp::POP_BACK];
+        check(pops.calls == 1 && pops.allocations == 0 && pops.frees == 1, "pop_back counts");
+        const SequenceOpProfile &inserts = profile[SequenceOp::INSERT];
+        check(inserts.calls == 1 && inserts.allocations == 1 && inserts.frees == 0, "insert counts");
+        check(profile[SequenceOp::SPLICE].calls == 0, "work inside insert is charged to insert");
+        check(profile[SequenceOp::ERASE].calls == 1, "erase counts");
+        check(profile[SequenceOp::COPY].calls == 1 && profile[SequenceOp::COPY].allocations == 0,
+              "a sharing copy allocates nothing");
+        check(profile[SequenceOp::INDEX].calls == 1 && first == 0, "operator[] counts");
+
+        uint64_t bucketed = 0;
+        for (uint64_t count : pushes.histogram) {
+            bucketed += count;
+        }
+        check(bucketed == pushes.calls, "every call lands in one latency bucket");
+        SequenceProfiler::reset();
+        check(SequenceProfiler::snapshot()[SequenceOp::PUSH_BACK].calls == 0, "reset zeroes the counters");
+    } else {
+        check(profile[SequenceOp::PUSH_BACK].calls == 0, "hooks are compiled out");
+    }
+
+    ostringstream out;
+    out << hex << showbase;
+    out.precision(4);
+    const ios_base::fmtflags flags = out.flags();
+    SequenceProfiler::dump(out, profile);
+    check(out.flags() == flags && out.precision() == 4, "dump restores the stream's format");
+    check(out.str().find("push_back") != string::npos || !SequenceProfiler::ENABLED, "dump lists called operations");
+    check(out.str().find("clear") == string::npos, "dump skips operations that were not called");
+}
+
+/**
+ * A file in the temporary directory, removed when the test ends.
+ */
+class TempFile {
+private:
+    string path;
+
+public:
+    explicit TempFile(const string &name)
+        : path((filesystem::temp_directory_path() / ("SequenceTests-" + name)).string()) {
+    }
+
+    TempFile(const TempFile &) = delete;
+    TempFile &operator=(const TempFile &) = delete;
+
+    ~TempFile() {
+        remove(path.c_str());
+    }
+
+    const string &name() const {
+        return path;
+    }
+
+    string read() const {
+        ifstream in(path, ios::binary);
+        return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    void write(const string &bytes) const {
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+    }
+};
+
+/**
+ * Returns true if opening path as a SequenceView throws runtime_error.
+ */
+bool viewRejects(const string &path) {
+    try {
+        SequenceView view(path);
+    } catch (const runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Returns true if loading bytes into s throws runtime_error and leaves s
+ * as it was.
+ */
+bool loadRejects(Sequence &s, const string &bytes) {
+    const Sequence before(s);
+    istringstream in(bytes);
+    try {
+        s.load(in);
+    } catch (const runtime_error &) {
+        return s == before;
+    }
+    return false;
+}
+
+/**
+ * A saved sequence reads back the same through load and SequenceView.
+ */
+void viewRoundTrip(Checks &check) {
+    Sequence s;
+    for (const string &item : {string("red"), string(), string(1000, 'z'), string("a\0b", 3)}) {
+        s.push_back(item);
+    }
+    TempFile file("round-trip.seq");
+    {
+        ofstream out(file.name(), ios::binary);
+        s.save(out);
+    }
+
+    Sequence loaded;
+    {
+        ifstream in(file.name(), ios::binary);
+        loaded.load(in);
+    }
+    check(loaded == s, "load reads back what save wrote");
+
+    SequenceView view(file.name());
+    bool same = view.size() == s.size() && !view.empty();
+    for (size_t i = 0; same && i < s.size(); i++) {
+        same = view[i] == std::as_const(s)[i];
+    }
+    check(same, "the view reads back what save wrote");
+    bool outOfRange = false;
+    try {
+        (void) view[s.size()];
+    } catch (const out_of_range &) {
+        outOfRange = true;
+    }
+    check(outOfRange, "the view checks positions");
+
+    SequenceView moved(std::move(view));
+    check(moved.size() == s.size() && moved[2].size() == 1000 && view.empty(), "a moved view keeps the mapping");
+
+    TempFile empty("empty.seq");
+    {
+        ofstream out(empty.name(), ios::binary);
+        Sequence().save(out);
+    }
+    check(SequenceView(empty.name()).empty(), "an empty sequence round-trips");
+}
+
+/**
+ * Files cut short anywhere, with a wrong tag or with an index that does
+ * not match the element count are rejected, and load leaves the sequence
+ * as it was.
+ */
+void viewRejectsDamage(Checks &check) {
+    constexpr size_t WORD = SequenceFormat::WORD_BYTES;
+    Sequence s;
+    for (const char *word : {"one", "two", "three"}) {
+        s.push_back(word);
+    }
+    ostringstream out;
+    s.save(out);
+    const string good = out.str();
+    TempFile file("damaged.seq");
+    Sequence target;
+    target.push_back("kept");
+
+    bool truncated = true;
+    for (size_t length = 0; length < good.size(); length++) {
+        file.write(good.substr(0, length));
+        truncated = truncated && viewRejects(file.name()) && loadRejects(target, good.substr(0, length));
+    }
+    check(truncated, "truncated files are rejected");
+    check(viewRejects(file.name() + ".missing"), "a missing file is rejected");
+
+    string badMagic = good;
+    badMagic[0] = 'X';
+    file.write(badMagic);
+    check(viewRejects(file.name()) && loadRejects(target, badMagic), "a wrong header tag is rejected");
+    string badTrailer = good;
+    badTrailer.back() = 'X';
+    file.write(badTrailer);
+    check(viewRejects(file.name()) && loadRejects(target, badTrailer), "a wrong trailer tag is rejected");
+
+    for (std::uint64_t count : {std::uint64_t(2), std::uint64_t(4), ~std::uint64_t(0)}) {
+        string mismatch = good;
+        SequenceFormat::putWord(mismatch.data() + WORD, count);
+        file.write(mismatch);
+        check(viewRejects(file.name()) && loadRejects(target, mismatch), "an index not matching the count is rejected");
+    }
+    string badOffset = good;
+    SequenceFormat::putWord(badOffset.data() + badOffset.size() - SequenceFormat::TRAILER_BYTES, good.size());
+    file.write(badOffset);
+    check(viewRejects(file.name()) && loadRejects(target, badOffset), "an index offset past the end is rejected");
+
+    string badRecord = good;
+    const size_t index = SequenceFormat::getWord(good.data() + good.size() - SequenceFormat::TRAILER_BYTES);
+    SequenceFormat::putWord(badRecord.data() + index + WORD, good.size());
+    file.write(badRecord);
+    SequenceView view(file.name());
+    bool damaged = false;
+    try {
+        (void) view[1];
+    } catch (const runtime_error &) {
+        damaged = true;
+    }
+    check(damaged && view[0] == "one", "a record offset outside the file is rejected on lookup");
+    check(target.size() == 1 && target[0] == "kept", "failed loads leave the sequence unchanged");
+}
+
+/**
+ * Memory resource that counts what it hands out, on top of new and delete.
+ */
+class CountingResource : public pmr::memory_resource {
+public:
+    size_t allocations = 0; // calls to allocate
+    size_t liveBytes = 0; // bytes allocated and not yet freed
+
+private:
+    void *do_allocate(size_t bytes, size_t align) override {
+        allocations++;
+        liveBytes += bytes;
+        return pmr::new_delete_resource()->allocate(bytes, align);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t align) override {
+        liveBytes -= bytes;
+        pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+
+    bool do_is_equal(const pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/**
+ * merge reuses other's blocks when both draw on the same memory resource
+ * and moves the elements over when they do not, also when either side
+ * still shares its blocks with a copy.
+ */
+void mergeAdoptOrCopy(Checks &check) {
+    using PmrInts = BasicSequence<int, pmr::polymorphic_allocator<int>>;
+    constexpr size_t perBlock = SequenceNode<int>::CAPACITY;
+    CountingResource home;
+    CountingResource away;
+    auto fill = [](PmrInts &s, int from, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            s.push_back(from + 2 * static_cast<int>(i));
+        }
+    };
+    auto sortedRun = [](const PmrInts &s, size_t n) {
+        bool ok = s.size() == n;
+        for (size_t i = 1; ok && i < n; i++) {
+            ok = s[i - 1] + 1 == s[i];
+        }
+        return ok;
+    };
+
+    for (bool shareFirst : {false, true}) {
+        PmrInts a(0, &home);
+        PmrInts b(0, &home);
+        fill(a, 0, 3 * perBlock);
+        fill(b, 1, 3 * perBlock);
+        PmrInts aCopy(shareFirst ? a : PmrInts(0, &home));
+        PmrInts bCopy(shareFirst ? b : PmrInts(0, &home));
+        const size_t before = home.allocations;
+        a.merge(std::move(b));
+        check(sortedRun(a, 6 * perBlock) && b.empty(), "merge on one resource interleaves both");
+        check(shareFirst || home.allocations == before, "merge on one resource reuses other's blocks");
+        check(!shareFirst || (aCopy.size() == 3 * perBlock && bCopy.size() == 3 * perBlock && aCopy[1] == 2
+                              && bCopy[1] == 3), "merge leaves the sharing copies alone");
+    }
+
+    for (bool shareFirst : {false, true}) {
+        PmrInts a(0, &home);
+        fill(a, 0, 3 * perBlock);
+        {
+            PmrInts b(0, &away);
+            fill(b, 1, 3 * perBlock);
+            PmrInts bCopy(shareFirst ? b : PmrInts(0, &away));
+            const size_t before = home.allocations;
+            a.merge(std::move(b));
+            check(sortedRun(a, 6 * perBlock) && b.empty(), "merge across resources interleaves both");
+            check(home.allocations > before, "merge across resources copies into this resource");
+            check(!shareFirst || (bCopy.size() == 3 * perBlock && bCopy[0] == 1), "merge leaves other's copy alone");
+        }
+        check(away.liveBytes == 0, "merge across resources keeps nothing of other's resource");
+    }
+}
+
+/**
+ * Copies share the blocks of a const sequence without changing it, so
+ * several threads may copy one sequence at once, and the copies outlive
+ * it. A sequence moved away while shared takes the blocks as they are,
+ * even into another memory resource, since the share owns them then.
+ * clone() copies instead of sharing.
+ */
+void copySharesConst(Checks &check) {
+    using PmrInts = BasicSequence<int, pmr::polymorphic_allocator<int>>;
+    constexpr size_t N = 5 * SequenceNode<int>::CAPACITY;
+    CountingResource home;
+    CountingResource away;
+    {
+        PmrInts original(0, &home);
+        for (size_t i = 0; i < N; i++) {
+            original.push_back(static_cast<int>(i));
+        }
+        const PmrInts &source = original;
+        const SequencePoolStats before = source.allocationStats();
+
+        atomic<bool> same{true};
+        vector<PmrInts> kept;
+        mutex keptLock;
+        vector<thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < 50; i++) {
+                    PmrInts copy(source);
+                    const size_t position = (t * 131 + i * 17) % N;
+                    if (copy.size() != N || as_const(copy)[position] != static_cast<int>(position)) {
+                        same = false;
+                    }
+                    if (i == 0) {
+                        lock_guard<mutex> guard(keptLock);
+                        kept.push_back(std::move(copy));
+                    }
+                }
+            });
+        }
+        for (thread &t : threads) {
+            t.join();
+        }
+        check(same, "every concurrent copy reads the source's elements");
+        const SequencePoolStats &after = source.allocationStats();
+        check(after.nodeAllocations == before.nodeAllocations && after.bytesReserved == before.bytesReserved,
+              "copying leaves the source's pool alone");
+        const size_t beforeClone = home.allocations;
+        const PmrInts own = source.clone();
+        check(source.sharing() && !own.sharing() && own == source && home.allocations > beforeClone,
+              "clone copies the blocks at once instead of sharing them");
+
+        const size_t allocated = home.allocations;
+        original.push_back(-1);
+        check(home.allocations > allocated && kept[0].size() == N, "a write to the source detaches it alone");
+
+        PmrInts again(source);
+        PmrInts moved(0, &away);
+        PmrInts movedCopy(0, &away);
+        moved = std::move(original);
+        movedCopy = std::move(kept[1]);
+        check(moved.size() == N + 1 && as_const(moved)[N] == -1 && movedCopy.size() == N && away.allocations == 0,
+              "a shared sequence moves across resources without copying");
+        kept.clear();
+        moved.clear();
+        const PmrInts &survivor = again;
+        check(survivor.size() == N + 1 && survivor[0] == 0 && survivor[N] == -1,
+              "copies outlive the sequence they came from");
+    }
+    check(home.liveBytes == 0 && away.liveBytes == 0, "the last copy frees the shared blocks");
+}
+
+/**
+ * The first write after a copy gives the writer block headers of its own
+ * and copies only the chunk it writes to; the other chunks stay shared
+ * until they are written in turn.
+ */
+void writeCopiesOneBlock(Checks &check) {
+    constexpr size_t perBlock = SequenceNode<int>::CAPACITY;
+    constexpr size_t blocks = 16;
+    BasicSequence<int> s;
+    for (size_t i = 0; i < blocks * perBlock; i++) {
+        s.push_back(static_cast<int>(i));
+    }
+    const BasicSequence<int> snap = s;
+    const size_t before = s.allocationStats().nodeAllocations;
+    s[3 * perBlock] = -1;
+    check(s.allocationStats().nodeAllocations - before == blocks + 1, "the first write copies the headers and one chunk");
+    s[3 * perBlock + 1] = -2;
+    s.erase(7 * perBlock);
+    check(s.allocationStats().nodeAllocations - before == blocks + 2, "later writes copy only the chunks they touch");
+    check(snap.size() == blocks * perBlock && snap[3 * perBlock] == static_cast<int>(3 * perBlock)
+          && snap[3 * perBlock + 1] == static_cast<int>(3 * perBlock + 1)
+          && snap[7 * perBlock] == static_cast<int>(7 * perBlock), "the copy keeps its elements");
+    check(s.size() == blocks * perBlock - 1 && as_const(s)[3 * perBlock] == -1 && as_const(s)[3 * perBlock + 1] == -2
+          && as_const(s)[7 * perBlock] == static_cast<int>(7 * perBlock + 1), "the writer sees its changes");
+}
+
+/**
+ * push_front and pop_front move the head block's start instead of shifting
+ * its elements, so a queue churning at the front allocates no blocks, and
+ * the offset survives copies, inserts next to it and reordering.
+ */
+void frontOffset(Checks &check) {
+    constexpr size_t perBlock = SequenceNode<int>::CAPACITY;
+    BasicSequence<int> s;
+    deque<int> model;
+    auto same = [&] {
+        return s.size() == model.size() && equal(model.begin(), model.end(), s.begin());
+    };
+    for (int i = 0; i < 10; i++) {
+        s.push_back(i);
+        model.push_back(i);
+    }
+    for (int i = 1; i <= static_cast<int>(2 * perBlock); i++) {
+        s.push_front(-i);
+        model.push_front(-i);
+    }
+    check(same(), "push_front onto a block pushed onto from the back");
+
+    const size_t before = s.allocationStats().nodeAllocations;
+    for (int i = 0; i < 1000; i++) {
+        s.pop_front();
+        s.push_front(i);
+        s.push_front(i + 1);
+        s.pop_front();
+        model.pop_front();
+        model.push_front(i);
+    }
+    check(s.allocationStats().nodeAllocations == before, "front churn reuses the head's slots");
+    check(same(), "front churn keeps the elements in order");
+
+    const BasicSequence<int> snap = s;
+    s.push_front(-100);
+    s.insert(3, -200);
+    s.pop_front();
+    model.insert(model.begin() + 2, -200);
+    check(same() && snap.size() + 1 == s.size() && snap[2] == model[3], "the offset is copied with the head");
+
+    BasicSequence<int> other;
+    other.push_back(7);
+    other.push_front(8);
+    s.splice(0, std::move(other));
+    model.push_front(7);
+    model.push_front(8);
+    s.push_back(9);
+    model.push_back(9);
+    s.reverse();
+    reverse(model.begin(), model.end());
+    check(same(), "splice and reverse move the old head's elements back to slot 0");
+    s.sort();
+    sort(model.begin(), model.end());
+    check(same(), "sort refills blocks from slot 0");
+}
+
+/**
+ * extract relinks the blocks inside the run into the new sequence, which
+ * borrows the source's arena for them; only the two blocks cut at the ends
+ * move elements. Chunks a copy still reads stay shared with it, and the
+ * blocks outlive the sequence they came from.
+ */
+void extractRelinks(Checks &check) {
+    constexpr size_t perBlock = SequenceNode<int>::CAPACITY;
+    constexpr size_t blocks = 32;
+    BasicSequence<int> moved;
+    {
+        BasicSequence<int> s;
+        for (size_t i = 0; i < blocks * perBlock; i++) {
+            s.push_back(static_cast<int>(i));
+        }
+        const BasicSequence<int> snap = s;
+        s.push_back(-1); // headers of its own, snap keeps the old ones
+        const size_t before = s.allocationStats().nodeAllocations;
+        moved = s.extract(perBlock + 3, 20 * perBlock);
+        check(s.allocationStats().nodeAllocations - before <= 6, "only the two blocks at the cuts are copied and split");
+        check(moved.size() == 20 * perBlock && moved.front() == static_cast<int>(perBlock + 3)
+              && as_const(moved)[20 * perBlock - 1] == static_cast<int>(21 * perBlock + 2), "the run moves out in order");
+        check(s.size() == 12 * perBlock + 1 && as_const(s)[perBlock + 3] == static_cast<int>(21 * perBlock + 3),
+              "the source closes the gap");
+        check(snap.size() == blocks * perBlock && snap[perBlock + 3] == static_cast<int>(perBlock + 3)
+              && snap[10 * perBlock] == static_cast<int>(10 * perBlock), "the copy keeps its elements");
+        moved[5 * perBlock] = -2;
+        check(snap[5 * perBlock + perBlock + 3] == static_cast<int>(6 * perBlock + 3),
+              "a write to the moved run stays out of the copy");
+    }
+    moved.push_back(-3);
+    check(moved.size() == 20 * perBlock + 1 && as_const(moved)[5 * perBlock] == -2 && moved.back() == -3,
+          "the moved blocks outlive the source");
+}
+
+/**
+ * A reference from non-const access may be written through after a copy
+ * is taken, so until the next change copies get blocks of their own
+ * instead of sharing the ones the reference points into.
+ */
+void unshareableAfterAccess(Checks &check) {
+    Sequence s;
+    for (size_t i = 0; i < 10; i++) {
+        s.push_back(to_string(i));
+    }
+    string &r = s[5];
+    Sequence snap = s;
+    r = "CHANGED";
+    check(as_const(snap)[5] == "5" && as_const(s)[5] == "CHANGED", "a write through s[5] stays out of the copy");
+    check(!s.sharing() && !snap.sharing(), "the copy was made with blocks of its own");
+
+    string &first = s.front();
+    string &last = s.back();
+    Sequence assigned;
+    assigned = s;
+    first = "front";
+    last = "back";
+    check(as_const(assigned).front() == "0" && as_const(assigned).back() == "9",
+          "writes through front() and back() stay out of an assigned copy");
+
+    Sequence::iterator it = s.begin();
+    Sequence fromBegin(s);
+    *++it = "one";
+    check(as_const(fromBegin)[1] == "1" && as_const(s)[1] == "one", "a write through begin() stays out of the copy");
+
+    s.push_back("10");
+    Sequence shared(s);
+    check(s.sharing() && shared == s, "after the next change copies share the blocks again");
+}
+
+/**
+ * Queries on a const indexed sequence may run on several threads, even
+ * when the index is stale and the first of them rebuilds it. A middle
+ * insert leaves the counts current and the positions stale, so readers of
+ * the counts overlap with the reader rebuilding the positions.
+ */
+void indexSharedQueries(Checks &check) {
+    constexpr size_t N = 5000;
+    Sequence s;
+    for (size_t i = 0; i < N; i++) {
+        s.push_back(to_string(i % 100));
+    }
+    s.enableIndex();
+    const Sequence &source = s;
+    check(source.count("7") == N / 100, "the first query builds the index");
+
+    for (int round = 0; round < 3; round++) {
+        s.insert(10 + round, "x");
+        atomic<bool> same{true};
+        vector<thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < 20; i++) {
+                    const bool agree = (t + i) % 2 == 0
+                                           ? source.count("x") == static_cast<size_t>(round + 1)
+                                           : source.find("x") == 10 && source.positions("99").size() == N / 100;
+                    if (!agree || !source.contains("42")) {
+                        same = false;
+                    }
+                }
+            });
+        }
+        for (thread &t : threads) {
+            t.join();
+        }
+        check(same, "concurrent queries agree while the index rebuilds");
+    }
+}
+
+/**
+ * The hash index stays exact through middle inserts and erases, the block
+ * splits and merges they cause, set(), and writes through references from
+ * operator[], front and back, including two references written after both
+ * were taken.
+ */
+void indexThroughWrites(Checks &check) {
+    constexpr size_t N = 3000;
+    Sequence s;
+    for (size_t i = 0; i < N; i++) {
+        s.push_back(to_string(i % 50));
+    }
+    s.enableIndex();
+    const Sequence &source = s;
+    auto agrees = [&](const string &value) {
+        vector<size_t> expected;
+        for (size_t i = 0; i < source.size(); i++) {
+            if (source[i] == value) {
+                expected.push_back(i);
+            }
+        }
+        return source.positions(value) == expected && source.count(value) == expected.size()
+               && source.find(value, 7) == (upper_bound(expected.begin(), expected.end(), 6) == expected.end()
+                                                ? Sequence::npos
+                                                : *upper_bound(expected.begin(), expected.end(), 6));
+    };
+    check(agrees("7"), "the first query builds the index");
+
+    mt19937 random(42);
+    for (int round = 0; round < 400; round++) {
+        const size_t at = random() % s.size();
+        const string value = to_string(random() % 60);
+        switch (round % 5) {
+            case 0:
+                s.insert(at, value);
+                break;
+            case 1:
+                s.erase(at);
+                break;
+            case 2:
+                s.set(at, value);
+                break;
+            case 3:
+                s[at] = value;
+                break;
+            default:
+                swap(s[at], s[(at + 1) % s.size()]);
+                s.front() = value;
+                s.back() = "7";
+                break;
+        }
+        if (round % 40 == 0) {
+            for (int i = 0; i < 300; i++) {
+                s.insert(at, "x"); // splits the block at at, over and over
+            }
+            s.erase(at, 250);
+        }
+        if (!agrees(value) || !agrees("7") || !agrees("x")) {
+            check(false, "queries agree with a scan after round " + to_string(round));
+            break;
+        }
+    }
+}
+
+/**
+ * Element that records which threads copy, move and destroy it, and how
+ * many of its kind are alive.
+ */
+class Tracked {
+private:
+    static inline mutex lock;
+    static inline set<thread::id> threads;
+
+    static void seen() {
+        lock_guard<mutex> guard(lock);
+        threads.insert(this_thread::get_id());
+    }
+
+public:
+    static inline atomic<long> live{0};
+    int value;
+
+    explicit Tracked(int value = 0) : value(value) {
+        live++;
+    }
+
+    Tracked(const Tracked &other) : value(other.value) {
+        live++;
+        seen();
+    }
+
+    Tracked(Tracked &&other) noexcept : value(other.value) {
+        live++;
+        seen();
+    }
+
+    Tracked &operator=(const Tracked &other) = default;
+    Tracked &operator=(Tracked &&other) noexcept = default;
+
+    ~Tracked() {
+        live--;
+        seen();
+    }
+
+    /**
+     * Forgets the threads seen so far and returns how many there were.
+     */
+    static size_t takeThreads() {
+        lock_guard<mutex> guard(lock);
+        return exchange(threads, {}).size();
+    }
+};
+
+/**
+ * Forces the parallel passes onto small sequences for one test, and
+ * restores the defaults after it.
+ */
+class ForcedWorkers {
+public:
+    ForcedWorkers(size_t minElements, unsigned workers) {
+        SequenceParallelism::set(minElements, workers);
+    }
+
+    ForcedWorkers(const ForcedWorkers &) = delete;
+    ForcedWorkers &operator=(const ForcedWorkers &) = delete;
+
+    ~ForcedWorkers() {
+        SequenceParallelism::reset();
+    }
+};
+
+/**
+ * With the threshold lowered and four workers forced, cloning, destroying
+ * and clearAsync run on four threads each and keep every element exactly
+ * once, while detaching a copy copies one block on the calling thread.
+ */
+void parallelPasses(Checks &check) {
+    constexpr unsigned WORKERS = 4;
+    constexpr int N = 20000;
+    const ForcedWorkers forced(1000, WORKERS);
+    check(SequenceParallelism::minElements() == 1000 && SequenceParallelism::maxWorkers() == WORKERS,
+          "the settings are taken");
+    auto inOrder = [](const BasicSequence<Tracked> &s, int n) {
+        bool ok = s.size() == static_cast<size_t>(n);
+        for (int i = 0; ok && i < n; i++) {
+            ok = s[i].value == i;
+        }
+        return ok;
+    };
+
+    {
+        BasicSequence<Tracked> s;
+        for (int i = 0; i < N; i++) {
+            s.emplace_back(i);
+        }
+        Tracked::takeThreads();
+
+        BasicSequence<Tracked> copy(s);
+        copy.push_back(Tracked(N)); // detaches: copies the tail block only
+        check(Tracked::takeThreads() == 1, "detaching copies no more than one block");
+        check(inOrder(copy, N + 1) && inOrder(s, N), "the detached copy has every element");
+
+        BasicSequence<Tracked> own = s.clone();
+        check(Tracked::takeThreads() == WORKERS && inOrder(own, N), "cloning copies on every worker");
+
+        BasicSequence<Tracked> small;
+        for (int i = 0; i < 100; i++) {
+            small.emplace_back(i);
+        }
+        Tracked::takeThreads();
+        BasicSequence<Tracked> smallCopy = small.clone();
+        smallCopy.pop_back();
+        check(Tracked::takeThreads() == 1 && inOrder(smallCopy, 99), "sequences under the threshold stay on one thread");
+
+        Tracked::takeThreads();
+        own = BasicSequence<Tracked>(); // tears down the cloned blocks
+        check(Tracked::takeThreads() == WORKERS, "teardown runs on every worker");
+        copy = BasicSequence<Tracked>(); // s is the only one left reading its blocks
+        Tracked::takeThreads();
+
+        future<void> done = s.clearAsync();
+        check(s.empty(), "clearAsync empties at once");
+        done.get();
+        check(Tracked::takeThreads() == WORKERS, "clearAsync tears down on every worker");
+    }
+    check(Tracked::live == 0, "every element is destroyed exactly once");
+}
+
+/**
+ * With four workers forced, sort sorts its blocks and runs its merge
+ * passes on four threads and stays stable, merge keeps the order of equal
+ * elements whether it reuses other's blocks or sorts a copy of them, and an
+ * exception thrown on a worker reaches the caller with no element lost or
+ * destroyed twice.
+ */
+void parallelSortMerge(Checks &check) {
+    constexpr unsigned WORKERS = 4;
+    constexpr int N = 20000;
+    constexpr int KEYS = 97;
+    const ForcedWorkers forced(1000, WORKERS);
+    auto byKey = [](const Tracked &a, const Tracked &b) {
+        return a.value % KEYS < b.value % KEYS;
+    };
+    auto stable = [](const BasicSequence<Tracked> &s) {
+        for (size_t i = 1; i < s.size(); i++) {
+            const int a = s[i - 1].value;
+            const int b = s[i].value;
+            if (a % KEYS > b % KEYS || (a % KEYS == b % KEYS && a >= b)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    {
+        BasicSequence<Tracked> s;
+        for (int i = 0; i < N; i++) {
+            s.emplace_back(i);
+        }
+        Tracked::takeThreads();
+        s.sort(byKey);
+        check(Tracked::takeThreads() == WORKERS, "sort runs on every worker");
+        check(s.size() == N && stable(s), "the parallel sort is stable");
+
+        BasicSequence<Tracked> evens;
+        BasicSequence<Tracked> odds;
+        for (int i = 0; i < N; i++) {
+            (i % 2 == 0 ? evens : odds).emplace_back(i);
+        }
+        evens.sort(byKey);
+        odds.sort(byKey);
+        evens.merge(std::move(odds), byKey);
+        bool evensFirst = evens.size() == N && odds.empty();
+        for (size_t i = 1; evensFirst && i < evens.size(); i++) {
+            const int a = evens[i - 1].value;
+            const int b = evens[i].value;
+            evensFirst = a % KEYS < b % KEYS || (a % KEYS == b % KEYS && (a % 2 < b % 2 || (a % 2 == b % 2 && a < b)));
+        }
+        check(evensFirst, "merge keeps this sequence's equal elements first");
+
+        pmr::unsynchronized_pool_resource home;
+        pmr::unsynchronized_pool_resource away;
+        BasicSequence<Tracked, pmr::polymorphic_allocator<Tracked>> here(0, &home);
+        BasicSequence<Tracked, pmr::polymorphic_allocator<Tracked>> there(0, &away);
+        for (int i = 0; i < N; i++) {
+            (i < N / 2 ? here : there).emplace_back(N - 1 - i);
+        }
+        here.sort(byKey);
+        there.sort(byKey);
+        Tracked::takeThreads();
+        here.merge(std::move(there), byKey);
+        check(Tracked::takeThreads() == WORKERS, "merge across resources sorts on every worker");
+        bool merged = here.size() == N;
+        for (size_t i = 1; merged && i < here.size(); i++) {
+            merged = here[i - 1].value % KEYS <= here[i].value % KEYS;
+        }
+        check(merged, "merge across resources keeps the order");
+
+        int calls = 0;
+        mutex callsLock;
+        bool thrown = false;
+        try {
+            s.sort([&](const Tracked &a, const Tracked &b) {
+                lock_guard<mutex> guard(callsLock);
+                if (++calls == N / 2) {
+                    throw runtime_error("comparison failed");
+                }
+                return a.value < b.value;
+            });
+        } catch (const runtime_error &) {
+            thrown = true;
+        }
+        check(thrown && s.size() == N, "an exception on a worker reaches the caller with the size kept");
+    }
+    check(Tracked::live == 0, "every element is destroyed exactly once");
+}
+
+struct Test {
+    const char *name;
+    function<void(Checks &)> run;
+};
+
+const vector<Test> TESTS = {
+    {"intern_across_pools", internAcrossPools},
+    {"intern_pool", internPool},
+    {"footprint_bytes", footprintBytes},
+    {"profile_counts", profileCounts},
+    {"merge_adopt_or_copy", mergeAdoptOrCopy},
+    {"copy_shares_const", copySharesConst},
+    {"unshareable_after_access", unshareableAfterAccess},
+    {"write_copies_one_block", writeCopiesOneBlock},
+    {"front_offset", frontOffset},
+    {"extract_relinks", extractRelinks},
+    {"index_shared_queries", indexSharedQueries},
+    {"index_through_writes", indexThroughWrites},
+    {"parallel_passes", parallelPasses},
+    {"parallel_sort_merge", parallelSortMerge},
+    {"view_round_trip", viewRoundTrip},
+    {"view_rejects_damage", viewRejectsDamage},
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    bool ok = true;
+    for (const Test &test : TESTS) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++) {
+            selected = selected || argv[i] == string(test.name);
+        }
+        if (!selected) {
+            continue;
+        }
+        Checks check;
+        test.run(check);
+        cout << test.name << ": " << (check.passed() ? "passed" : "FAILED (" + check.first() + ")") << endl;
+        ok = ok && check.passed();
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+#ifndef SEQUENCEVIEW_H
+#define SEQUENCEVIEW_H
+
+#include <cstddef> // For size_t
+#include <cstdint> // std::uint64_t
+#include <cstring> // std::memcmp
+#include <fstream> // fallback reader
+#include <iterator> // std::istreambuf_iterator
+#include <stdexcept> // exceptions
+#include <string> // file paths
+#include <string_view> // elements
+#include <utility> // std::exchange
+#include <vector> // fallback buffer
+#include "SequenceFormat.h"
+
+#if __has_include(<sys/mman.h>) && __has_include(<sys/stat.h>) && __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define SEQUENCE_VIEW_MMAP 1
+#else
+#define SEQUENCE_VIEW_MMAP 0
+#endif
+
+/**
+ * Read-only view of a file written by Sequence::save. Opening the view
+ * maps the file and checks its header and trailer, O(1) however large the
+ * file is. No nodes are built: operator[] finds a record through the
+ * file's offset index and returns a string_view into the mapping, so only
+ * the pages that are touched are ever read from disk.
+ *
+ * Where mmap is not available the file is read into memory instead; the
+ * interface is the same.
+ *
+ * The file must not change while it is mapped. Views returned by
+ * operator[] are valid while the SequenceView is.
+ */
+class SequenceView {
+private:
+    const char *bytes = nullptr; // start of the file contents
+    size_t fileBytes = 0; // size of the file
+    size_t count = 0; // number of elements
+    size_t indexOffset = 0; // where the offset index starts
+    bool mapped = false; // bytes points into an mmap mapping
+    std::vector<char> buffer; // file contents when not mapped
+
+    void open(const std::string &path); // Maps or reads the file
+    void validate(); // Checks the header and trailer
+    void close(); // Unmaps the file
+
+public:
+    explicit SequenceView(const std::string &path); // Opens a saved sequence
+    SequenceView(SequenceView &&other) noexcept;
+    SequenceView &operator=(SequenceView &&other) noexcept;
+    SequenceView(const SequenceView &) = delete;
+    SequenceView &operator=(const SequenceView &) = delete;
+    ~SequenceView();
+
+    std::string_view operator[](size_t position) const; // Element at the given position
+    size_t size() const; // Returns the number of elements.
+    bool empty() const; // Checks if the view has no elements.
+};
+
+/**
+ * Opens a file written by Sequence::save.
+ *
+ * @param path File to open.
+ * @throws std::runtime_error if the file cannot be read or was not written
+ * by save.
+ */
+inline SequenceView::SequenceView(const std::string &path) {
+    open(path);
+    try {
+        validate();
+    } catch (...) {
+        close();
+        throw;
+    }
+}
+
+/**
+ * Takes over other's mapping; other is left empty.
+ *
+ * @param other View to move from.
+ */
+inline SequenceView::SequenceView(SequenceView &&other) noexcept
+    : bytes(std::exchange(other.bytes, nullptr)), fileBytes(std::exchange(other.fileBytes, 0)),
+      count(std::exchange(other.count, 0)), indexOffset(std::exchange(other.indexOffset, 0)),
+      mapped(std::exchange(other.mapped, false)), buffer(std::move(other.buffer)) {
+}
+
+/**
+ * Drops this view's file and takes over other's mapping.
+ *
+ * @param other View to move from.
+ * @return Reference to this view.
+ */
+inline SequenceView &SequenceView::operator=(SequenceView &&other) noexcept {
+    if (this != &other) {
+        close();
+        bytes = std::exchange(other.bytes, nullptr);
+        fileBytes = std::exchange(other.fileBytes, 0);
+        count = std::exchange(other.count, 0);
+        indexOffset = std::exchange(other.indexOffset, 0);
+        mapped = std::exchange(other.mapped, false);
+        buffer = std::move(other.buffer);
+    }
+    return *this;
+}
+
+/**
+ * Unmaps the file.
+ */
+inline SequenceView::~SequenceView() {
+    close();
+}
+
+/**
+ * Maps the file read-only, or reads it into buffer without mmap.
+ *
+ * @param path File to open.
+ * @throws std::runtime_error if the file cannot be opened or mapped.
+ */
+inline void SequenceView::open(const std::string &path) {
+#if SEQUENCE_VIEW_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not read " + path);
+    }
+    fileBytes = static_cast<size_t>(info.st_size);
+    if (fileBytes == 0) {
+        ::close(fd);
+        return; // rejected by validate
+    }
+    void *mapping = ::mmap(nullptr, fileBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not map " + path);
+    }
+    bytes = static_cast<const char *>(mapping);
+    mapped = true;
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    bytes = buffer.data();
+    fileBytes = buffer.size();
+#endif
+}
+
+/**
+ * Checks the header, the trailer and that the index fits in the file.
+ * Records are checked as they are looked up.
+ *
+ * @throws std::runtime_error if the file was not written by save.
+ */
+inline void SequenceView::validate() {
+    constexpr size_t WORD = SequenceFormat::WORD_BYTES;
+    if (fileBytes < SequenceFormat::HEADER_BYTES + SequenceFormat::TRAILER_BYTES
+        || std::memcmp(bytes, SequenceFormat::MAGIC, WORD) != 0
+        || std::memcmp(bytes + fileBytes - WORD, SequenceFormat::INDEX_MAGIC, WORD) != 0) {
+        throw std::runtime_error("Not a sequence file");
+    }
+
+    const std::uint64_t elements = SequenceFormat::getWord(bytes + WORD);
+    const std::uint64_t index = SequenceFormat::getWord(bytes + fileBytes - SequenceFormat::TRAILER_BYTES);
+    const std::uint64_t indexEnd = fileBytes - SequenceFormat::TRAILER_BYTES;
+    if (index < SequenceFormat::HEADER_BYTES || index > indexEnd || (indexEnd - index) / WORD != elements
+        || (indexEnd - index) % WORD != 0) {
+        throw std::runtime_error("Sequence file index is damaged");
+    }
+    count = static_cast<size_t>(elements);
+    indexOffset = static_cast<size_t>(index);
+}
+
+/**
+ * Releases the mapping or buffer.
+ */
+inline void SequenceView::close() {
+#if SEQUENCE_VIEW_MMAP
+    if (mapped) {
+        ::munmap(const_cast<char *>(bytes), fileBytes);
+    }
+#endif
+    buffer.clear();
+    bytes = nullptr;
+    mapped = false;
+}
+
+/**
+ * Returns the element at position without copying it. O(1): one index
+ * lookup and one length read.
+ *
+ * @param position Index of the element.
+ * @return View of the element's characters inside the file.
+ * @throws std::out_of_range if position >= size()
+ * @throws std::runtime_error if the record lies outside the file.
+ */
+inline std::string_view SequenceView::operator[](size_t position) const {
+    constexpr size_t WORD = SequenceFormat::WORD_BYTES;
+    if (position >= count) {
+        throw std::out_of_range("Position is out of range");
+    }
+
+    const std::uint64_t record = SequenceFormat::getWord(bytes + indexOffset + position * WORD);
+    if (record < SequenceFormat::HEADER_BYTES || record > indexOffset - WORD) {
+        throw std::runtime_error("Sequence file index is damaged");
+    }
+    const std::uint64_t length = SequenceFormat::getWord(bytes + record);
+    if (length > indexOffset - record - WORD) {
+        throw std::runtime_error("Sequence file index is damaged");
+    }
+    return std::string_view(bytes + record + WORD, static_cast<size_t>(length));
+}
+
+/**
+ * Returns the number of elements in the file.
+ *
+ * @return Number of elements.
+ */
+inline size_t SequenceView::size() const {
+    return count;
+}
+
+/**
+ * Checks if the file holds no elements.
+ *
+ * @return true if size() == 0.
+ */
+inline bool SequenceView::empty() const {
+    return count == 0;
+}
+
+#endif